@@ -0,0 +1,464 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Micro-benchmarks of the client library, one result per operation:
+ *
+ *   codec/encode/<command>/<encoding>   Codec::encode() of a typical packet of the command
+ *   codec/decode/<command>/<encoding>   Codec::decode() of the same frame
+ *   transport/round_trip/<encoding>     ZmqTransport::sendRequest() and waitReply() over inproc:// to an echo stub
+ *   impl/<operation>                    the operation called on ZalphaImpl directly
+ *   zalpha/<operation>                  the same operation called through the Zalpha pimpl forwarding
+ *
+ * Each result also reports the heap allocations per operation made by the calling thread through operator new,
+ * the allocations made by libzmq itself are not counted.
+ */
+
+#include <stdint.h>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <thread>
+
+#include <benchmark/benchmark.h>
+#include <zmq.hpp>
+
+#include <zalpha_api/zalpha.hpp>
+#include "impl/codec.hpp"
+#include "impl/packet.hpp"
+#include "impl/zalpha_impl.hpp"
+#include "impl/zmq_transport.hpp"
+
+using namespace zalpha_api;
+
+
+namespace
+{
+
+thread_local uint64_t allocations = 0;
+
+const char ECHO_URL[] = "inproc://zalpha_bench_echo";
+
+/**
+ * \brief A command and the payload length of its larger packet, request or reply.
+ */
+struct CommandInfo
+{
+  const char* name;
+  uint16_t command;
+  size_t payload;
+};
+
+const CommandInfo COMMANDS[] =
+{
+  { "VERSION_INFO", Packet::VERSION_INFO, 16 },
+  { "SET_ENCODING", Packet::SET_ENCODING, 2 },
+  { "TIME_SYNC", Packet::TIME_SYNC, 16 },
+  { "SET_ACCELERATION", Packet::SET_ACCELERATION, 8 },
+  { "GET_ACCELERATION", Packet::GET_ACCELERATION, 8 },
+  { "SET_TARGET_SPEED", Packet::SET_TARGET_SPEED, 8 },
+  { "GET_TARGET_SPEED", Packet::GET_TARGET_SPEED, 8 },
+  { "MOVE_STRAIGHT", Packet::MOVE_STRAIGHT, 9 },
+  { "MOVE_BEZIER", Packet::MOVE_BEZIER, 29 },
+  { "ROTATE", Packet::ROTATE, 9 },
+  { "GET_ACTION_STATUS", Packet::GET_ACTION_STATUS, 2 },
+  { "PAUSE_ACTION", Packet::PAUSE_ACTION, 2 },
+  { "RESUME_ACTION", Packet::RESUME_ACTION, 2 },
+  { "STOP_ACTION", Packet::STOP_ACTION, 2 },
+  { "RESET_ENCODER", Packet::RESET_ENCODER, 2 },
+  { "GET_ENCODER", Packet::GET_ENCODER, 32 },
+  { "GET_RAW_ENCODER", Packet::GET_RAW_ENCODER, 32 },
+  { "GET_SAFETY_FLAG", Packet::GET_SAFETY_FLAG, 32 },
+  { "GET_ENCODER_AND_SAFETY_FLAG", Packet::GET_ENCODER_AND_SAFETY_FLAG, 32 },
+  { "GET_RAW_ENCODER_AND_SAFETY_FLAG", Packet::GET_RAW_ENCODER_AND_SAFETY_FLAG, 32 },
+  { "GET_TELEMETRY", Packet::GET_TELEMETRY, Packet::MAX_PAYLOAD },
+  { "GET_BATTERY", Packet::GET_BATTERY, 4 },
+  { "SET_CHARGING", Packet::SET_CHARGING, 2 },
+  { "GET_CHARGING", Packet::GET_CHARGING, 2 },
+  { "GET_INPUTS", Packet::GET_INPUTS, 32 },
+  { "SET_OUTPUTS", Packet::SET_OUTPUTS, 8 },
+  { "GET_OUTPUTS", Packet::GET_OUTPUTS, 4 },
+};
+
+const char* encodingName(int encoding)
+{
+  return (encoding == Codec::COMPACT) ? "compact" : "fixed";
+}
+
+Packet makePacket(const CommandInfo& info)
+{
+  Packet packet;
+  packet.command = info.command;
+  packet.reserved[0] = 1;
+  for (size_t i = 0; i < info.payload; i++)
+  {
+    packet.data.u8[i] = (uint8_t) (i + 1);
+  }
+  return packet;
+}
+
+/**
+ * \brief Report the heap allocations per iteration, counted since start.
+ */
+void reportAllocations(benchmark::State& state, uint64_t start)
+{
+  state.counters["allocs"] = benchmark::Counter((double) (allocations - start), benchmark::Counter::kAvgIterations);
+}
+
+/**
+ * \brief An API server stub that sends every request back as its reply.
+ */
+class EchoServer
+{
+public:
+  EchoServer() :
+    socket_(ZmqTransport::inprocContext(), ZMQ_REP), running_(true)
+  {
+    int timeout = 100;
+    socket_.setsockopt(ZMQ_RCVTIMEO, &timeout, sizeof(timeout));
+    socket_.bind(ECHO_URL);
+    thread_ = std::thread(&EchoServer::run, this);
+  }
+
+  ~EchoServer()
+  {
+    running_ = false;
+    thread_.join();
+  }
+
+private:
+  void run()
+  {
+    while (running_)
+    {
+      zmq::message_t message;
+      if (socket_.recv(&message))
+      {
+        socket_.send(message);
+      }
+    }
+  }
+
+private:
+  zmq::socket_t socket_;
+  std::atomic<bool> running_;
+  std::thread thread_;
+};
+
+void BM_Encode(benchmark::State& state, const CommandInfo* info, int encoding)
+{
+  Packet packet = makePacket(*info);
+  uint8_t buffer[Codec::MAX_SIZE];
+  size_t size = 0;
+
+  uint64_t start = allocations;
+  for (auto _ : state)
+  {
+    size = Codec::encode(packet, encoding, buffer);
+    benchmark::DoNotOptimize(buffer);
+  }
+  reportAllocations(state, start);
+  state.counters["bytes"] = (double) size;
+}
+
+void BM_Decode(benchmark::State& state, const CommandInfo* info, int encoding)
+{
+  uint8_t buffer[Codec::MAX_SIZE];
+  size_t size = Codec::encode(makePacket(*info), encoding, buffer);
+  Packet packet;
+
+  uint64_t start = allocations;
+  for (auto _ : state)
+  {
+    bool valid = Codec::decode(buffer, size, packet);
+    benchmark::DoNotOptimize(valid);
+    benchmark::DoNotOptimize(packet);
+  }
+  reportAllocations(state, start);
+}
+
+void BM_RoundTrip(benchmark::State& state, int encoding)
+{
+  ZmqTransport transport;
+  transport.setEncoding(encoding);
+  transport.setTimeout(1000);
+  if (!transport.connect(ECHO_URL))
+  {
+    state.SkipWithError("Failed to connect to the echo stub.");
+    return;
+  }
+
+  Packet request = makePacket(COMMANDS[15]);  // GET_ENCODER
+  Packet reply;
+
+  uint64_t start = allocations;
+  for (auto _ : state)
+  {
+    request.reserved[0]++;
+    if (!transport.sendRequest(request) || !transport.waitReply(reply))
+    {
+      state.SkipWithError("Round trip to the echo stub failed.");
+      break;
+    }
+  }
+  reportAllocations(state, start);
+}
+
+template <class T>
+bool connectClient(benchmark::State& state, T& client)
+{
+  if (!client.connect(ECHO_URL))
+  {
+    state.SkipWithError("Failed to connect to the echo stub.");
+    return false;
+  }
+  return true;
+}
+
+template <class T>
+void BM_GetEncoder(benchmark::State& state)
+{
+  T client;
+  if (!connectClient(state, client)) return;
+
+  double left_distance, right_distance;
+  int64_t timestamp;
+
+  uint64_t start = allocations;
+  for (auto _ : state)
+  {
+    if (!client.getEncoder(left_distance, right_distance, timestamp))
+    {
+      state.SkipWithError("GET_ENCODER to the echo stub failed.");
+      break;
+    }
+  }
+  reportAllocations(state, start);
+}
+
+template <class T>
+void BM_SetTargetSpeed(benchmark::State& state)
+{
+  T client;
+  if (!connectClient(state, client)) return;
+
+  uint64_t start = allocations;
+  for (auto _ : state)
+  {
+    // the echoed request is not a RESULT_OK reply, only the round trip is measured
+    bool success = client.setTargetSpeed(0.5f, 0.5f);
+    benchmark::DoNotOptimize(success);
+  }
+  reportAllocations(state, start);
+}
+
+template <class T>
+void BM_GetTrafficCounters(benchmark::State& state)
+{
+  T client;
+  if (!connectClient(state, client)) return;
+
+  uint64_t bytes_sent, bytes_received;
+
+  uint64_t start = allocations;
+  for (auto _ : state)
+  {
+    client.getTrafficCounters(bytes_sent, bytes_received);
+    benchmark::DoNotOptimize(bytes_sent);
+    benchmark::DoNotOptimize(bytes_received);
+  }
+  reportAllocations(state, start);
+}
+
+template <class T>
+void BM_GetErrorMessage(benchmark::State& state)
+{
+  T client;
+  if (!connectClient(state, client)) return;
+
+  uint64_t start = allocations;
+  for (auto _ : state)
+  {
+    std::string message = client.getErrorMessage();
+    benchmark::DoNotOptimize(message);
+  }
+  reportAllocations(state, start);
+}
+
+void registerBenchmarks()
+{
+  const int encodings[] = { Codec::FIXED, Codec::COMPACT };
+
+  for (const CommandInfo& info : COMMANDS)
+  {
+    for (int encoding : encodings)
+    {
+      std::string suffix = std::string(info.name) + "/" + encodingName(encoding);
+      benchmark::RegisterBenchmark(("codec/encode/" + suffix).c_str(), BM_Encode, &info, encoding);
+      benchmark::RegisterBenchmark(("codec/decode/" + suffix).c_str(), BM_Decode, &info, encoding);
+    }
+  }
+  for (int encoding : encodings)
+  {
+    benchmark::RegisterBenchmark((std::string("transport/round_trip/") + encodingName(encoding)).c_str(),
+                                 BM_RoundTrip, encoding);
+  }
+
+  benchmark::RegisterBenchmark("impl/getEncoder", BM_GetEncoder<ZalphaImpl>);
+  benchmark::RegisterBenchmark("zalpha/getEncoder", BM_GetEncoder<Zalpha>);
+  benchmark::RegisterBenchmark("impl/setTargetSpeed", BM_SetTargetSpeed<ZalphaImpl>);
+  benchmark::RegisterBenchmark("zalpha/setTargetSpeed", BM_SetTargetSpeed<Zalpha>);
+  benchmark::RegisterBenchmark("impl/getTrafficCounters", BM_GetTrafficCounters<ZalphaImpl>);
+  benchmark::RegisterBenchmark("zalpha/getTrafficCounters", BM_GetTrafficCounters<Zalpha>);
+  benchmark::RegisterBenchmark("impl/getErrorMessage", BM_GetErrorMessage<ZalphaImpl>);
+  benchmark::RegisterBenchmark("zalpha/getErrorMessage", BM_GetErrorMessage<Zalpha>);
+}
+
+/**
+ * \brief Makes and counts the allocations of all the forms of operator new, freed by freeCounted().
+ */
+void* allocateCounted(size_t size, size_t alignment = 0) noexcept
+{
+  allocations++;
+  if (size == 0) size = 1;
+#ifndef _WINDOWS
+  if (alignment > sizeof(void*))
+  {
+    void* p = nullptr;
+    return posix_memalign(&p, alignment, size) == 0 ? p : nullptr;
+  }
+#else
+  (void) alignment;
+#endif
+  return std::malloc(size);
+}
+
+void freeCounted(void* p) noexcept
+{
+  std::free(p);
+}
+
+void* allocateCountedOrThrow(size_t size, size_t alignment = 0)
+{
+  void* p = allocateCounted(size, alignment);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+
+}  // namespace
+
+
+void* operator new(size_t size)
+{
+  return allocateCountedOrThrow(size);
+}
+void* operator new[](size_t size)
+{
+  return allocateCountedOrThrow(size);
+}
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+  return allocateCounted(size);
+}
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+  return allocateCounted(size);
+}
+
+void operator delete(void* p) noexcept
+{
+  freeCounted(p);
+}
+void operator delete[](void* p) noexcept
+{
+  freeCounted(p);
+}
+void operator delete(void* p, const std::nothrow_t&) noexcept
+{
+  freeCounted(p);
+}
+void operator delete[](void* p, const std::nothrow_t&) noexcept
+{
+  freeCounted(p);
+}
+
+#ifdef __cpp_sized_deallocation
+void operator delete(void* p, size_t) noexcept
+{
+  freeCounted(p);
+}
+void operator delete[](void* p, size_t) noexcept
+{
+  freeCounted(p);
+}
+#endif
+
+// the Windows CRT frees the aligned allocations with _aligned_free(), they are left to the default forms there
+#if defined(__cpp_aligned_new) && !defined(_WINDOWS)
+void* operator new(size_t size, std::align_val_t alignment)
+{
+  return allocateCountedOrThrow(size, (size_t) alignment);
+}
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+  return allocateCountedOrThrow(size, (size_t) alignment);
+}
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+  return allocateCounted(size, (size_t) alignment);
+}
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+  return allocateCounted(size, (size_t) alignment);
+}
+void operator delete(void* p, std::align_val_t) noexcept
+{
+  freeCounted(p);
+}
+void operator delete[](void* p, std::align_val_t) noexcept
+{
+  freeCounted(p);
+}
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept
+{
+  freeCounted(p);
+}
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept
+{
+  freeCounted(p);
+}
+void operator delete(void* p, size_t, std::align_val_t) noexcept
+{
+  freeCounted(p);
+}
+void operator delete[](void* p, size_t, std::align_val_t) noexcept
+{
+  freeCounted(p);
+}
+#endif
+
+int main(int argc, char** argv)
+{
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+
+  EchoServer echo_server;
+  registerBenchmarks();
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
@@ -0,0 +1,362 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/*
+ * Throughput of the client library as caller threads and robots are added, against zalpha_fleet_server:
+ *
+ *   zalpha_fleet_server -n 16 -p 20000 &
+ *   zalpha_scaling -r 1,4,16 -c 1,2,4 -m read,write,mixed > scaling.csv
+ *
+ * Each configuration connects a Zalpha object to each of <robots> simulated robots, and calls the commands of the
+ * mix from <threads> threads per robot for the given duration, after a warm-up. A CSV line is written per
+ * configuration, with the throughput, the CPU time and context switches of this process per command, and the
+ * latency percentiles of the commands. The fleet server runs in a process of its own, its CPU time is not counted.
+ *
+ * The commands other than the reads must be called from one thread at a time, so the threads of a robot take
+ * turns for them, as an application sharing a Zalpha object would.
+ */
+
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include <zalpha_api/zalpha.hpp>
+
+using zalpha_api::Zalpha;
+
+
+namespace
+{
+
+enum Phase
+{
+  WARM_UP,
+  MEASURE,
+  DONE,
+};
+
+enum Mix
+{
+  MIX_READ,    // getEncoder()
+  MIX_WRITE,   // setTargetSpeed()
+  MIX_MIXED,   // getEncoder(), getSafetyFlag(), setTargetSpeed() and getInputs() in turn
+};
+
+const char* const MIX_NAMES[] = { "read", "write", "mixed" };
+
+struct Robot
+{
+  Zalpha agv;
+  std::mutex write_mutex;  // the commands other than the reads are called from one thread at a time
+};
+
+struct Caller
+{
+  Robot* robot;
+  uint64_t ops;
+  uint64_t errors;
+  std::vector<int32_t> latencies;  // in us, of the commands measured
+};
+
+struct Usage
+{
+  double cpu;              // in s, user and system
+  long context_switches;   // voluntary and involuntary
+};
+
+Usage usage()
+{
+  struct rusage ru;
+  getrusage(RUSAGE_SELF, &ru);
+  Usage u;
+  u.cpu = ru.ru_utime.tv_sec + ru.ru_utime.tv_usec * 1e-6 + ru.ru_stime.tv_sec + ru.ru_stime.tv_usec * 1e-6;
+  u.context_switches = ru.ru_nvcsw + ru.ru_nivcsw;
+  return u;
+}
+
+int64_t nowUs()
+{
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+std::vector<int> parseList(const std::string& text)
+{
+  std::vector<int> values;
+  std::istringstream stream(text);
+  std::string item;
+  while (std::getline(stream, item, ','))
+  {
+    int value = std::atoi(item.c_str());
+    if (value > 0) values.push_back(value);
+  }
+  return values;
+}
+
+bool parseMixes(const std::string& text, std::vector<int>& mixes)
+{
+  std::istringstream stream(text);
+  std::string item;
+  while (std::getline(stream, item, ','))
+  {
+    int mix = -1;
+    for (int i = 0; i <= MIX_MIXED; i++)
+    {
+      if (item == MIX_NAMES[i]) mix = i;
+    }
+    if (mix < 0) return false;
+    mixes.push_back(mix);
+  }
+  return !mixes.empty();
+}
+
+bool call(Robot& robot, int mix, uint64_t n)
+{
+  double left_distance, right_distance;
+  uint16_t safety_flag;
+  uint32_t inputs;
+  int step = (mix == MIX_MIXED) ? (int)(n % 4) : (mix == MIX_WRITE) ? 2 : 0;
+  switch (step)
+  {
+  case 0:
+    return robot.agv.getEncoder(left_distance, right_distance);
+  case 1:
+    return robot.agv.getSafetyFlag(safety_flag);
+  case 2:
+  {
+    // a zero speed would go through the priority lane, which is measured by neither mix
+    float speed = (n & 1) ? 0.1f : 0.2f;
+    std::lock_guard<std::mutex> lock(robot.write_mutex);
+    return robot.agv.setTargetSpeed(speed, speed);
+  }
+  default:
+    return robot.agv.getInputs(inputs);
+  }
+}
+
+void run(Caller& caller, int mix, const std::atomic<int>& phase)
+{
+  for (uint64_t n = 0; ; n++)
+  {
+    int before = phase.load(std::memory_order_relaxed);
+    if (before == DONE) break;
+
+    int64_t start = nowUs();
+    bool success = call(*caller.robot, mix, n);
+    int64_t latency = nowUs() - start;
+
+    // only the commands that started and ended within the measurement count
+    if (before != MEASURE || phase.load(std::memory_order_relaxed) != MEASURE) continue;
+    caller.ops++;
+    if (!success) caller.errors++;
+    caller.latencies.push_back((int32_t) std::min(latency, (int64_t) INT32_MAX));
+  }
+}
+
+uint64_t collapsedReads(const std::vector<std::unique_ptr<Robot> >& robots)
+{
+  uint64_t collapsed = 0;
+  for (size_t i = 0; i < robots.size(); i++)
+  {
+    uint64_t shared, reused;
+    robots[i]->agv.getCollapsedReads(shared, reused);
+    collapsed += shared + reused;
+  }
+  return collapsed;
+}
+
+int32_t percentile(const std::vector<int32_t>& sorted, double p)
+{
+  if (sorted.empty()) return 0;
+  size_t index = (size_t)(p * (sorted.size() - 1) + 0.5);
+  return sorted[index];
+}
+
+}  // namespace
+
+
+int main(int argc, char** argv)
+{
+  std::string host("127.0.0.1");
+  std::string scheme("tcp");
+  int base_port = 20000;
+  std::vector<int> robot_counts, thread_counts, mixes;
+  double duration = 2.0;
+  double warm_up = 0.5;
+  int timeout = 1000;
+  bool collapse = true;
+
+  for (int i = 1; i < argc; i++)
+  {
+    std::string arg(argv[i]);
+    if (arg == "-a" && i + 1 < argc)
+    {
+      host = argv[++i];
+    }
+    else if (arg == "-p" && i + 1 < argc)
+    {
+      base_port = std::atoi(argv[++i]);
+    }
+    else if (arg == "-t" && i + 1 < argc)
+    {
+      scheme = argv[++i];
+    }
+    else if (arg == "-r" && i + 1 < argc)
+    {
+      robot_counts = parseList(argv[++i]);
+    }
+    else if (arg == "-c" && i + 1 < argc)
+    {
+      thread_counts = parseList(argv[++i]);
+    }
+    else if (arg == "-m" && i + 1 < argc)
+    {
+      if (!parseMixes(argv[++i], mixes))
+      {
+        std::cerr << "Unknown mix, expected read, write or mixed" << std::endl;
+        return 1;
+      }
+    }
+    else if (arg == "-d" && i + 1 < argc)
+    {
+      duration = std::max(0.1, std::atof(argv[++i]));
+    }
+    else if (arg == "-w" && i + 1 < argc)
+    {
+      warm_up = std::max(0.0, std::atof(argv[++i]));
+    }
+    else if (arg == "-x")
+    {
+      collapse = false;
+    }
+    else
+    {
+      std::cout << "Usage: zalpha_scaling [-a <host>] [-p <base_port>] [-t tcp|udp] [-r <robots>] [-c <threads>] [-m <mixes>]" << std::endl;
+      std::cout << "                      [-d <duration>] [-w <warm_up>] [-x]" << std::endl;
+      std::cout << "  Sweeps the robots, the threads per robot and the command mixes against zalpha_fleet_server," << std::endl;
+      std::cout << "  robot i at <scheme>://<host>:<base_port + i>, and writes a CSV line per configuration." << std::endl;
+      std::cout << "  -r  Comma-separated numbers of robots, 1,2,4,8 by default" << std::endl;
+      std::cout << "  -c  Comma-separated numbers of threads per robot, 1,2,4 by default" << std::endl;
+      std::cout << "  -m  Comma-separated command mixes among read, write and mixed, all of them by default" << std::endl;
+      std::cout << "  -d  Duration of each measurement, in s, 2 by default" << std::endl;
+      std::cout << "  -w  Warm-up before each measurement, in s, 0.5 by default" << std::endl;
+      std::cout << "  -x  Send every read on its own, instead of collapsing the identical reads in flight" << std::endl;
+      return 0;
+    }
+  }
+  if (robot_counts.empty()) robot_counts = parseList("1,2,4,8");
+  if (thread_counts.empty()) thread_counts = parseList("1,2,4");
+  if (mixes.empty()) parseMixes("read,write,mixed", mixes);
+
+  std::cout << "transport,robots,threads_per_robot,mix,ops,errors,collapsed,ops_per_s,cpu_us_per_op,"
+               "context_switches,context_switches_per_op,p50_us,p90_us,p99_us,max_us" << std::endl;
+
+  for (size_t r = 0; r < robot_counts.size(); r++)
+  {
+    int num_robots = robot_counts[r];
+    std::vector<std::unique_ptr<Robot> > robots;
+    for (int i = 0; i < num_robots; i++)
+    {
+      std::ostringstream address;
+      address << scheme << "://" << host << ":" << base_port + i;
+      robots.push_back(std::unique_ptr<Robot>(new Robot));
+      Robot& robot = *robots.back();
+      if (!robot.agv.connect(address.str()))
+      {
+        std::cerr << address.str() << ": " << robot.agv.getErrorMessage() << std::endl;
+        return 1;
+      }
+      robot.agv.setTimeout(timeout);
+      robot.agv.setReadCollapsing(collapse ? 0 : -1);
+    }
+
+    for (size_t c = 0; c < thread_counts.size(); c++)
+    {
+      for (size_t m = 0; m < mixes.size(); m++)
+      {
+        int threads_per_robot = thread_counts[c];
+        int mix = mixes[m];
+
+        std::vector<Caller> callers(num_robots * threads_per_robot);
+        std::atomic<int> phase(WARM_UP);
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < callers.size(); i++)
+        {
+          callers[i].robot = robots[i / threads_per_robot].get();
+          callers[i].ops = 0;
+          callers[i].errors = 0;
+          callers[i].latencies.reserve(1 << 16);
+        }
+        for (size_t i = 0; i < callers.size(); i++)
+        {
+          threads.push_back(std::thread(run, std::ref(callers[i]), mix, std::cref(phase)));
+        }
+
+        std::this_thread::sleep_for(std::chrono::duration<double>(warm_up));
+        uint64_t collapsed_start = collapsedReads(robots);
+        Usage start_usage = usage();
+        int64_t start = nowUs();
+        phase.store(MEASURE);
+        std::this_thread::sleep_for(std::chrono::duration<double>(duration));
+        phase.store(DONE);
+        int64_t end = nowUs();
+        Usage end_usage = usage();
+        for (size_t i = 0; i < threads.size(); i++)
+        {
+          threads[i].join();
+        }
+
+        uint64_t collapsed_end = collapsedReads(robots);
+
+        uint64_t ops = 0, errors = 0;
+        std::vector<int32_t> latencies;
+        for (size_t i = 0; i < callers.size(); i++)
+        {
+          ops += callers[i].ops;
+          errors += callers[i].errors;
+          latencies.insert(latencies.end(), callers[i].latencies.begin(), callers[i].latencies.end());
+        }
+        std::sort(latencies.begin(), latencies.end());
+
+        double elapsed = (end - start) * 1e-6;
+        long context_switches = end_usage.context_switches - start_usage.context_switches;
+        double per_op = ops ? 1.0 / ops : 0.0;
+        std::printf("%s,%d,%d,%s,%llu,%llu,%llu,%.0f,%.2f,%ld,%.3f,%d,%d,%d,%d\n",
+                    scheme.c_str(), num_robots, threads_per_robot, MIX_NAMES[mix],
+                    (unsigned long long) ops, (unsigned long long) errors,
+                    (unsigned long long) (collapsed_end - collapsed_start), ops / elapsed,
+                    (end_usage.cpu - start_usage.cpu) * 1e6 * per_op, context_switches, context_switches * per_op,
+                    percentile(latencies, 0.5), percentile(latencies, 0.9), percentile(latencies, 0.99),
+                    latencies.empty() ? 0 : latencies.back());
+        std::fflush(stdout);
+      }
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <zalpha_api/curve_fitter.hpp>
+#include <zalpha_api/zalpha.hpp>
+
+#ifdef _WINDOWS
+#include <windows.h>
+#else
+#include <unistd.h>
+#define Sleep(x) usleep((x)*1000)
+#endif
+
+
+int main(int argc, char** argv)
+{
+  if (argc < 2)
+  {
+    std::cout << "Usage: bezier_mission <waypoint_file> [<server_address> [<speed>]]" << std::endl;
+    std::cout << "  Fits moveBezier() and rotate() commands to the waypoints, one \"x y\" pair per line in m," << std::endl;
+    std::cout << "  in the frame of the AGV at the first waypoint, and prints them." << std::endl;
+    std::cout << "  The commands are sent one after the other when a server address is given." << std::endl;
+    return 0;
+  }
+
+  std::ifstream file(argv[1]);
+  if (!file)
+  {
+    std::cerr << "Cannot open " << argv[1] << std::endl;
+    return 1;
+  }
+  std::vector<zalpha_api::PathPoint> points;
+  zalpha_api::PathPoint point;
+  while (file >> point.x >> point.y)
+  {
+    points.push_back(point);
+  }
+
+  zalpha_api::CurveFitter fitter;
+  std::vector<zalpha_api::PathMotion> motions;
+  if (!fitter.fit(points, 0.0, motions))
+  {
+    std::cerr << "Failed to fit the waypoints: " << fitter.getErrorMessage() << std::endl;
+    return 1;
+  }
+  std::cout << points.size() << " waypoints fitted with " << motions.size() << " commands." << std::endl;
+  for (size_t i = 0; i < motions.size(); i++)
+  {
+    const zalpha_api::PathMotion& motion = motions[i];
+    if (motion.type == zalpha_api::CurveFitter::MT_ROTATE)
+    {
+      std::cout << "rotate " << motion.angle << std::endl;
+    }
+    else
+    {
+      std::cout << "moveBezier (" << motion.x << ", " << motion.y << ") cp1 (" << motion.cp1_x << ", "
+                << motion.cp1_y << ") cp2 (" << motion.cp2_x << ", " << motion.cp2_y << "), error "
+                << motion.error * 1000.0 << " mm" << std::endl;
+    }
+  }
+  if (argc < 3) return 0;
+
+  zalpha_api::Zalpha agv;
+  if (!agv.connect(argv[2]))
+  {
+    std::cerr << "Error connecting to API server: " << agv.getErrorMessage() << std::endl;
+    return 1;
+  }
+  float speed = (argc > 3) ? (float) std::atof(argv[3]) : 0.3f;
+  for (size_t i = 0; i < motions.size(); i++)
+  {
+    const zalpha_api::PathMotion& motion = motions[i];
+    bool success;
+    if (motion.type == zalpha_api::CurveFitter::MT_ROTATE)
+    {
+      success = agv.rotate(speed, motion.angle, 0);
+    }
+    else
+    {
+      success = agv.moveBezier(speed, motion.x, motion.y, motion.cp1_x, motion.cp1_y, motion.cp2_x, motion.cp2_y, 0);
+    }
+    if (!success)
+    {
+      std::cerr << "Command " << i << " failed: " << agv.getErrorMessage() << std::endl;
+      return 1;
+    }
+
+    // the next command is relative to the pose at the end of this one
+    uint8_t status = zalpha_api::Zalpha::AC_IN_PROGRESS;
+    while (status != zalpha_api::Zalpha::AC_COMPLETED)
+    {
+      Sleep(50);
+      if (!agv.getActionStatus(status))
+      {
+        std::cerr << "Failed to read the action status: " << agv.getErrorMessage() << std::endl;
+        return 1;
+      }
+    }
+    std::cout << "Command " << i << " completed, up to waypoint " << motion.last_point << "." << std::endl;
+  }
+  return 0;
+}
@@ -14,7 +14,10 @@
  * limitations under the License.
  */
 
+#include <iomanip>
 #include <iostream>
+#include <string>
+#include <vector>
 #include <zalpha_api/zalpha.hpp>
 
 #ifdef _WINDOWS
@@ -27,23 +30,25 @@
 const int NUM_CYCLES = 1000;
 
 
-int main(int argc, char** argv)
+bool runTest(const char* server_address, bool compact, double& elapsed_time)
 {
-  if (argc != 2)
-  {
-    std::cout << "Usage: communication_test <server_ip_address>" << std::endl;
-    return 0;
-  }
-
   zalpha_api::Zalpha agv;
-  if (!agv.connect(argv[1]))
+  if (!agv.connect(server_address))
   {
     std::cerr << "Error connecting to API server: " << agv.getErrorMessage() << std::endl;
-    return 1;
+    return false;
+  }
+  if (compact && !agv.setWireEncoding(zalpha_api::Zalpha::WE_COMPACT))
+  {
+    std::cerr << "Failed to set compact wire encoding: " << agv.getErrorMessage() << std::endl;
+    return false;
   }
 
+  uint64_t sent_before, received_before;
+  agv.getTrafficCounters(sent_before, received_before);
+
   std::cout << "Running the commands GET_ENCODER_AND_SAFETY_FLAG and SET_TARGET_SPEED for "
-            << NUM_CYCLES << " cycles." << std::endl;
+            << NUM_CYCLES << " cycles on " << server_address << "." << std::endl;
 
   // capture start time
 #ifdef _WINDOWS
@@ -64,17 +69,16 @@ int main(int argc, char** argv)
     if (!agv.getEncoderAndSafetyFlag(distance_left, distance_right, safety_flag))
     {
       std::cerr << "Failed to read encoder and safety flag: " << agv.getErrorMessage() << std::endl;
-      return 1;
+      return false;
     }
     if (!agv.setTargetSpeed(0.0f, 0.0f))
     {
       std::cerr << "Failed to set target speed: " << agv.getErrorMessage() << std::endl;
-      return 1;
+      return false;
     }
   }
 
   // compute elapsed time
-  double elapsed_time;
 #ifdef _WINDOWS
   QueryPerformanceCounter(&t2);
   elapsed_time = (t2.QuadPart - t1.QuadPart) * 1000.0 / frequency.QuadPart;
@@ -86,5 +90,54 @@ int main(int argc, char** argv)
 
   std::cout << "Total elapsed time: " << elapsed_time << " ms." << std::endl;
   std::cout << "Average frequency: " << NUM_CYCLES * 1000.0 / elapsed_time << " Hz." << std::endl;
+
+  uint64_t sent, received;
+  agv.getTrafficCounters(sent, received);
+  sent -= sent_before;
+  received -= received_before;
+  std::cout << "Bytes per cycle: " << (double) sent / NUM_CYCLES << " sent, "
+            << (double) received / NUM_CYCLES << " received." << std::endl;
+  return true;
+}
+
+
+int main(int argc, char** argv)
+{
+  bool compact = false;
+  int first = 1;
+  if (argc > 1 && std::string(argv[1]) == "-c")
+  {
+    compact = true;
+    first = 2;
+  }
+
+  if (argc <= first)
+  {
+    std::cout << "Usage: communication_test [-c] <server_address> [<server_address> ...]" << std::endl;
+    std::cout << "  The server address is an ip address, host:port, or an endpoint URL such as" << std::endl;
+    std::cout << "  tcp://127.0.0.1:17167 or ipc:///tmp/zalpha_api. Multiple addresses are run in turn" << std::endl;
+    std::cout << "  to compare the transports." << std::endl;
+    std::cout << "  -c  Use the compact wire encoding." << std::endl;
+    return 0;
+  }
+
+  std::vector<double> elapsed_times(argc - first);
+  for (int i = first; i < argc; i++)
+  {
+    if (!runTest(argv[i], compact, elapsed_times[i - first]))
+    {
+      return 1;
+    }
+  }
+
+  if (argc - first > 1)
+  {
+    std::cout << std::endl << "Average round trip time per command:" << std::endl;
+    for (int i = first; i < argc; i++)
+    {
+      std::cout << "  " << std::left << std::setw(40) << argv[i]
+                << elapsed_times[i - first] * 1000.0 / (NUM_CYCLES * 2) << " us" << std::endl;
+    }
+  }
   return 0;
 }
@@ -0,0 +1,56 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <zalpha_api/fleet.hpp>
+
+
+int main(int argc, char** argv)
+{
+  if (argc < 2)
+  {
+    std::cout << "Usage: fleet_bringup <server_address> [<server_address> ...]" << std::endl;
+    std::cout << "  Connects to all the API servers concurrently and reports their version and round-trip time." << std::endl;
+    return 0;
+  }
+
+  std::vector<std::string> addresses(argv + 1, argv + argc);
+  std::vector<zalpha_api::RobotHandshake> report;
+  zalpha_api::Fleet fleet;
+
+  int64_t start = zalpha_api::monotonicTime();
+  size_t num_ready = fleet.bringUp(addresses, report);
+  int64_t elapsed = zalpha_api::monotonicTime() - start;
+
+  for (size_t i = 0; i < report.size(); i++)
+  {
+    std::cout << std::left << std::setw(32) << report[i].address;
+    if (!report[i].reachable)
+    {
+      std::cout << "unreachable: " << report[i].error_message << std::endl;
+      continue;
+    }
+    std::cout << std::setw(10) << report[i].version
+              << std::setw(14) << (report[i].compatible ? "compatible" : "incompatible")
+              << "handshake " << report[i].handshake_time << " us, round trip " << report[i].round_trip << " us"
+              << std::endl;
+  }
+  std::cout << num_ready << " of " << report.size() << " robots ready in " << elapsed / 1000.0 << " ms." << std::endl;
+  return 0;
+}
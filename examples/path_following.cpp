@@ -0,0 +1,80 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <zalpha_api/path_follower.hpp>
+
+
+int main(int argc, char** argv)
+{
+  if (argc < 2)
+  {
+    std::cout << "Usage: path_following <server_address> [stanley]" << std::endl;
+    std::cout << "  Follows an S-shaped spline 2 m ahead of the AGV and reports the tracking error." << std::endl;
+    std::cout << "  Pure pursuit is used unless stanley is given." << std::endl;
+    return 0;
+  }
+
+  std::vector<zalpha_api::PathPoint> points;
+  points.push_back(zalpha_api::PathPoint(0.0, 0.0));
+  points.push_back(zalpha_api::PathPoint(0.5, 0.0));
+  points.push_back(zalpha_api::PathPoint(1.0, 0.3));
+  points.push_back(zalpha_api::PathPoint(1.5, 0.0));
+  points.push_back(zalpha_api::PathPoint(2.0, 0.0));
+
+  zalpha_api::PathFollower follower;
+  if (!follower.connect(argv[1]))
+  {
+    std::cerr << "Error connecting to API server: " << follower.getErrorMessage() << std::endl;
+    return 1;
+  }
+  follower.setPath(points, true);
+  if (argc > 2 && std::strcmp(argv[2], "stanley") == 0)
+  {
+    follower.setAlgorithm(zalpha_api::PathFollower::STANLEY);
+  }
+  if (!follower.start())
+  {
+    std::cerr << "Failed to start the follower: " << follower.getErrorMessage() << std::endl;
+    return 1;
+  }
+
+  zalpha_api::FollowerStatus status;
+  double max_error = 0.0;
+  while (!follower.wait(500))
+  {
+    follower.getStatus(status);
+    max_error = std::max(max_error, std::fabs(status.cross_track_error));
+    std::cout << "Progress " << status.progress * 100.0 << " %, position (" << status.x << ", " << status.y
+              << "), cross-track error " << status.cross_track_error * 1000.0 << " mm" << std::endl;
+  }
+  follower.getStatus(status);
+  follower.stop();
+
+  if (status.state != zalpha_api::PathFollower::FINISHED)
+  {
+    std::cerr << "The follower failed: " << follower.getErrorMessage() << std::endl;
+    return 1;
+  }
+  std::cout << "Finished at (" << status.x << ", " << status.y << ") after " << status.cycles << " cycles, "
+            << status.failures << " failures, max sampled cross-track error " << max_error * 1000.0 << " mm."
+            << std::endl;
+  return 0;
+}
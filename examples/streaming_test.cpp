@@ -0,0 +1,78 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <unistd.h>
+#include <cstdlib>
+#include <iostream>
+#include <zalpha_api/velocity_streamer.hpp>
+
+
+const int NUM_SECONDS = 5;
+
+
+int main(int argc, char** argv)
+{
+  if (argc < 2)
+  {
+    std::cout << "Usage: streaming_test <server_address> [<period_us> [<priority> [<cpu>]]]" << std::endl;
+    std::cout << "  Streams a speed ramp for " << NUM_SECONDS << " s and reports the command timing." << std::endl;
+    std::cout << "  The period defaults to 10000 us. A priority of 1 - 99 runs the streaming thread" << std::endl;
+    std::cout << "  with SCHED_FIFO and locks the memory, and a cpu pins it on that CPU." << std::endl;
+    return 0;
+  }
+  int period = (argc > 2) ? std::atoi(argv[2]) : 10000;
+  int priority = (argc > 3) ? std::atoi(argv[3]) : 0;
+  int cpu = (argc > 4) ? std::atoi(argv[4]) : -1;
+
+  zalpha_api::VelocityStreamer streamer;
+  if (!streamer.connect(argv[1]))
+  {
+    std::cerr << "Error connecting to API server: " << streamer.getErrorMessage() << std::endl;
+    return 1;
+  }
+  streamer.setRealtime(priority, cpu, priority > 0);
+  if (!streamer.start(period))
+  {
+    std::cerr << "Failed to start streaming: " << streamer.getErrorMessage() << std::endl;
+    return 1;
+  }
+
+  // ramp the speed up and down, in steps much finer than the command period
+  const int steps = NUM_SECONDS * 1000;
+  for (int i = 0; i <= steps; i++)
+  {
+    float speed = 0.3f * (1.0f - std::abs(2 * i - steps) / (float) steps);
+    streamer.setTarget(speed, speed);
+    usleep(1000);
+  }
+  streamer.setTarget(0.0f, 0.0f);
+  usleep(2 * period);
+  streamer.stop();
+
+  zalpha_api::StreamerStatistics statistics;
+  streamer.getStatistics(statistics);
+  std::cout << "Commands: " << statistics.commands << ", failures: " << statistics.failures
+            << ", missed deadlines: " << statistics.missed_deadlines << "." << std::endl;
+  std::cout << "Period: mean " << statistics.mean_period << " us, jitter " << statistics.jitter
+            << " us, min " << statistics.min_period << " us, max " << statistics.max_period << " us." << std::endl;
+  std::cout << "Max lateness: " << statistics.max_lateness << " us, mean round trip: "
+            << statistics.mean_round_trip << " us." << std::endl;
+  if (statistics.failures > 0)
+  {
+    std::cout << "Last error: " << streamer.getErrorMessage() << std::endl;
+  }
+  return 0;
+}
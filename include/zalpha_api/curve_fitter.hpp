@@ -0,0 +1,147 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @file */
+#ifndef ZALPHA_API_CURVE_FITTER_HPP
+#define ZALPHA_API_CURVE_FITTER_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <zalpha_api/zalpha_api_export.h>
+#include <zalpha_api/path_follower.hpp>
+
+
+namespace zalpha_api
+{
+
+/**
+ * \brief Internal implementation class
+ */
+class ZALPHA_API_NO_EXPORT CurveFitterImpl;
+
+/**
+ * \brief One motion of a fitted path, the arguments of a Zalpha::moveBezier() or a Zalpha::rotate() command.
+ *
+ * The points are in the frame of the pose of the AGV at the start of the motion, with x forward and y to the left,
+ * so that the motions are sent one after the other as they are.
+ */
+struct ZALPHA_API_EXPORT PathMotion
+{
+  int type;         ///< The command of the motion, see CurveFitter::MotionType
+  float x;          ///< The x coordinate of the endpoint, specified in \f$m\f$
+  float y;          ///< The y coordinate of the endpoint, specified in \f$m\f$
+  float cp1_x;      ///< The x coordinate of control point 1, specified in \f$m\f$
+  float cp1_y;      ///< The y coordinate of control point 1, specified in \f$m\f$
+  float cp2_x;      ///< The x coordinate of control point 2, specified in \f$m\f$
+  float cp2_y;      ///< The y coordinate of control point 2, specified in \f$m\f$
+  float angle;      ///< The angle to rotate counter-clockwise (+ve) or clockwise (-ve), specified in \f$rad\f$
+  size_t last_point;  ///< The index of the waypoint reached at the end of the motion
+  double error;     ///< The largest distance of the waypoints covered from the curve, specified in \f$m\f$
+
+  PathMotion() :
+    type(0), x(0.0f), y(0.0f), cp1_x(0.0f), cp1_y(0.0f), cp2_x(0.0f), cp2_y(0.0f), angle(0.0f), last_point(0),
+    error(0.0)
+  {
+  }
+};
+
+/**
+ * \brief CurveFitter turns a dense list of waypoints into few moveBezier() and rotate() commands.
+ *
+ * Each command pays a round trip and the status polling until it completes, so a path is best sent as the fewest,
+ * longest curves. The fitter covers the waypoints greedily with the longest cubic Bezier curves that pass within
+ * the tolerance of every waypoint and keep their curvature within the limit. A curve starts along the heading
+ * of the AGV and ends along the path, so that the curves join smoothly.
+ *
+ * A rotation in place is inserted at the waypoints where the path turns by more than the corner angle,
+ * and where the path does not start along the heading of the AGV. Where the path turns too tightly for any curve
+ * within the curvature limit, it is cut into straight lines within the tolerance, joined by rotations in place.
+ * The turn at a waypoint and the direction of the path are measured over a few times the tolerance, so that the
+ * noise of dense waypoints is smoothed out.
+ *
+ * The waypoints are in the path frame, the frame of the pose of the AGV when the first motion starts, with x forward
+ * and y to the left. The fitter does not communicate with the API server.
+ */
+class ZALPHA_API_EXPORT CurveFitter
+{
+public:
+  /**
+   * \brief The command of a PathMotion.
+   */
+  enum MotionType
+  {
+    MT_BEZIER = 0,  ///< A Zalpha::moveBezier() command
+    MT_ROTATE = 1,  ///< A Zalpha::rotate() command
+  };
+
+public:
+  /**
+   * \brief Constructor.
+   */
+  CurveFitter();
+  /**
+   * \brief Destructor.
+   */
+  virtual ~CurveFitter();
+
+  /**
+   * \brief Set the largest distance allowed between a waypoint and the curves.
+   * @param tolerance        The tolerance, specified in \f$m\f$, 0.02 by default
+   */
+  void setTolerance(double tolerance);
+  /**
+   * \brief Set the smallest radius of curvature allowed along the curves.
+   * @param radius           The minimum radius, specified in \f$m\f$, 0.1 by default, or 0 for no limit
+   */
+  void setMinRadius(double radius);
+  /**
+   * \brief Set the turn of the path at a waypoint above which the AGV rotates in place instead of curving.
+   * @param angle            The corner angle, specified in \f$rad\f$, \f$\pi/4\f$ by default
+   */
+  void setCornerAngle(double angle);
+
+  /**
+   * \brief Fit the motions that drive the AGV through the waypoints.
+   * @param points           The waypoints, at least two distinct ones, the first one being the position of the AGV
+   * @param heading          The heading of the AGV at the first waypoint, counter-clockwise from the x axis,
+   *                         specified in \f$rad\f$
+   * @param motions          The variable to store the motions, in order
+   * @return                 A boolean indicating whether the operation is successful
+   */
+  bool fit(const std::vector<PathPoint>& points, double heading, std::vector<PathMotion>& motions);
+
+  /**
+   * \brief Get the error code of the last failed operation.
+   * @return                 The error code
+   */
+  int getError();
+  /**
+   * \brief Get the error message of the last failed operation.
+   * @return                 The error message
+   */
+  std::string getErrorMessage();
+
+private:
+  std::auto_ptr<CurveFitterImpl> pimpl_;
+};
+
+}  // namespace zalpha_api
+
+#endif  // ZALPHA_API_CURVE_FITTER_HPP
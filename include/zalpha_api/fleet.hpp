@@ -0,0 +1,218 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @file */
+#ifndef ZALPHA_API_FLEET_HPP
+#define ZALPHA_API_FLEET_HPP
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <zalpha_api/zalpha_api_export.h>
+#include <zalpha_api/zalpha.hpp>
+
+
+namespace zalpha_api
+{
+
+/**
+ * \brief Internal implementation class
+ */
+class ZALPHA_API_NO_EXPORT FleetImpl;
+
+/**
+ * \brief The outcome of the handshake with one robot of a Fleet.
+ */
+struct ZALPHA_API_EXPORT RobotHandshake
+{
+  std::string address;        ///< The address of the API server
+  bool reachable;             ///< Whether the API server answered the handshake
+  bool compatible;            ///< Whether the API server version is compatible, see versionCompatible()
+  std::string version;        ///< The version string of the API server
+  int64_t handshake_time;     ///< The time of the first round trip, including the connection setup, in \f$\mu s\f$
+  int64_t round_trip;         ///< The shortest round trip of the probes after the handshake, in \f$\mu s\f$
+  int error;                  ///< The error code when the robot is not reachable
+  std::string error_message;  ///< The error message when the robot is not reachable
+
+  RobotHandshake() :
+    reachable(false), compatible(false), handshake_time(0), round_trip(0), error(0)
+  {
+  }
+};
+
+/**
+ * \brief The acknowledgement of a broadcast command by one robot of a Fleet.
+ */
+struct ZALPHA_API_EXPORT BroadcastAck
+{
+  bool selected;              ///< Whether the command was sent to the robot
+  bool acknowledged;          ///< Whether the robot accepted the command before the deadline
+  int64_t latency;            ///< The time from the first request of the broadcast to the reply, in \f$\mu s\f$
+  int error;                  ///< The error code when the robot did not accept the command
+  std::string error_message;  ///< The error message when the robot did not accept the command
+
+  BroadcastAck() :
+    selected(false), acknowledged(false), latency(0), error(0)
+  {
+  }
+};
+
+/**
+ * \brief The outcome of a broadcast command of a Fleet.
+ */
+struct ZALPHA_API_EXPORT BroadcastReport
+{
+  std::vector<BroadcastAck> acks;  ///< The acknowledgement of each robot, in the order of the robots
+  size_t num_selected;             ///< The number of robots the command was sent to
+  size_t num_acknowledged;         ///< The number of robots that accepted the command
+  int64_t fan_out;                 ///< The time from the first request to the last one, in \f$\mu s\f$
+  int64_t first_ack;               ///< The latency of the first acknowledgement, in \f$\mu s\f$
+  int64_t last_ack;                ///< The latency of the last acknowledgement, in \f$\mu s\f$
+  int64_t spread;                  ///< The time between the first and the last acknowledgement, in \f$\mu s\f$
+
+  BroadcastReport() :
+    num_selected(0), num_acknowledged(0), fan_out(0), first_ack(0), last_ack(0), spread(0)
+  {
+  }
+};
+
+/**
+ * \brief Fleet brings up the connections to many robots at once.
+ *
+ * Zalpha::connect() does not exchange any packet, the ZeroMQ connections are made in the background,
+ * so a robot is only known to be reachable after a first command. bringUp() connects to all the robots
+ * concurrently, with a bounded number of handshakes in flight, and performs an eager handshake with each of them:
+ * a VERSION_INFO command with a timeout, followed by a few probes to measure the round-trip time.
+ * An unreachable robot then costs one timeout, in parallel with the others.
+ *
+ * The robots are kept in the order of the addresses, including the unreachable ones, which stay disconnected.
+ *
+ * The broadcast commands reach many robots at once, for eg: to stop them when a zone alarm fires. Each ready robot
+ * has a broadcast lane of its own, separate from the connection of robot(), so that a broadcast never waits behind
+ * a command in flight. The command is built once and sent to all the selected robots without waiting, then the
+ * replies are collected from all the lanes at once until the deadline, which bounds the skew between the robots to
+ * the time it takes to send the requests. The broadcast commands must be called from one thread at a time.
+ *
+ * This class is available on POSIX systems.
+ */
+class ZALPHA_API_EXPORT Fleet
+{
+public:
+  enum
+  {
+    DEFAULT_PARALLELISM = 32,  ///< Number of handshakes in flight
+    DEFAULT_TIMEOUT = 1000,    ///< Timeout of the handshake, in ms
+    DEFAULT_PROBES = 3,        ///< Number of round-trip probes after the handshake
+    DEFAULT_DEADLINE = 200,    ///< Deadline of the broadcast commands, in ms
+  };
+
+public:
+  /**
+   * \brief Constructor.
+   */
+  Fleet();
+  /**
+   * \brief Destructor, disconnects from all the robots.
+   */
+  virtual ~Fleet();
+
+  /**
+   * \brief Connect to the robots and perform the handshakes.
+   *
+   * The robots of a previous bring-up are disconnected first. The timeout stays set on the robots,
+   * without retries, see Zalpha::setTimeout().
+   *
+   * @param addresses        The addresses of the API servers, in any form accepted by Zalpha::connect()
+   * @param report           The variable to store the outcome of the handshake with each robot, in the same order
+   * @param parallelism      The maximum number of handshakes in flight
+   * @param timeout          The timeout of the commands, specified in ms
+   * @param probes           The number of round-trip probes after the handshake
+   * @return                 The number of robots that are reachable and compatible
+   */
+  size_t bringUp(const std::vector<std::string>& addresses, std::vector<RobotHandshake>& report,
+                 int parallelism = DEFAULT_PARALLELISM, int timeout = DEFAULT_TIMEOUT, int probes = DEFAULT_PROBES);
+  /**
+   * \brief Disconnect from all the robots.
+   */
+  void disconnect();
+
+  /**
+   * \brief Get the number of robots, reachable or not.
+   * @return                 The number of robots
+   */
+  size_t size() const;
+  /**
+   * \brief Get a robot.
+   * @param index            The index of the robot, in the order of the addresses given to bringUp()
+   * @return                 The robot, which is disconnected when it was not reachable
+   */
+  Zalpha& robot(size_t index);
+  /**
+   * \brief Check whether a robot is reachable and compatible.
+   * @param index            The index of the robot, in the order of the addresses given to bringUp()
+   * @return                 A boolean indicating whether the robot passed the handshake
+   */
+  bool isReady(size_t index) const;
+
+  /**
+   * \brief Stop the current action of the robots, see Zalpha::stopAction().
+   * @param report           The variable to store the acknowledgement of each robot
+   * @param selection        The indices of the robots to send the command to, or all the ready robots when empty
+   * @param deadline         The time to wait for the acknowledgements, specified in ms
+   * @return                 The number of robots that accepted the command
+   */
+  size_t broadcastStopAction(BroadcastReport& report, const std::vector<size_t>& selection = std::vector<size_t>(),
+                             int deadline = DEFAULT_DEADLINE);
+  /**
+   * \brief Pause the current action of the robots, see Zalpha::pauseAction().
+   * @param report           The variable to store the acknowledgement of each robot
+   * @param selection        The indices of the robots to send the command to, or all the ready robots when empty
+   * @param deadline         The time to wait for the acknowledgements, specified in ms
+   * @return                 The number of robots that accepted the command
+   */
+  size_t broadcastPauseAction(BroadcastReport& report, const std::vector<size_t>& selection = std::vector<size_t>(),
+                              int deadline = DEFAULT_DEADLINE);
+  /**
+   * \brief Resume the paused action of the robots, see Zalpha::resumeAction().
+   * @param report           The variable to store the acknowledgement of each robot
+   * @param selection        The indices of the robots to send the command to, or all the ready robots when empty
+   * @param deadline         The time to wait for the acknowledgements, specified in ms
+   * @return                 The number of robots that accepted the command
+   */
+  size_t broadcastResumeAction(BroadcastReport& report, const std::vector<size_t>& selection = std::vector<size_t>(),
+                               int deadline = DEFAULT_DEADLINE);
+  /**
+   * \brief Set the digital outputs of the robots, see Zalpha::setOutputs().
+   * @param outputs          The output values, one bit per output
+   * @param mask             The outputs to change, one bit per output
+   * @param report           The variable to store the acknowledgement of each robot
+   * @param selection        The indices of the robots to send the command to, or all the ready robots when empty
+   * @param deadline         The time to wait for the acknowledgements, specified in ms
+   * @return                 The number of robots that accepted the command
+   */
+  size_t broadcastSetOutputs(uint32_t outputs, uint32_t mask, BroadcastReport& report,
+                             const std::vector<size_t>& selection = std::vector<size_t>(),
+                             int deadline = DEFAULT_DEADLINE);
+
+private:
+  std::auto_ptr<FleetImpl> pimpl_;
+};
+
+}  // namespace zalpha_api
+
+#endif  // ZALPHA_API_FLEET_HPP
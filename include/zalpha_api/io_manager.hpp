@@ -0,0 +1,178 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @file */
+#ifndef ZALPHA_API_IO_MANAGER_HPP
+#define ZALPHA_API_IO_MANAGER_HPP
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+
+#include <zalpha_api/zalpha_api_export.h>
+
+
+namespace zalpha_api
+{
+
+/**
+ * \brief Internal implementation class
+ */
+class ZALPHA_API_NO_EXPORT IoManagerImpl;
+
+/**
+ * \brief A change of the inputs, detected by an IoManager.
+ */
+struct ZALPHA_API_EXPORT InputEvent
+{
+  uint32_t rising;    ///< The inputs that changed from 0 to 1
+  uint32_t falling;   ///< The inputs that changed from 1 to 0
+  uint32_t inputs;    ///< The state of all the inputs after the change
+  int64_t timestamp;  ///< The capture time of the reading that showed the change, in the host monotonic clock, in \f$\mu s\f$
+};
+
+/**
+ * \brief The counters of an IoManager.
+ */
+struct ZALPHA_API_EXPORT IoStatistics
+{
+  uint64_t writes;    ///< Number of output writes
+  uint64_t flushes;   ///< Number of SET_OUTPUTS commands sent
+  uint64_t polls;     ///< Number of GET_INPUTS commands sent
+  uint64_t events;    ///< Number of input events detected
+  uint64_t failures;  ///< Number of commands that failed or timed out
+};
+
+/**
+ * \brief IoManager shares the digital I/O of the AGV between the threads of a client.
+ *
+ * The output writes of all the threads are merged bit by bit, and the bits written during a flush window are sent
+ * as one masked SET_OUTPUTS command, so that each subsystem updates its own outputs without a round trip and without
+ * overwriting the outputs of the others. The window opens with the first write after a flush.
+ *
+ * The inputs are polled at a fixed interval, and their rising and falling edges are delivered to the threads waiting
+ * in waitInputEvent(), stamped with the capture time of the reading that showed them. The resolution of the edges
+ * is the poll interval.
+ *
+ * The manager has its own connection to the API server. This class is available on POSIX systems.
+ *
+ * @sa Zalpha::getInputs(), Zalpha::setOutputs()
+ */
+class ZALPHA_API_EXPORT IoManager
+{
+public:
+  /**
+   * \brief Constructor.
+   */
+  IoManager();
+  /**
+   * \brief Destructor, stops the I/O thread.
+   */
+  virtual ~IoManager();
+
+  /**
+   * \brief Connect to the API server and start the I/O thread.
+   * @param server_address   The address of the API server, in any form accepted by Zalpha::connect()
+   * @return                 A boolean indicating whether the operation is successful
+   */
+  bool connect(const std::string& server_address);
+  /**
+   * \brief Stop the I/O thread and disconnect from the API server.
+   *
+   * The pending writes are discarded and the waiting threads are woken up.
+   */
+  void disconnect();
+  /**
+   * \brief Set the timeout of the commands.
+   * @param timeout          The timeout, specified in ms, 500 ms by default
+   */
+  void setTimeout(int timeout);
+  /**
+   * \brief Set the time during which the output writes are merged before they are sent.
+   * @param window           The flush window, specified in ms, 2 ms by default, or 0 to send the writes right away
+   */
+  void setFlushWindow(int window);
+  /**
+   * \brief Set the interval at which the inputs are polled.
+   * @param interval         The poll interval, specified in ms, 10 ms by default, or 0 to stop polling
+   */
+  void setPollInterval(int interval);
+
+  /**
+   * \brief Write some outputs.
+   *
+   * This function does not wait for the network. A later write of the same output in the same flush window
+   * replaces the earlier one.
+   *
+   * @param outputs          The output states, bit 0 - 15 represent output 1 - 16
+   * @param mask             The outputs to write
+   */
+  void writeOutputs(uint32_t outputs, uint32_t mask);
+  /**
+   * \brief Wait until the pending writes have been sent.
+   * @param timeout          The maximum time to wait, specified in ms, or -1 to wait indefinitely
+   * @return                 A boolean indicating whether the writes have been sent successfully
+   */
+  bool flush(int timeout = -1);
+
+  /**
+   * \brief Read the inputs of the last poll, without a round trip.
+   * @param inputs           The variable to store the inputs, see Zalpha::getInputs()
+   * @param timestamp        The variable to store the capture time in the host monotonic clock, specified in \f$\mu s\f$
+   * @return                 A boolean indicating whether the inputs have been polled yet
+   */
+  bool getInputs(uint32_t& inputs, int64_t& timestamp);
+  /**
+   * \brief Wait for an edge of some inputs.
+   *
+   * Only the events detected after this function is called are considered.
+   *
+   * @param rising_mask      The inputs whose rising edge ends the wait
+   * @param falling_mask     The inputs whose falling edge ends the wait
+   * @param event            The variable to store the event
+   * @param timeout          The maximum time to wait, specified in ms, or -1 to wait indefinitely
+   * @return                 A boolean indicating whether an event occurred before the timeout
+   */
+  bool waitInputEvent(uint32_t rising_mask, uint32_t falling_mask, InputEvent& event, int timeout = -1);
+
+  /**
+   * \brief Read the counters since connect() or resetStatistics().
+   * @param statistics       The variable to store the counters
+   */
+  void getStatistics(IoStatistics& statistics);
+  /**
+   * \brief Clear the counters.
+   */
+  void resetStatistics();
+
+  /**
+   * \brief Get the error code of the last failed operation or command.
+   * @return                 The error code
+   */
+  int getError();
+  /**
+   * \brief Get the error message of the last failed operation or command.
+   * @return                 The error message
+   */
+  std::string getErrorMessage();
+
+private:
+  std::auto_ptr<IoManagerImpl> pimpl_;
+};
+
+}  // namespace zalpha_api
+
+#endif  // ZALPHA_API_IO_MANAGER_HPP
@@ -0,0 +1,218 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @file */
+#ifndef ZALPHA_API_PATH_FOLLOWER_HPP
+#define ZALPHA_API_PATH_FOLLOWER_HPP
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <zalpha_api/zalpha_api_export.h>
+
+
+namespace zalpha_api
+{
+
+/**
+ * \brief Internal implementation class
+ */
+class ZALPHA_API_NO_EXPORT PathFollowerImpl;
+
+/**
+ * \brief A point of a path, in the path frame.
+ */
+struct ZALPHA_API_EXPORT PathPoint
+{
+  double x;  ///< The x coordinate, forward from the starting pose, specified in \f$m\f$
+  double y;  ///< The y coordinate, left of the starting pose, specified in \f$m\f$
+
+  PathPoint() :
+    x(0.0), y(0.0)
+  {
+  }
+  PathPoint(double x, double y) :
+    x(x), y(y)
+  {
+  }
+};
+
+/**
+ * \brief The tracking state of a PathFollower.
+ */
+struct ZALPHA_API_EXPORT FollowerStatus
+{
+  int state;                 ///< The state of the follower, see PathFollower::State
+  double x;                  ///< The estimated x position, specified in \f$m\f$
+  double y;                  ///< The estimated y position, specified in \f$m\f$
+  double theta;              ///< The estimated heading, counter-clockwise from the x axis, specified in \f$rad\f$
+  double progress;           ///< The fraction of the path length covered, between 0 and 1
+  double distance_to_goal;   ///< The path length left to the end of the path, specified in \f$m\f$
+  double cross_track_error;  ///< The distance to the path, +ve when the AGV is left of the path, specified in \f$m\f$
+  double heading_error;      ///< The heading relative to the path tangent, specified in \f$rad\f$
+  float left_speed;          ///< The last left wheel target speed sent, specified in \f$ms^{-1}\f$
+  float right_speed;         ///< The last right wheel target speed sent, specified in \f$ms^{-1}\f$
+  uint64_t cycles;           ///< Number of control cycles since start()
+  uint64_t failures;         ///< Number of commands that failed or timed out
+};
+
+/**
+ * \brief PathFollower drives the AGV along a path with a client-side tracking controller.
+ *
+ * The path is a polyline, or a Catmull-Rom spline through the given points, in the path frame: the frame of the pose
+ * of the AGV when start() is called, with x forward and y to the left.
+ *
+ * A dedicated thread runs the controller at a fixed rate. Each cycle reads the encoders, integrates the odometry,
+ * projects the pose forward to the time the command reaches the AGV, computes the curvature with pure pursuit or
+ * Stanley, and sends the wheel speeds. The wheel speeds stay within the acceleration and deceleration limits read
+ * with Zalpha::getAcceleration(), and the AGV slows down to stop at the end of the path.
+ *
+ * The follower has its own connection to the API server. This class is available on POSIX systems.
+ */
+class ZALPHA_API_EXPORT PathFollower
+{
+public:
+  /**
+   * \brief The state of the follower.
+   */
+  enum State
+  {
+    IDLE = 0,       ///< Not started, or stopped
+    FOLLOWING = 1,  ///< Following the path
+    FINISHED = 2,   ///< Stopped at the end of the path
+    FAILED = 3,     ///< Stopped after repeated command failures, see getError()
+  };
+  /**
+   * \brief The tracking controller.
+   */
+  enum Algorithm
+  {
+    PURE_PURSUIT = 0,  ///< Steer towards the point of the path one lookahead distance ahead
+    STANLEY = 1,       ///< Steer from the heading error and the cross-track error
+  };
+  enum
+  {
+    DEFAULT_PERIOD = 20000,  ///< Period of the control cycles, in us
+    MAX_FAILURES = 5,        ///< Number of consecutive failed cycles after which the follower stops
+  };
+
+public:
+  /**
+   * \brief Constructor.
+   */
+  PathFollower();
+  /**
+   * \brief Destructor, stops the control thread.
+   */
+  virtual ~PathFollower();
+
+  /**
+   * \brief Connect to the API server.
+   * @param server_address   The address of the API server, in any form accepted by Zalpha::connect()
+   * @return                 A boolean indicating whether the operation is successful
+   */
+  bool connect(const std::string& server_address);
+  /**
+   * \brief Stop the AGV and disconnect from the API server.
+   */
+  void disconnect();
+
+  /**
+   * \brief Set the path to follow, before start().
+   * @param points           The points of the path, at least two distinct ones
+   * @param spline           Whether to follow a Catmull-Rom spline through the points instead of the polyline
+   * @return                 A boolean indicating whether the path is valid
+   */
+  bool setPath(const std::vector<PathPoint>& points, bool spline = false);
+  /**
+   * \brief Set the tracking controller, before start().
+   * @param algorithm        PURE_PURSUIT, the default, or STANLEY
+   */
+  void setAlgorithm(Algorithm algorithm);
+  /**
+   * \brief Set the cruise speed, before start().
+   * @param speed            The linear speed along the path, specified in \f$ms^{-1}\f$, 0.3 by default
+   */
+  void setSpeed(float speed);
+  /**
+   * \brief Set the lookahead distance of pure pursuit, also used by Stanley to convert its steering angle
+   *        into a curvature, before start().
+   * @param distance         The lookahead distance, specified in \f$m\f$, 0.5 by default
+   */
+  void setLookahead(double distance);
+  /**
+   * \brief Set the cross-track gain of Stanley, before start().
+   * @param gain             The gain, specified in \f$s^{-1}\f$, 1.0 by default
+   */
+  void setStanleyGain(double gain);
+  /**
+   * \brief Set the distance between the wheels of the AGV, before start().
+   * @param wheel_base       The wheel base, specified in \f$m\f$, 0.5 by default
+   */
+  void setWheelBase(double wheel_base);
+  /**
+   * \brief Set the distance to the end of the path at which the follower stops, before start().
+   * @param tolerance        The goal tolerance, specified in \f$m\f$, 0.02 by default
+   */
+  void setGoalTolerance(double tolerance);
+
+  /**
+   * \brief Start following the path from the current pose of the AGV.
+   *
+   * The acceleration limits and the encoder origin are read before the control thread starts.
+   * Each command waits for its reply for at most one period.
+   *
+   * @param period           The period of the control cycles, specified in \f$\mu s\f$
+   * @return                 A boolean indicating whether the operation is successful
+   */
+  bool start(int period = DEFAULT_PERIOD);
+  /**
+   * \brief Stop the control thread and set a zero target speed.
+   */
+  void stop();
+  /**
+   * \brief Wait until the follower stops, at the end of the path or after a failure.
+   * @param timeout          The maximum time to wait, specified in ms, or -1 to wait indefinitely
+   * @return                 A boolean indicating whether the follower stopped before the timeout
+   */
+  bool wait(int timeout = -1);
+
+  /**
+   * \brief Read the tracking state, without a round trip.
+   * @param status           The variable to store the state
+   */
+  void getStatus(FollowerStatus& status);
+
+  /**
+   * \brief Get the error code of the last failed operation or command.
+   * @return                 The error code
+   */
+  int getError();
+  /**
+   * \brief Get the error message of the last failed operation or command.
+   * @return                 The error message
+   */
+  std::string getErrorMessage();
+
+private:
+  std::auto_ptr<PathFollowerImpl> pimpl_;
+};
+
+}  // namespace zalpha_api
+
+#endif  // ZALPHA_API_PATH_FOLLOWER_HPP
@@ -0,0 +1,140 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @file */
+#ifndef ZALPHA_API_RESULT_HPP
+#define ZALPHA_API_RESULT_HPP
+
+#include <zalpha_api/zalpha_api_export.h>
+
+
+namespace zalpha_api
+{
+
+/**
+ * \brief Error codes
+ *
+ * These are the error codes returned from Zalpha::getError() and carried by a Result. A transport may also report
+ * the error number of the operating system or of ZeroMQ, which errorString() describes as a system error.
+ */
+enum ErrorCode
+{
+  EC_OK = 0,                        ///< No error
+  EC_INVALID_COMMAND = 0xF901,      ///< The API server rejected the parameters of the command
+  EC_BUSY = 0xF902,                 ///< The target is busy
+  EC_EXPIRED = 0xF903,              ///< The motion command expired before it was executed, see Zalpha::setMotionLifetime()
+  EC_INVALID_REPLY = 0xF910,        ///< The reply could not be decoded
+  EC_UNKNOWN_ERROR = 0xF911,        ///< The API server replied with an unknown result
+  EC_INVALID_ENDPOINT = 0xF912,     ///< The address of the API server is not supported
+  EC_TIMEOUT = 0xF913,              ///< The reply did not arrive within the timeout
+  EC_SYSTEM_ERROR = 0xF914,         ///< A system call failed
+  EC_CONNECTED = 0xF920,            ///< Already connected to the API server
+  EC_DISCONNECTED = 0xF921,         ///< Not connected to the API server
+};
+
+/**
+ * \brief Describe an error code.
+ * @param error              The error code, see ErrorCode
+ * @return                   A static message, which is never freed
+ */
+ZALPHA_API_EXPORT const char* errorString(int error);
+
+/**
+ * \brief Result holds either the value returned by a command, or the error code of its failure.
+ *
+ * A Result is a plain value: it does not allocate, and its message is a static string, so that the error of a
+ * command is checked without a copy and without the error shared by all the threads of a Zalpha object.
+ *
+ * ~~~{.cpp}
+ * zalpha_api::Result<zalpha_api::EncoderReading> encoder = agv.readEncoder();
+ * if (!encoder.ok())
+ * {
+ *   std::cerr << encoder.message() << std::endl;
+ * }
+ * ~~~
+ */
+template <typename T>
+class Result
+{
+public:
+  /**
+   * \brief Construct a successful result.
+   */
+  Result(const T& value) :
+    value_(value), error_(EC_OK)
+  {
+  }
+  /**
+   * \brief Construct a failed result.
+   * @param error            The error code, see ErrorCode
+   */
+  static Result failure(int error)
+  {
+    Result result;
+    result.error_ = error;
+    return result;
+  }
+
+  /**
+   * \brief Check whether the command is successful.
+   */
+  bool ok() const
+  {
+    return error_ == EC_OK;
+  }
+  /**
+   * \brief Get the value, which is default-constructed when the command failed.
+   */
+  const T& value() const
+  {
+    return value_;
+  }
+  /**
+   * \brief Get the value, or a fallback when the command failed.
+   */
+  T valueOr(const T& fallback) const
+  {
+    return ok() ? value_ : fallback;
+  }
+  /**
+   * \brief Get the error code, see ErrorCode.
+   */
+  int error() const
+  {
+    return error_;
+  }
+  /**
+   * \brief Get the static message of the error, see errorString().
+   */
+  const char* message() const
+  {
+    return errorString(error_);
+  }
+
+private:
+  Result() :
+    value_(), error_(EC_OK)
+  {
+  }
+
+private:
+  T value_;
+  int error_;
+};
+
+}  // namespace zalpha_api
+
+#endif  // ZALPHA_API_RESULT_HPP
@@ -0,0 +1,146 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @file */
+#ifndef ZALPHA_API_SETPOINT_MAILBOX_HPP
+#define ZALPHA_API_SETPOINT_MAILBOX_HPP
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+
+#include <zalpha_api/zalpha_api_export.h>
+
+
+namespace zalpha_api
+{
+
+/**
+ * \brief Internal implementation class
+ */
+class ZALPHA_API_NO_EXPORT SetpointMailboxImpl;
+
+/**
+ * \brief The counters of a SetpointMailbox.
+ */
+struct ZALPHA_API_EXPORT MailboxStatistics
+{
+  uint64_t posted;       ///< Number of setpoints posted
+  uint64_t sent;         ///< Number of commands sent, including the keep-alives
+  uint64_t superseded;   ///< Number of setpoints replaced by a newer one before they were sent
+  uint64_t unchanged;    ///< Number of setpoints not sent because they equal the last one sent
+  uint64_t keep_alives;  ///< Number of commands sent to refresh an unchanged setpoint
+  uint64_t failures;     ///< Number of commands that failed or timed out
+};
+
+/**
+ * \brief SetpointMailbox sends the newest target speed and outputs to the AGV, coalescing the older ones.
+ *
+ * The setpoints are posted into a mailbox that holds one target speed and one output state, and a sender thread
+ * sends them with SET_TARGET_SPEED and SET_OUTPUTS. A setpoint posted while a command is in flight replaces the
+ * pending one, so the AGV always receives the newest setpoint one round trip after it is posted, however fast the
+ * producers post. The post functions never wait for the network.
+ *
+ * The outputs are merged bit by bit: each post updates the bits of its mask, and the sender sends the state of
+ * all the bits posted so far with their combined mask.
+ *
+ * A setpoint equal to the last one sent is skipped, and refreshed at the keep-alive interval instead.
+ * A failed command is retried at the keep-alive interval, or after 100 ms without keep-alive.
+ *
+ * The mailbox has its own connection to the API server. This class is available on POSIX systems.
+ */
+class ZALPHA_API_EXPORT SetpointMailbox
+{
+public:
+  /**
+   * \brief Constructor.
+   */
+  SetpointMailbox();
+  /**
+   * \brief Destructor, stops the sender thread.
+   */
+  virtual ~SetpointMailbox();
+
+  /**
+   * \brief Connect to the API server and start the sender thread.
+   * @param server_address   The address of the API server, in any form accepted by Zalpha::connect()
+   * @return                 A boolean indicating whether the operation is successful
+   */
+  bool connect(const std::string& server_address);
+  /**
+   * \brief Stop the sender thread and disconnect from the API server.
+   *
+   * The pending setpoints are discarded.
+   */
+  void disconnect();
+  /**
+   * \brief Set the timeout of the commands.
+   * @param timeout          The timeout, specified in ms, 500 ms by default
+   */
+  void setTimeout(int timeout);
+  /**
+   * \brief Set the interval at which an unchanged setpoint is sent again.
+   * @param interval         The keep-alive interval, specified in ms, or 0 to send the changes only
+   */
+  void setKeepAlive(int interval);
+
+  /**
+   * \brief Post the target speed, as with Zalpha::setTargetSpeed().
+   * @param left_speed       The left wheel target speed, specified in \f$ms^{-1}\f$
+   * @param right_speed      The right wheel target speed, specified in \f$ms^{-1}\f$
+   */
+  void postTargetSpeed(float left_speed, float right_speed);
+  /**
+   * \brief Post the state of some outputs, as with Zalpha::setOutputs().
+   * @param outputs          The output states, bit 0 - 15 represent output 1 - 16
+   * @param mask             The outputs to update, the other outputs keep their posted state
+   */
+  void postOutputs(uint32_t outputs, uint32_t mask);
+  /**
+   * \brief Wait until the posted setpoints have been sent.
+   * @param timeout          The maximum time to wait, specified in ms, or -1 to wait indefinitely
+   * @return                 A boolean indicating whether all the posted setpoints have been sent successfully
+   */
+  bool flush(int timeout = -1);
+
+  /**
+   * \brief Read the counters since connect() or resetStatistics().
+   * @param statistics       The variable to store the counters
+   */
+  void getStatistics(MailboxStatistics& statistics);
+  /**
+   * \brief Clear the counters.
+   */
+  void resetStatistics();
+
+  /**
+   * \brief Get the error code of the last failed operation or command.
+   * @return                 The error code
+   */
+  int getError();
+  /**
+   * \brief Get the error message of the last failed operation or command.
+   * @return                 The error message
+   */
+  std::string getErrorMessage();
+
+private:
+  std::auto_ptr<SetpointMailboxImpl> pimpl_;
+};
+
+}  // namespace zalpha_api
+
+#endif  // ZALPHA_API_SETPOINT_MAILBOX_HPP
@@ -0,0 +1,176 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @file */
+#ifndef ZALPHA_API_VELOCITY_STREAMER_HPP
+#define ZALPHA_API_VELOCITY_STREAMER_HPP
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+
+#include <zalpha_api/zalpha_api_export.h>
+
+
+namespace zalpha_api
+{
+
+/**
+ * \brief Internal implementation class
+ */
+class ZALPHA_API_NO_EXPORT VelocityStreamerImpl;
+
+/**
+ * \brief The timing statistics of a VelocityStreamer.
+ *
+ * The period is measured between the starts of two consecutive commands, the lateness is the delay of a command
+ * after its deadline. All times are specified in \f$\mu s\f$.
+ */
+struct ZALPHA_API_EXPORT StreamerStatistics
+{
+  uint64_t commands;          ///< Number of commands sent
+  uint64_t failures;          ///< Number of commands that failed or timed out
+  uint64_t missed_deadlines;  ///< Number of deadlines skipped because a command overran its period
+  double mean_period;         ///< Mean period
+  double jitter;              ///< Standard deviation of the period
+  int64_t min_period;         ///< Shortest period
+  int64_t max_period;         ///< Longest period
+  int64_t max_lateness;       ///< Longest delay of a command after its deadline
+  double mean_round_trip;     ///< Mean round-trip time of the commands
+  int64_t period;             ///< Period in use, which changes with the link under an adaptive rate
+};
+
+/**
+ * \brief VelocityStreamer sends the target speed to the AGV at a fixed rate from a dedicated thread.
+ *
+ * The commands are sent on an absolute-deadline timer, so that the cadence does not accumulate the delays of
+ * the individual commands. When a command overruns its period, the missed deadlines are skipped rather than caught
+ * up with a burst of commands, and counted in the statistics. The thread always sends the latest setpoint given
+ * to setTarget().
+ *
+ * The streamer has its own connection to the API server, so that the calls made on a Zalpha object,
+ * from any thread, never delay a command.
+ *
+ * With an adaptive rate, the period follows the quality of the link, see setAdaptiveRate().
+ *
+ * For a steady cadence under load, the thread may run with the SCHED_FIFO real-time policy, pinned on a CPU,
+ * with the memory of the process locked to avoid page faults, see setRealtime(). These require the CAP_SYS_NICE
+ * and CAP_IPC_LOCK capabilities, or a suitable rtprio and memlock limit, on Linux.
+ *
+ * This class is available on POSIX systems.
+ */
+class ZALPHA_API_EXPORT VelocityStreamer
+{
+public:
+  /**
+   * \brief Constructor.
+   */
+  VelocityStreamer();
+  /**
+   * \brief Destructor, stops the streaming thread.
+   */
+  virtual ~VelocityStreamer();
+
+  /**
+   * \brief Connect to the API server.
+   * @param server_address   The address of the API server, in any form accepted by Zalpha::connect()
+   * @return                 A boolean indicating whether the operation is successful
+   */
+  bool connect(const std::string& server_address);
+  /**
+   * \brief Stop the streaming thread and disconnect from the API server.
+   */
+  void disconnect();
+
+  /**
+   * \brief Set the scheduling of the streaming thread, before start().
+   * @param priority         The SCHED_FIFO priority between 1 and 99, or 0 to keep the default policy
+   * @param cpu              The CPU to pin the thread on, or -1 to leave it unpinned
+   * @param lock_memory      Whether to lock the current and future memory of the process with mlockall(),
+   *                         it stays locked after stop()
+   */
+  void setRealtime(int priority, int cpu = -1, bool lock_memory = true);
+  /**
+   * \brief Adapt the period of the commands to the link against a queueing delay target, before start().
+   *
+   * After each command, the queueing delay is estimated as the smoothed round-trip time above the shortest one,
+   * see Zalpha::getLinkQuality(). While it exceeds the target, or after a failed command, the period grows by
+   * a quarter, so that a congested link is relieved quickly. Otherwise it shrinks by 1/16 per command.
+   *
+   * The period stays between the period given to start() and the longest period, and is never shorter than the
+   * smoothed round-trip time plus four times its variation, like the retransmission timeout of TCP, so that each
+   * command gets its reply before the next one. A link that is slow but not congested is thus used at the rate
+   * it can answer, rather than at the longest period.
+   *
+   * @param delay_target     The queueing delay to keep, specified in \f$\mu s\f$, or 0 for a fixed period, the default
+   * @param max_period       The longest period, specified in \f$\mu s\f$
+   */
+  void setAdaptiveRate(int delay_target, int max_period);
+  /**
+   * \brief Start the streaming thread.
+   *
+   * The first command is sent immediately, with the target speed set by setTarget(), zero by default.
+   * Each command waits for its reply for at most one period.
+   *
+   * @param period           The period of the commands, specified in \f$\mu s\f$
+   * @return                 A boolean indicating whether the operation is successful
+   */
+  bool start(int period);
+  /**
+   * \brief Stop the streaming thread.
+   *
+   * The AGV keeps the last target speed sent, set a zero target speed and wait one period before stopping
+   * the streamer to bring it to a halt.
+   */
+  void stop();
+  /**
+   * \brief Set the target speed sent by the next commands.
+   *
+   * This function does not block, and may be called from any thread.
+   *
+   * @param left_speed       The left wheel target speed, specified in \f$ms^{-1}\f$
+   * @param right_speed      The right wheel target speed, specified in \f$ms^{-1}\f$
+   */
+  void setTarget(float left_speed, float right_speed);
+
+  /**
+   * \brief Read the timing statistics since start() or resetStatistics().
+   * @param statistics       The variable to store the statistics
+   */
+  void getStatistics(StreamerStatistics& statistics);
+  /**
+   * \brief Clear the timing statistics.
+   */
+  void resetStatistics();
+
+  /**
+   * \brief Get the error code of the last failed operation, or of the last failed command of the thread.
+   * @return                 The error code
+   */
+  int getError();
+  /**
+   * \brief Get the error message of the last failed operation, or of the last failed command of the thread.
+   * @return                 The error message
+   */
+  std::string getErrorMessage();
+
+private:
+  std::auto_ptr<VelocityStreamerImpl> pimpl_;
+};
+
+}  // namespace zalpha_api
+
+#endif  // ZALPHA_API_VELOCITY_STREAMER_HPP
@@ -21,6 +21,7 @@
 #include <memory>
 #include <string>
 
+#include <zalpha_api/result.hpp>
 #include <zalpha_api/zalpha_api_export.h>
 
 
@@ -44,6 +45,132 @@ extern const char* VERSION ZALPHA_API_EXPORT;
  * @return                   A boolean indicating whether this client libary version is compatible.
  */
 bool versionCompatible(std::string api_server_version);
+/**
+ * \brief Returns the ZeroMQ context used for inproc:// endpoints.
+ *
+ * An inproc:// endpoint can only be reached from a socket created on the same context.
+ * An API server running in the same process as the client must therefore bind its ZMQ_REP socket
+ * on this context, for eg: zmq_socket(zalpha_api::inprocContext(), ZMQ_REP).
+ *
+ * @return                   The underlying handle of the ZeroMQ context, as used by the ZeroMQ C API.
+ */
+ZALPHA_API_EXPORT void* inprocContext();
+/**
+ * \brief Returns the time of the host monotonic clock.
+ *
+ * This is the clock of the timestamps returned with the readings, see Zalpha::syncClock().
+ *
+ * @return                   The monotonic time, specified in \f$\mu s\f$
+ */
+ZALPHA_API_EXPORT int64_t monotonicTime();
+
+/**
+ * \brief The quality of the link to the API server, estimated from the round trips of the commands.
+ *
+ * The smoothed round-trip time and its variation follow the retransmission timer of TCP (RFC 6298), and
+ * the percentiles are taken over the last 256 round trips. All times are specified in \f$\mu s\f$.
+ */
+struct ZALPHA_API_EXPORT LinkQuality
+{
+  uint64_t round_trips;  ///< Number of round trips measured
+  uint64_t losses;       ///< Number of requests whose reply timed out
+  double rtt;            ///< Smoothed round-trip time, an EWMA with a gain of 1/8
+  double rtt_variation;  ///< Smoothed mean deviation of the round-trip time, an EWMA with a gain of 1/4
+  double loss_rate;      ///< Smoothed fraction of the requests lost, an EWMA with a gain of 1/16
+  int64_t min;           ///< Shortest round-trip time, the delay of the link without queueing
+  int64_t p50;           ///< Median round-trip time
+  int64_t p90;           ///< 90th percentile of the round-trip time
+  int64_t p99;           ///< 99th percentile of the round-trip time
+  int64_t max;           ///< Longest round-trip time
+};
+
+/**
+ * \brief The TCP sessions of the connection to the API server, see Zalpha::getConnectionStatus().
+ *
+ * The times are in the host monotonic clock, see monotonicTime(), specified in \f$\mu s\f$, or 0 when the event
+ * has not happened since the call to Zalpha::connect().
+ */
+struct ZALPHA_API_EXPORT ConnectionStatus
+{
+  uint8_t state;               ///< The state of the connection, see Zalpha::ConnectionState
+  uint64_t connects;           ///< Number of sessions established, after their handshake
+  uint64_t reconnects;         ///< Number of sessions established after the first one
+  uint64_t disconnects;        ///< Number of sessions lost
+  uint64_t retries;            ///< Number of connection attempts that failed and are retried
+  uint64_t handshake_failures; ///< Number of sessions whose handshake failed
+  int64_t last_connect;        ///< Time of the last session established
+  int64_t last_disconnect;     ///< Time of the last session lost
+  int64_t last_retry;          ///< Time of the last connection attempt that failed
+};
+
+/**
+ * \brief The motor acceleration, returned from Zalpha::readAcceleration().
+ */
+struct ZALPHA_API_EXPORT AccelerationLimits
+{
+  float acceleration;    ///< The acceleration, specified in \f$ms^{-2}\f$
+  float deceleration;    ///< The deceleration, specified in \f$ms^{-2}\f$
+};
+
+/**
+ * \brief The target motor speed, returned from Zalpha::readTargetSpeed().
+ */
+struct ZALPHA_API_EXPORT WheelSpeeds
+{
+  float left_speed;      ///< The speed of the left motor, specified in \f$ms^{-1}\f$
+  float right_speed;     ///< The speed of the right motor, specified in \f$ms^{-1}\f$
+};
+
+/**
+ * \brief An encoder distance, returned from Zalpha::readEncoder().
+ */
+struct ZALPHA_API_EXPORT EncoderReading
+{
+  double left_distance;  ///< The left encoder distance, specified in \f$m\f$
+  double right_distance; ///< The right encoder distance, specified in \f$m\f$
+  int64_t timestamp;     ///< The capture time in the host monotonic clock, specified in \f$\mu s\f$
+};
+
+/**
+ * \brief A raw encoder count, returned from Zalpha::readRawEncoder().
+ */
+struct ZALPHA_API_EXPORT RawEncoderReading
+{
+  int64_t left_count;    ///< The left encoder count, specified in pulses
+  int64_t right_count;   ///< The right encoder count, specified in pulses
+  int64_t timestamp;     ///< The capture time in the host monotonic clock, specified in \f$\mu s\f$
+};
+
+/**
+ * \brief A safety flag, returned from Zalpha::readSafetyFlag().
+ */
+struct ZALPHA_API_EXPORT SafetyReading
+{
+  uint16_t safety_flag;  ///< The safety flag, see Zalpha::SafetyFlag
+  int64_t timestamp;     ///< The capture time in the host monotonic clock, specified in \f$\mu s\f$
+};
+
+/**
+ * \brief A sample of the telemetry stream, returned from Zalpha::readTelemetry().
+ */
+struct ZALPHA_API_EXPORT TelemetryReading
+{
+  int64_t left_count;    ///< The left encoder count, specified in pulses
+  int64_t right_count;   ///< The right encoder count, specified in pulses
+  double left_distance;  ///< The left encoder distance, specified in \f$m\f$
+  double right_distance; ///< The right encoder distance, specified in \f$m\f$
+  uint16_t safety_flag;  ///< The safety flag, see Zalpha::SafetyFlag
+  int64_t timestamp;     ///< The capture time in the host monotonic clock, specified in \f$\mu s\f$
+};
+
+/**
+ * \brief The digital inputs, returned from Zalpha::readInputs().
+ */
+struct ZALPHA_API_EXPORT InputsReading
+{
+  uint32_t inputs;       ///< The inputs, see Zalpha::getInputs()
+  int64_t timestamp;     ///< The capture time in the host monotonic clock, specified in \f$\mu s\f$
+};
 
 
 /**
@@ -53,6 +180,20 @@ class ZALPHA_API_NO_EXPORT ZalphaImpl;
 
 /**
  * \brief Zalpha is the main class that provides the interface to %Zalpha API.
+ *
+ * The halt commands, stopAction(), pauseAction() and setTargetSpeed() with a zero speed on both wheels, go through
+ * a priority lane: a connection of their own to the API server, with a short timeout, see setPriorityTimeout().
+ * They are never queued behind another command, and may be called from another thread while a command is in flight,
+ * for eg: from a safety monitor while the control thread waits for a reply.
+ *
+ * A halt command therefore overtakes the motion commands called before it, which must not be executed after it.
+ * A motion command still waiting for the connection when a halt command is called fails with EC_EXPIRED, and one
+ * already sent carries the number of halt commands called before it, so that the API server rejects it with
+ * EC_EXPIRED when it arrives after the halt command. The commands of each lane are executed in the order called.
+ *
+ * The read commands other than getTelemetry() may also be called from several threads at once. They share the
+ * connection one round trip at a time, and identical reads in flight are collapsed into one, see setReadCollapsing().
+ * The other functions must be called from one thread at a time.
  */
 class ZALPHA_API_EXPORT Zalpha
 {
@@ -70,6 +211,19 @@ public:
     AC_SAFETY_TRIGGERED = 3,   ///< Action is blocked by a safety trigger
   };
 
+  /**
+   * \brief Connection state
+   *
+   * This is the definition of the state returned from the function getConnectionStatus().
+   */
+  enum ConnectionState
+  {
+    CS_UNKNOWN = 0,            ///< The transport does not report its sessions, for eg: udp:// or inproc://
+    CS_CONNECTING = 1,         ///< The first session is being established
+    CS_CONNECTED = 2,          ///< A session is established
+    CS_DISCONNECTED = 3,       ///< The session was lost, or the connection attempts failed, and they are retried
+  };
+
   /**
    * \brief Safety flags
    *
@@ -150,6 +304,30 @@ public:
     CH_BATTERY_FULL = 0x04,        ///< Battery is fully charged
   };
 
+  /**
+   * \brief Wire encoding
+   *
+   * This is the definition of the encoding used in the function setWireEncoding().
+   */
+  enum WireEncoding
+  {
+    WE_FIXED = 0,              ///< Every packet is sent in full, 72 bytes
+    WE_COMPACT = 1,            ///< Only the bytes in use are sent, with a 4-byte header
+  };
+
+  /**
+   * \brief Reading source
+   *
+   * This is the definition of where a reading came from, returned from the bounded reads of getEncoder() and
+   * getRawEncoder().
+   */
+  enum ReadingSource
+  {
+    RS_MEASURED = 0,           ///< Read from the API server in a round trip
+    RS_CACHED = 1,             ///< The last reading, captured within the maximum age
+    RS_PREDICTED = 2,          ///< Extrapolated from the last reading to the current time
+  };
+
 public:
   /**
    *  \brief Constructor
@@ -159,14 +337,190 @@ public:
 
   /**
    * \brief Connect to API server.
-   * @param server_ip        The %Zalpha AGV's ip address, for eg: "192.168.100.1"
+   *
+   * The server address can be given in any of the following forms:
+   *
+   * <table>
+   * <tr><th>Form</th><th>Example</th><th>Transport</th></tr>
+   * <tr><td>host</td><td>"192.168.100.1"</td><td>TCP on the default port 17167</td></tr>
+   * <tr><td>host:port</td><td>"192.168.100.1:17168"</td><td>TCP on the given port</td></tr>
+   * <tr><td>tcp://host:port</td><td>"tcp://127.0.0.1:17167"</td><td>TCP</td></tr>
+   * <tr><td>ipc://path</td><td>"ipc:///tmp/zalpha_api"</td><td>Unix domain socket</td></tr>
+   * <tr><td>inproc://name</td><td>"inproc://zalpha_api"</td><td>In-process, see inprocContext()</td></tr>
+   * <tr><td>udp://host:port</td><td>"udp://192.168.100.1:17167"</td><td>One UDP datagram per packet (Linux only)</td></tr>
+   * <tr><td>shm://name</td><td>"shm://zalpha_api"</td><td>Shared memory rings in /dev/shm/zalpha-name (Linux only)</td></tr>
+   * </table>
+   *
+   * When the API server runs on the same machine, the ipc:// transport bypasses the TCP loopback stack.
+   * The shm:// transport goes further: the packets are copied through rings in a shared memory segment created by
+   * the API server, and the client busy-polls briefly for the reply before it sleeps, so that a round trip usually
+   * makes no system call at all. Each connection takes one of the 8 channels of the segment, and the priority
+   * lane takes another one.
+   *
+   * The udp:// transport avoids the head-of-line blocking of TCP on lossy links. A lost request or reply
+   * is reported as a timeout instead of being retransmitted late, see setTimeout().
+   *
+   * @param server_address   The address of the API server, for eg: "192.168.100.1"
    * @return                 A boolean indicating whether the connection is successful
    */
-  bool connect(const std::string& server_ip);
+  bool connect(const std::string& server_address);
   /**
    * \brief Disconnect from API server.
    */
   void disconnect();
+  /**
+   * \brief Set the time to wait for each reply, and the number of retries of the read commands.
+   *
+   * By default, the tcp://, ipc://, inproc:// and shm:// transports wait forever, and the udp:// transport waits 500 ms.
+   *
+   * Only the commands that read a value are retried. The commands that change the state of the AGV,
+   * such as setTargetSpeed(), are never sent twice: a late setpoint is worse than a lost one,
+   * and the next call supersedes it anyway.
+   *
+   * @param timeout          The time to wait for a reply, specified in ms. A negative value waits forever.
+   * @param retries          The number of times to resend a read command after its reply timed out
+   */
+  void setTimeout(int timeout, int retries = 0);
+  /**
+   * \brief Set the time to wait for each reply of the halt commands, and the number of retries.
+   *
+   * The halt commands are retried, since repeating them is harmless, so they take at most
+   * (retries + 1) * timeout before they succeed or fail. By default, they wait 100 ms and are retried twice.
+   *
+   * They never take longer than a positive timeout of setTimeout() though: each attempt waits at most that long,
+   * and only the attempts that fit in it are made, so that a halt command called from a control loop does not
+   * stall it longer than its other commands.
+   *
+   * @param timeout          The time to wait for a reply, specified in ms. A negative value waits forever.
+   * @param retries          The number of times to resend a halt command after its reply timed out
+   */
+  void setPriorityTimeout(int timeout, int retries = 2);
+  /**
+   * \brief Set the time after which a motion command is dropped instead of executed.
+   *
+   * The motion commands, setTargetSpeed() with a non-zero speed, moveStraight(), moveBezier(), rotate() and
+   * resumeAction(), then fail with EC_EXPIRED when they are still waiting for the connection
+   * after the lifetime. Once the clock is synchronized, see syncClock(), they also carry the deadline to the API
+   * server, which rejects them when they arrive late, for eg: when the link stalled and the queued setpoints arrive
+   * in a burst. The halt commands never expire.
+   *
+   * @param lifetime         The lifetime, specified in ms, from the call. A negative value, the default, never expires.
+   */
+  void setMotionLifetime(int lifetime);
+  /**
+   * \brief Set how the identical read commands called from several threads share their round trips.
+   *
+   * A read command called while the same read, with the same parameters, is in flight waits for that round trip
+   * instead of sending its own, and returns the same reply. With a positive age, a read also reuses the reply
+   * of a completed one whose request was sent at most that long ago, so the reply is never older than the age.
+   * A failed read is never reused, and the waiters of a failed read fail with it.
+   *
+   * getTelemetry() and syncClock() always make their own round trips.
+   *
+   * @param max_age          The age of the replies that may be reused, specified in \f$\mu s\f$. 0, the default, only
+   *                         shares the reads in flight, and a negative value sends every read on its own.
+   */
+  void setReadCollapsing(int max_age);
+  /**
+   * \brief Read the number of read commands answered without a round trip of their own since the start.
+   * @param shared           The variable to store the number of reads that waited for an identical read in flight
+   * @param reused           The variable to store the number of reads that reused a reply within the freshness window
+   */
+  void getCollapsedReads(uint64_t& shared, uint64_t& reused);
+  /**
+   * \brief Negotiate the wire encoding of the packets with the API server.
+   *
+   * Every packet has a fixed length of 72 bytes by default, though most commands use only a few of them.
+   * The compact encoding sends a 4-byte header and the payload without its trailing zero bytes,
+   * for eg: 4 bytes instead of 72 for a request without parameters.
+   *
+   * The encoding is only changed when the API server accepts it, older servers reject the request.
+   * It falls back to WE_FIXED on every connect().
+   *
+   * @param encoding         The wire encoding
+   * @return                 A boolean indicating whether the operation is successful
+   * @sa                     WireEncoding
+   */
+  bool setWireEncoding(uint8_t encoding);
+  /**
+   * \brief Read the number of bytes exchanged with the API server since connect().
+   *
+   * The counts include the packets only, and exclude the framing of ZeroMQ and the network protocols.
+   *
+   * @param bytes_sent       The variable to store the number of bytes sent
+   * @param bytes_received   The variable to store the number of bytes received
+   */
+  void getTrafficCounters(uint64_t& bytes_sent, uint64_t& bytes_received);
+  /**
+   * \brief Read the quality of the link to the API server, measured on every command since connect().
+   *
+   * A reply that times out counts as a loss, each retry being a request of its own. The commands of the
+   * priority lane are measured as well, since they cross the same link.
+   *
+   * @param quality          The variable to store the link quality
+   */
+  void getLinkQuality(LinkQuality& quality);
+  /**
+   * \brief Forget the round trips measured so far, for eg: after the AGV roamed to another access point.
+   */
+  void resetLinkQuality();
+  /**
+   * \brief Read the state of the connection to the API server, and the count of its TCP sessions.
+   *
+   * The sessions are only followed once enabled with setMonitored() or setFailFast(), the state is CS_UNKNOWN
+   * otherwise. A socket replaced after a reply timed out establishes a new session, which is counted as a
+   * reconnection.
+   *
+   * @param status           The variable to store the connection status
+   */
+  void getConnectionStatus(ConnectionStatus& status);
+  /**
+   * \brief Follow the TCP sessions of the connection, see getConnectionStatus().
+   *
+   * The tcp:// and ipc:// transports follow their sessions with zmq_socket_monitor(), so that a lost link is known
+   * as soon as the socket sees it, instead of when a command times out. This takes a thread per connection, so it
+   * is disabled by default, and takes effect with the next call to connect().
+   *
+   * @param enable           Whether to follow the sessions, false by default
+   */
+  void setMonitored(bool enable = true);
+  /**
+   * \brief Fail the commands right away while the connection is down.
+   *
+   * Once enabled, a command fails with DISCONNECTED instead of waiting for its timeout, when the session was lost
+   * and is not established again, see getConnectionStatus(). A command waiting for its reply also fails when the
+   * session is lost. The requests are only queued on established sessions (ZMQ_IMMEDIATE), so that a request is
+   * never delivered late once the link is back. The halt commands are always attempted.
+   *
+   * The sessions are followed while enabled, see setMonitored(). This only applies to the tcp:// and ipc://
+   * transports, and takes effect with the next call to connect().
+   *
+   * @param enable           Whether to fail the commands while disconnected, false by default
+   */
+  void setFailFast(bool enable = true);
+  /**
+   * \brief Estimate the offset and drift of the robot clock with round-trip probes.
+   *
+   * Each probe is an NTP-style exchange, which measures the offset of the robot clock to within half of its
+   * round-trip time. The estimate is fitted over the probes of lowest delay among the 64 most recent ones,
+   * so that the probes delayed by queueing or Wi-Fi retransmissions are ignored.
+   *
+   * Once synchronized, the timestamps returned with the readings are the capture times of the API server converted
+   * into the host monotonic clock. Otherwise, or when the API server does not stamp its readings, they are the
+   * midpoints of the round trips. Call this function again every few seconds to follow the drift of the clocks.
+   *
+   * @param probes           The number of probes to send
+   * @return                 A boolean indicating whether the operation is successful
+   * @sa                     monotonicTime()
+   */
+  bool syncClock(int probes = 8);
+  /**
+   * \brief Read the estimated offset and drift of the robot clock.
+   * @param offset           The variable to store the robot time minus the host time, specified in \f$\mu s\f$
+   * @param drift            The variable to store the drift of the robot clock, specified in ppm
+   * @return                 A boolean indicating whether the clock has been synchronized with syncClock()
+   */
+  bool getClockOffset(int64_t& offset, double& drift);
 
   /**
    * \brief Read the version string of API server.
@@ -195,6 +549,8 @@ public:
    * based on the acceleration value given in setAcceleration(),
    * until the target speed is reached.
    *
+   * A zero speed on both wheels is sent through the priority lane.
+   *
    * @param left_speed       The speed of the left motor, specified in \f$ms^{-1}\f$
    * @param right_speed      The speed of the right motor, specified in \f$ms^{-1}\f$
    * @return                 A boolean indicating whether the operation is successful
@@ -253,6 +609,7 @@ public:
    * \brief Pause the current action.
    *
    * The action refers to the straight, bezier or rotational movement.
+   * This command is sent through the priority lane.
    *
    * @return                 A boolean indicating whether the operation is successful
    */
@@ -269,6 +626,7 @@ public:
    * \brief Abort the current action.
    *
    * The action refers to the straight, bezier or rotational movement.
+   * This command is sent through the priority lane.
    *
    * @return                 A boolean indicating whether the operation is successful
    */
@@ -285,6 +643,38 @@ public:
    * @return                 A boolean indicating whether the operation is successful
    */
   bool getEncoder(double& left_distance, double& right_distance);
+  /**
+   * \brief Read the current encoder distance, with its capture time.
+   * @param left_distance    The variable to store the left encoder distance, specified in \f$m\f$
+   * @param right_distance   The variable to store the right encoder distance, specified in \f$m\f$
+   * @param timestamp        The variable to store the capture time in the host monotonic clock, specified in \f$\mu s\f$
+   * @return                 A boolean indicating whether the operation is successful
+   */
+  bool getEncoder(double& left_distance, double& right_distance, int64_t& timestamp);
+  /**
+   * \brief Read the encoder distance, without a round trip when the last reading is recent enough.
+   *
+   * The last reading of any of getEncoder(), getEncoderAndSafetyFlag() and getTelemetry() is returned as it is
+   * when it was captured at most max_age ago. Otherwise, when max_prediction is given and the last reading was
+   * captured at most max_prediction ago, it is extrapolated to the current time: the wheels hold the speed of the
+   * last two readings, then ramp towards the target speed last set with setTargetSpeed() at the acceleration limits.
+   * A single reading is extrapolated only towards a target speed. Otherwise, the encoder is read from the API server.
+   *
+   * Prediction is meant to bridge the gaps between the readings of a control loop, not to replace them: it does not
+   * know about wheel slippage or safety stops, and assumes constant speeds during actions such as moveStraight().
+   *
+   * @param left_distance    The variable to store the left encoder distance, specified in \f$m\f$
+   * @param right_distance   The variable to store the right encoder distance, specified in \f$m\f$
+   * @param timestamp        The variable to store the capture time, or the current time when predicted, in the host
+   *                         monotonic clock, specified in \f$\mu s\f$
+   * @param max_age          The maximum age of a reading returned as it is, specified in \f$\mu s\f$
+   * @param source           The variable to store where the reading came from, see ReadingSource
+   * @param max_prediction   The maximum age of a reading to extrapolate from, specified in \f$\mu s\f$, or 0 to
+   *                         never predict
+   * @return                 A boolean indicating whether the operation is successful
+   */
+  bool getEncoder(double& left_distance, double& right_distance, int64_t& timestamp, int max_age, uint8_t& source,
+                  int max_prediction = 0);
   /**
    * \brief Read the current raw encoder count
    * @param left_count       The variable to store the left encoder count, specified in pulses
@@ -292,6 +682,33 @@ public:
    * @return                 A boolean indicating whether the operation is successful
    */
   bool getRawEncoder(int64_t& left_count, int64_t& right_count);
+  /**
+   * \brief Read the current raw encoder count, with its capture time.
+   * @param left_count       The variable to store the left encoder count, specified in pulses
+   * @param right_count      The variable to store the right encoder count, specified in pulses
+   * @param timestamp        The variable to store the capture time in the host monotonic clock, specified in \f$\mu s\f$
+   * @return                 A boolean indicating whether the operation is successful
+   */
+  bool getRawEncoder(int64_t& left_count, int64_t& right_count, int64_t& timestamp);
+  /**
+   * \brief Read the raw encoder count, without a round trip when the last reading is recent enough.
+   *
+   * This is the same as the bounded read of getEncoder(), for the readings of getRawEncoder(),
+   * getRawEncoderAndSafetyFlag() and getTelemetry(). The counts only ramp towards the target speed once the counts
+   * per meter are known from a reading of getTelemetry() over at least 0.1 m, they hold their last speed until then.
+   *
+   * @param left_count       The variable to store the left encoder count, specified in pulses
+   * @param right_count      The variable to store the right encoder count, specified in pulses
+   * @param timestamp        The variable to store the capture time, or the current time when predicted, in the host
+   *                         monotonic clock, specified in \f$\mu s\f$
+   * @param max_age          The maximum age of a reading returned as it is, specified in \f$\mu s\f$
+   * @param source           The variable to store where the reading came from, see ReadingSource
+   * @param max_prediction   The maximum age of a reading to extrapolate from, specified in \f$\mu s\f$, or 0 to
+   *                         never predict
+   * @return                 A boolean indicating whether the operation is successful
+   */
+  bool getRawEncoder(int64_t& left_count, int64_t& right_count, int64_t& timestamp, int max_age, uint8_t& source,
+                     int max_prediction = 0);
   /**
    * \brief Read the safety flag
    * @param safety_flag      The variable to store the safety flag.
@@ -299,6 +716,14 @@ public:
    * @sa                     SafetyFlag
    */
   bool getSafetyFlag(uint16_t& safety_flag);
+  /**
+   * \brief Read the safety flag, with its capture time.
+   * @param safety_flag      The variable to store the safety flag.
+   * @param timestamp        The variable to store the capture time in the host monotonic clock, specified in \f$\mu s\f$
+   * @return                 A boolean indicating whether the operation is successful
+   * @sa                     SafetyFlag
+   */
+  bool getSafetyFlag(uint16_t& safety_flag, int64_t& timestamp);
   /**
    * \brief Read the encoder distance and safety flag
    * @param left_distance    The variable to store the left encoder distance, specified in \f$m\f$
@@ -308,6 +733,17 @@ public:
    * @sa                     SafetyFlag
    */
   bool getEncoderAndSafetyFlag(double& left_distance, double& right_distance, uint16_t& safety_flag);
+  /**
+   * \brief Read the encoder distance and safety flag, with its capture time.
+   * @param left_distance    The variable to store the left encoder distance, specified in \f$m\f$
+   * @param right_distance   The variable to store the right encoder distance, specified in \f$m\f$
+   * @param safety_flag      The variable to store the safety flag.
+   * @param timestamp        The variable to store the capture time in the host monotonic clock, specified in \f$\mu s\f$
+   * @return                 A boolean indicating whether the operation is successful
+   * @sa                     SafetyFlag
+   */
+  bool getEncoderAndSafetyFlag(double& left_distance, double& right_distance, uint16_t& safety_flag,
+                               int64_t& timestamp);
   /**
    * \brief Read the raw encoder count and safety flag
    * @param left_count       The variable to store the left encoder count, specified in pulses
@@ -317,6 +753,53 @@ public:
    * @sa                     SafetyFlag
    */
   bool getRawEncoderAndSafetyFlag(int64_t& left_count, int64_t& right_count, uint16_t& safety_flag);
+  /**
+   * \brief Read the raw encoder count and safety flag, with its capture time.
+   * @param left_count       The variable to store the left encoder count, specified in pulses
+   * @param right_count      The variable to store the right encoder count, specified in pulses
+   * @param safety_flag      The variable to store the safety flag.
+   * @param timestamp        The variable to store the capture time in the host monotonic clock, specified in \f$\mu s\f$
+   * @return                 A boolean indicating whether the operation is successful
+   * @sa                     SafetyFlag
+   */
+  bool getRawEncoderAndSafetyFlag(int64_t& left_count, int64_t& right_count, uint16_t& safety_flag,
+                                  int64_t& timestamp);
+  /**
+   * \brief Read the raw encoder count, encoder distance and safety flag as a telemetry stream.
+   *
+   * The API server sends a full keyframe from time to time, and in between only the fields that changed
+   * since the last keyframe received by this client, as zig-zag varint deltas.
+   * A reply is then typically a few bytes long instead of a full packet, combine it with the compact
+   * encoding of setWireEncoding() to reduce the bandwidth at a high sample rate.
+   *
+   * The encoder distances have a resolution of 1 micrometer.
+   *
+   * @param left_count       The variable to store the left encoder count, specified in pulses
+   * @param right_count      The variable to store the right encoder count, specified in pulses
+   * @param left_distance    The variable to store the left encoder distance, specified in \f$m\f$
+   * @param right_distance   The variable to store the right encoder distance, specified in \f$m\f$
+   * @param safety_flag      The variable to store the safety flag.
+   * @return                 A boolean indicating whether the operation is successful
+   * @sa                     SafetyFlag
+   */
+  bool getTelemetry(int64_t& left_count, int64_t& right_count, double& left_distance, double& right_distance,
+                    uint16_t& safety_flag);
+  /**
+   * \brief Read the raw encoder count, encoder distance and safety flag as a telemetry stream, with its capture time.
+   *
+   * This is the telemetry stream of the function above, see syncClock() for the capture time.
+   *
+   * @param left_count       The variable to store the left encoder count, specified in pulses
+   * @param right_count      The variable to store the right encoder count, specified in pulses
+   * @param left_distance    The variable to store the left encoder distance, specified in \f$m\f$
+   * @param right_distance   The variable to store the right encoder distance, specified in \f$m\f$
+   * @param safety_flag      The variable to store the safety flag.
+   * @param timestamp        The variable to store the capture time in the host monotonic clock, specified in \f$\mu s\f$
+   * @return                 A boolean indicating whether the operation is successful
+   * @sa                     SafetyFlag
+   */
+  bool getTelemetry(int64_t& left_count, int64_t& right_count, double& left_distance, double& right_distance,
+                    uint16_t& safety_flag, int64_t& timestamp);
   /**
    * \brief Read the battery percentage
    * @param battery_percentage   The variable to store the battery percentage. The value is in between 0 - 100%.
@@ -365,6 +848,13 @@ public:
    * @return                 A boolean indicating whether the operation is successful
    */
   bool getInputs(uint32_t& inputs);
+  /**
+   * \brief Read the inputs, with their capture time.
+   * @param inputs           The variable to store the inputs, see the function above.
+   * @param timestamp        The variable to store the capture time in the host monotonic clock, specified in \f$\mu s\f$
+   * @return                 A boolean indicating whether the operation is successful
+   */
+  bool getInputs(uint32_t& inputs, int64_t& timestamp);
   /**
    * \brief Set the digital outputs.
    *
@@ -416,6 +906,38 @@ public:
    */
   bool getOutputs(uint32_t& outputs);
 
+  /**
+   * \name Value-returning reads
+   *
+   * These reads return their reply, or the code of their failure, in a Result. They do not allocate, and unlike
+   * getError() their error belongs to the call, so that a read is checked safely while other threads use the same
+   * object. The detailed message of the last error is still available from getErrorMessage().
+   * @{
+   */
+  Result<AccelerationLimits> readAcceleration();
+  Result<WheelSpeeds> readTargetSpeed();
+  Result<uint8_t> readActionStatus();
+  Result<EncoderReading> readEncoder();
+  Result<RawEncoderReading> readRawEncoder();
+  Result<SafetyReading> readSafetyFlag();
+  Result<TelemetryReading> readTelemetry();
+  Result<float> readBattery();
+  Result<uint8_t> readCharging();
+  Result<InputsReading> readInputs();
+  Result<uint32_t> readOutputs();
+  /** @} */
+
+  /**
+   * \brief Get the error code of the last command made on the calling thread, of any Zalpha object.
+   *
+   * Unlike getError(), this is not overwritten by the commands of other threads, so that the error of a command
+   * returning a boolean may be checked from any thread. Each command clears it first, so that it is 0 after a
+   * command that succeeded. Use errorString() for its message.
+   *
+   * @return                 The error code, see ErrorCode, or 0 when the last command succeeded
+   */
+  static int getThreadError();
+
   /**
    * \brief Get the last error code.
    * @return                 The error code.
@@ -425,6 +947,7 @@ public:
    * \brief Get the last error message.
    *
    * Use this function to obtain a human-readable error message, instead of the error code from getError().
+   * The message is returned as a copy; errorString() gives the static message of an error code without one.
    *
    * @return                 The error message.
    */
@@ -22,19 +22,16 @@ import zalpha_api
 NUM_CYCLES = 1000
 
 
-if __name__ == '__main__':
-    if len(sys.argv) != 2:
-        print('Usage: communication_test.py <server_ip_address>')
-        sys.exit(0)
-
+def run_test(server_address):
     agv = zalpha_api.Zalpha()
     try:
-        agv.connect(sys.argv[1])
+        agv.connect(server_address)
     except Exception as ex:
         print('Error connecting to API server: %s' % ex)
         sys.exit(1)
 
-    print('Running the commands GET_ENCODER_AND_SAFETY_FLAG and SET_TARGET_SPEED for %s cycles' % NUM_CYCLES)
+    print('Running the commands GET_ENCODER_AND_SAFETY_FLAG and SET_TARGET_SPEED for %s cycles on %s' %
+          (NUM_CYCLES, server_address))
 
     # capture start time
     t1 = time.time()
@@ -59,3 +56,22 @@ if __name__ == '__main__':
 
     print('Total elapsed time: %s ms.' % elapsed_time)
     print('Average frequency: %s Hz.' % (NUM_CYCLES * 1000.0 / elapsed_time))
+    agv.disconnect()
+    return elapsed_time
+
+
+if __name__ == '__main__':
+    if len(sys.argv) < 2:
+        print('Usage: communication_test.py <server_address> [<server_address> ...]')
+        print('  The server address is an ip address, host:port, or an endpoint URL such as')
+        print('  tcp://127.0.0.1:17167 or ipc:///tmp/zalpha_api. Multiple addresses are run in turn')
+        print('  to compare the transports.')
+        sys.exit(0)
+
+    elapsed_times = [run_test(server_address) for server_address in sys.argv[1:]]
+
+    if len(sys.argv) > 2:
+        print('')
+        print('Average round trip time per command:')
+        for server_address, elapsed_time in zip(sys.argv[1:], elapsed_times):
+            print('  %-40s%s us' % (server_address, elapsed_time * 1000.0 / (NUM_CYCLES * 2)))
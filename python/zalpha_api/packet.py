@@ -42,6 +42,7 @@ class Packet(object):
     GET_SAFETY_FLAG = 0xFA30
     GET_ENCODER_AND_SAFETY_FLAG = 0xFA31
     GET_RAW_ENCODER_AND_SAFETY_FLAG = 0xFA32
+    GET_TELEMETRY = 0xFA33
     # Power
     GET_BATTERY = 0xFA40
     SET_CHARGING = 0xFA41
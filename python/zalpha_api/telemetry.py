@@ -0,0 +1,93 @@
+# -*- coding: utf-8 -*-
+# Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+from __future__ import absolute_import
+from __future__ import unicode_literals
+
+
+class TelemetryDecoder(object):
+    """
+    Reconstruct the full samples of the GET_TELEMETRY command.
+
+    A reply is either a keyframe, carrying the fields against zero, or a delta carrying the fields that
+    differ from the keyframe acknowledged in the request. The fields are the left and right encoder counts,
+    the left and right encoder distances in micrometers, the safety flag, and the capture time in microseconds
+    of the robot clock, which is 0 when the server does not stamp its readings.
+    """
+
+    KEYFRAME = 0
+    DELTA = 1
+    NUM_FIELDS = 6
+
+    def __init__(self):
+        self.reset()
+
+    def reset(self):
+        self.__has_keyframe = False
+        self.__keyframe_id = 0
+        self.__keyframe = [0] * self.NUM_FIELDS
+
+    def prepare_request(self, packet):
+        packet.u8[0] = self.__keyframe_id
+        packet.u8[1] = 1 if self.__has_keyframe else 0
+
+    def decode(self, packet):
+        """
+        Return the sample carried by a reply, or None when it cannot be reconstructed.
+        """
+        payload = bytearray(packet.data)
+        frame_type = payload[0]
+        keyframe_id = payload[1]
+
+        if frame_type == self.KEYFRAME:
+            sample = self.__decode_fields(payload[2:], [0] * self.NUM_FIELDS)
+            if sample is None:
+                return None
+            self.__keyframe = sample
+            self.__keyframe_id = keyframe_id
+            self.__has_keyframe = True
+            return sample
+
+        if frame_type == self.DELTA:
+            # a delta against a keyframe other than ours cannot be reconstructed, ask for a new keyframe
+            if not self.__has_keyframe or keyframe_id != self.__keyframe_id:
+                self.__has_keyframe = False
+                return None
+            return self.__decode_fields(payload[2:], self.__keyframe)
+
+        return None
+
+    @staticmethod
+    def __decode_fields(payload, reference):
+        mask = payload[0]
+        pos = 1
+        sample = list(reference)
+        for i in range(TelemetryDecoder.NUM_FIELDS):
+            if not mask & (1 << i):
+                continue
+            value = 0
+            shift = 0
+            while True:
+                if pos >= len(payload) or shift > 63:
+                    return None
+                byte = payload[pos]
+                pos += 1
+                value |= (byte & 0x7F) << shift
+                if not byte & 0x80:
+                    break
+                shift += 7
+            # zig-zag
+            sample[i] = reference[i] + ((value >> 1) ^ -(value & 1))
+        return sample
@@ -19,12 +19,27 @@ from __future__ import unicode_literals
 import zmq
 
 from .packet import Packet
+from .telemetry import TelemetryDecoder
 
 
 class ZalphaError(RuntimeError):
     pass
 
 
+DEFAULT_PORT = 17167
+
+
+def resolve_url(server_address):
+    """
+    Convert a server address ("host", "host:port" or an endpoint URL) into an endpoint URL.
+    """
+    if '://' in server_address:
+        return server_address
+    if ':' in server_address:
+        return 'tcp://%s' % server_address
+    return 'tcp://%s:%s' % (server_address, DEFAULT_PORT)
+
+
 class Zalpha(object):
 
     # Action status
@@ -60,22 +75,42 @@ class Zalpha(object):
     MSG_DISCONNECTED = 'Disconnected from API server.'
 
     def __init__(self):
-        self.__context = zmq.Context()
-        self.__socket = self.__context.socket(zmq.REQ)
+        self.__context = None
+        self.__socket = None
         self.__connected = False
         self.__server_url = ''
+        self.__telemetry = TelemetryDecoder()
 
-    def connect(self, server_ip):
+    def connect(self, server_address):
+        """
+        Connect to API server.
+
+        The server address can be an ip address ("192.168.100.1"), host:port ("192.168.100.1:17168"),
+        or an endpoint URL using the tcp://, ipc:// or inproc:// transport. The inproc:// endpoints
+        use the shared zmq.Context.instance(), which the in-process API server must also use.
+        """
         if self.__connected:
             raise ZalphaError(self.MSG_CONNECTED)
-        self.__server_url = 'tcp://%s:17167' % server_ip
+        self.__server_url = resolve_url(server_address)
+        if self.__server_url.startswith('inproc://'):
+            context = zmq.Context.instance()
+        else:
+            if self.__context is None:
+                self.__context = zmq.Context()
+            context = self.__context
+        self.__socket = context.socket(zmq.REQ)
+        self.__socket.setsockopt(zmq.LINGER, 0)
         self.__socket.connect(self.__server_url)
+        self.__telemetry.reset()
         self.__connected = True
 
     def disconnect(self):
         if not self.__connected:
             return
         self.__socket.disconnect(self.__server_url)
+        self.__socket.close()
+        self.__socket = None
+        self.__connected = False
 
     def version_info(self):
         packet = Packet()
@@ -177,6 +212,23 @@ class Zalpha(object):
         reply = self.__execute_command(packet, Packet.GET_RAW_ENCODER_AND_SAFETY_FLAG)
         return (reply.s64[0], reply.s64[1], reply.u16[8])
 
+    def get_telemetry(self):
+        """
+        Read the raw encoder counts, encoder distances and safety flag as a delta-compressed telemetry stream.
+
+        Returns (left_count, right_count, left_distance, right_distance, safety_flag), with the distances in m
+        at a resolution of 1 micrometer.
+        """
+        # a delta against a keyframe we do not hold is answered with a keyframe on the second attempt
+        for attempt in range(2):
+            packet = Packet()
+            self.__telemetry.prepare_request(packet)
+            reply = self.__execute_command(packet, Packet.GET_TELEMETRY)
+            sample = self.__telemetry.decode(reply)
+            if sample is not None:
+                return (sample[0], sample[1], sample[2] * 1e-6, sample[3] * 1e-6, sample[4])
+        raise ZalphaError(self.MSG_INVALID_REPLY)
+
     def get_battery(self):
         packet = Packet()
         reply = self.__execute_command(packet, Packet.GET_BATTERY)
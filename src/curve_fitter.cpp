@@ -0,0 +1,63 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <zalpha_api/curve_fitter.hpp>
+#include "impl/curve_fitter_impl.hpp"
+
+
+namespace zalpha_api
+{
+
+CurveFitter::CurveFitter() :
+  pimpl_(new CurveFitterImpl())
+{
+}
+
+CurveFitter::~CurveFitter()
+{
+}
+
+void CurveFitter::setTolerance(double tolerance)
+{
+  pimpl_->setTolerance(tolerance);
+}
+
+void CurveFitter::setMinRadius(double radius)
+{
+  pimpl_->setMinRadius(radius);
+}
+
+void CurveFitter::setCornerAngle(double angle)
+{
+  pimpl_->setCornerAngle(angle);
+}
+
+bool CurveFitter::fit(const std::vector<PathPoint>& points, double heading, std::vector<PathMotion>& motions)
+{
+  return pimpl_->fit(points, heading, motions);
+}
+
+int CurveFitter::getError()
+{
+  return pimpl_->getError();
+}
+
+std::string CurveFitter::getErrorMessage()
+{
+  return pimpl_->getErrorMessage();
+}
+
+}  // namespace zalpha_api
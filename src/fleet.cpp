@@ -0,0 +1,86 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <zalpha_api/fleet.hpp>
+#include "impl/fleet_impl.hpp"
+
+
+namespace zalpha_api
+{
+
+Fleet::Fleet() :
+  pimpl_(new FleetImpl())
+{
+}
+
+Fleet::~Fleet()
+{
+}
+
+size_t Fleet::bringUp(const std::vector<std::string>& addresses, std::vector<RobotHandshake>& report,
+                      int parallelism, int timeout, int probes)
+{
+  return pimpl_->bringUp(addresses, report, parallelism, timeout, probes);
+}
+
+void Fleet::disconnect()
+{
+  pimpl_->disconnect();
+}
+
+size_t Fleet::size() const
+{
+  return pimpl_->size();
+}
+
+Zalpha& Fleet::robot(size_t index)
+{
+  return pimpl_->robot(index);
+}
+
+bool Fleet::isReady(size_t index) const
+{
+  return pimpl_->isReady(index);
+}
+
+size_t Fleet::broadcastStopAction(BroadcastReport& report, const std::vector<size_t>& selection, int deadline)
+{
+  Packet packet;
+  return pimpl_->broadcast(packet, Packet::STOP_ACTION, report, selection, deadline);
+}
+
+size_t Fleet::broadcastPauseAction(BroadcastReport& report, const std::vector<size_t>& selection, int deadline)
+{
+  Packet packet;
+  return pimpl_->broadcast(packet, Packet::PAUSE_ACTION, report, selection, deadline);
+}
+
+size_t Fleet::broadcastResumeAction(BroadcastReport& report, const std::vector<size_t>& selection, int deadline)
+{
+  Packet packet;
+  return pimpl_->broadcast(packet, Packet::RESUME_ACTION, report, selection, deadline);
+}
+
+size_t Fleet::broadcastSetOutputs(uint32_t outputs, uint32_t mask, BroadcastReport& report,
+                                  const std::vector<size_t>& selection, int deadline)
+{
+  Packet packet;
+  packet.data.u32[0] = outputs;
+  packet.data.u32[1] = mask;
+  return pimpl_->broadcast(packet, Packet::SET_OUTPUTS, report, selection, deadline);
+}
+
+}  // namespace zalpha_api
@@ -0,0 +1,127 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#ifdef _WINDOWS
+#include <chrono>
+#endif
+
+#include "clock_sync.hpp"
+#ifndef _WINDOWS
+#include "monotonic_clock.hpp"
+#endif
+
+
+namespace zalpha_api
+{
+
+static bool lowerDelay(const std::pair<int64_t, size_t>& a, const std::pair<int64_t, size_t>& b)
+{
+  return a.first < b.first;
+}
+
+ClockSync::ClockSync()
+{
+  reset();
+}
+
+int64_t ClockSync::now()
+{
+#ifdef _WINDOWS
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#else
+  return monotonicNow();
+#endif
+}
+
+void ClockSync::reset()
+{
+  samples_.clear();
+  reference_ = 0;
+  offset_ = 0.0;
+  drift_ = 0.0;
+}
+
+void ClockSync::addSample(int64_t t0, int64_t t1, int64_t t2, int64_t t3)
+{
+  Sample sample;
+  sample.host_time = t0 + (t3 - t0) / 2;
+  sample.offset = ((t1 - t0) + (t2 - t3)) / 2.0;
+  sample.delay = std::max<int64_t>((t3 - t0) - (t2 - t1), 0);
+
+  samples_.push_back(sample);
+  if (samples_.size() > WINDOW)
+  {
+    samples_.pop_front();
+  }
+  update();
+}
+
+int64_t ClockSync::toHost(int64_t robot_time) const
+{
+  // solve host = robot - offsetAt(host), the drift is small enough for a single iteration
+  double host = robot_time - offset_;
+  host = robot_time - offsetAt((int64_t) host);
+  return (int64_t) std::floor(host + 0.5);
+}
+
+void ClockSync::update()
+{
+  // keep the half of the samples with the lowest delay
+  std::vector<std::pair<int64_t, size_t> > order;
+  for (size_t i = 0; i < samples_.size(); i++)
+  {
+    order.push_back(std::make_pair(samples_[i].delay, i));
+  }
+  size_t count = (order.size() + 1) / 2;
+  std::nth_element(order.begin(), order.begin() + (count - 1), order.end(), lowerDelay);
+
+  double mean_time = 0.0;
+  double mean_offset = 0.0;
+  int64_t first_time = samples_[order[0].second].host_time;
+  int64_t last_time = first_time;
+  for (size_t i = 0; i < count; i++)
+  {
+    const Sample& sample = samples_[order[i].second];
+    first_time = std::min(first_time, sample.host_time);
+    last_time = std::max(last_time, sample.host_time);
+    mean_time += sample.host_time;
+    mean_offset += sample.offset;
+  }
+  mean_time /= count;
+  mean_offset /= count;
+
+  double sxx = 0.0;
+  double sxy = 0.0;
+  for (size_t i = 0; i < count; i++)
+  {
+    const Sample& sample = samples_[order[i].second];
+    double dx = sample.host_time - mean_time;
+    sxx += dx * dx;
+    sxy += dx * (sample.offset - mean_offset);
+  }
+
+  reference_ = (int64_t) mean_time;
+  offset_ = mean_offset;
+  drift_ = (last_time - first_time >= MIN_DRIFT_SPAN) ? sxy / sxx : 0.0;
+
+  double max_drift = MAX_DRIFT_PPM * 1e-6;
+  drift_ = std::max(-max_drift, std::min(max_drift, drift_));
+}
+
+}  // namespace zalpha_api
@@ -0,0 +1,105 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ZALPHA_API_IMPL_CLOCK_SYNC_HPP
+#define ZALPHA_API_IMPL_CLOCK_SYNC_HPP
+
+#include <stdint.h>
+#include <deque>
+
+#include <zalpha_api/zalpha_api_export.h>
+
+
+namespace zalpha_api
+{
+
+/**
+ * \brief ClockSync estimates the offset and drift of the robot clock against the host monotonic clock.
+ *
+ * Each sample is an NTP-style exchange: the host sends at t0, the robot receives at t1 and replies at t2,
+ * and the host receives at t3. The offset of a sample is ((t1 - t0) + (t2 - t3)) / 2, and its error is bounded by
+ * half of its network delay (t3 - t0) - (t2 - t1).
+ *
+ * The estimate is a least-squares line of the offset against the host time, fitted over the half of the recent
+ * samples with the lowest delay, so that the samples delayed by queueing or Wi-Fi retransmissions are ignored.
+ * The drift is taken as zero until the samples span MIN_DRIFT_SPAN, a burst of samples only measures the offset.
+ *
+ * All times are in microseconds.
+ */
+class ZALPHA_API_NO_EXPORT ClockSync
+{
+public:
+  enum
+  {
+    WINDOW = 64,           ///< Number of recent samples kept
+    MAX_DRIFT_PPM = 500,   ///< Bound of the drift estimate, beyond any crystal oscillator
+    MIN_DRIFT_SPAN = 1000000,  ///< Time span of the samples required to estimate the drift
+  };
+
+public:
+  ClockSync();
+
+  /**
+   * \brief The host monotonic time, in microseconds, see monotonicNow().
+   */
+  static int64_t now();
+
+  void reset();
+  void addSample(int64_t t0, int64_t t1, int64_t t2, int64_t t3);
+
+  bool synchronized() const
+  {
+    return !samples_.empty();
+  }
+  /**
+   * \brief The offset of the robot clock at the given host time, robot time minus host time.
+   */
+  double offsetAt(int64_t host_time) const
+  {
+    return offset_ + drift_ * (host_time - reference_);
+  }
+  /**
+   * \brief The drift of the robot clock against the host clock, as a ratio.
+   */
+  double drift() const
+  {
+    return drift_;
+  }
+  /**
+   * \brief Convert a robot time into a host time.
+   */
+  int64_t toHost(int64_t robot_time) const;
+
+private:
+  void update();
+
+private:
+  struct Sample
+  {
+    int64_t host_time;
+    double offset;
+    int64_t delay;
+  };
+  std::deque<Sample> samples_;
+
+  int64_t reference_;
+  double offset_;
+  double drift_;
+};
+
+}  // namespace zalpha_api
+
+#endif  // ZALPHA_API_IMPL_CLOCK_SYNC_HPP
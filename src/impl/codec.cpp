@@ -0,0 +1,114 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstring>
+
+#include "codec.hpp"
+
+
+namespace zalpha_api
+{
+
+size_t Codec::encode(const Packet& packet, int encoding, uint8_t* buffer)
+{
+  if (encoding == COMPACT)
+  {
+    const uint8_t* data = packet.data.u8;
+    size_t length = Packet::MAX_PAYLOAD;
+    while (length > 0 && data[length - 1] == 0)
+    {
+      length--;
+    }
+
+    uint8_t mask = 0;
+    size_t size = HEADER_SIZE + length;
+    for (int i = 0; i < 3; i++)
+    {
+      if (packet.reserved[i] != 0)
+      {
+        mask |= (1 << i);
+        size += 2;
+      }
+    }
+
+    if (size < sizeof(Packet))
+    {
+      std::memcpy(buffer, &packet.command, 2);
+      buffer[2] = mask;
+      buffer[3] = (uint8_t) length;
+
+      uint8_t* dst = buffer + HEADER_SIZE;
+      for (int i = 0; i < 3; i++)
+      {
+        if (mask & (1 << i))
+        {
+          std::memcpy(dst, &packet.reserved[i], 2);
+          dst += 2;
+        }
+      }
+      std::memcpy(dst, data, length);
+      return size;
+    }
+  }
+
+  std::memcpy(buffer, &packet, sizeof(Packet));
+  return sizeof(Packet);
+}
+
+bool Codec::decode(const uint8_t* buffer, size_t size, Packet& packet)
+{
+  if (size == sizeof(Packet))
+  {
+    std::memcpy(&packet, buffer, sizeof(Packet));
+    return true;
+  }
+  if (size < HEADER_SIZE || size > sizeof(Packet))
+  {
+    return false;
+  }
+
+  uint8_t mask = buffer[2];
+  size_t length = buffer[3];
+  size_t expected = HEADER_SIZE + length;
+  for (int i = 0; i < 3; i++)
+  {
+    if (mask & (1 << i))
+    {
+      expected += 2;
+    }
+  }
+  if ((mask & ~0x07) || length > Packet::MAX_PAYLOAD || expected != size)
+  {
+    return false;
+  }
+
+  packet = Packet();
+  std::memcpy(&packet.command, buffer, 2);
+
+  const uint8_t* src = buffer + HEADER_SIZE;
+  for (int i = 0; i < 3; i++)
+  {
+    if (mask & (1 << i))
+    {
+      std::memcpy(&packet.reserved[i], src, 2);
+      src += 2;
+    }
+  }
+  std::memcpy(packet.data.u8, src, length);
+  return true;
+}
+
+}  // namespace zalpha_api
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ZALPHA_API_IMPL_CODEC_HPP
+#define ZALPHA_API_IMPL_CODEC_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <zalpha_api/zalpha_api_export.h>
+#include "packet.hpp"
+
+
+namespace zalpha_api
+{
+
+/**
+ * \brief Codec converts a Packet to and from its wire encoding.
+ *
+ * The fixed encoding is the 72-byte Packet itself.
+ *
+ * The compact encoding only carries the bytes in use:
+ *
+ * <table>
+ * <tr><th>Byte Offset</th><th>Size (bytes)</th><th>Description</th></tr>
+ * <tr><td>0 - 1</td><td>2</td><td>Command</td></tr>
+ * <tr><td>2</td><td>1</td><td>Bit i is set when reserved[i] is present, bit 7-3 are zero</td></tr>
+ * <tr><td>3</td><td>1</td><td>Payload length n (0 - 64)</td></tr>
+ * <tr><td>4 - </td><td>2 each</td><td>The present reserved words, in order</td></tr>
+ * <tr><td>...</td><td>n</td><td>The first n bytes of the data, the remaining bytes are zero</td></tr>
+ * </table>
+ *
+ * A reserved word is present when it is non-zero, and the payload length excludes the trailing zero bytes.
+ *
+ * A compact frame is always shorter than the fixed packet, the fixed encoding is used instead whenever it is not.
+ * The size of a frame therefore tells its encoding, and the API server replies in the encoding of the request.
+ */
+class ZALPHA_API_NO_EXPORT Codec
+{
+public:
+  enum
+  {
+    FIXED = 0,
+    COMPACT = 1,
+  };
+  enum
+  {
+    HEADER_SIZE = 4,
+    MAX_SIZE = sizeof(Packet),
+  };
+
+public:
+  /**
+   * \brief Encode a packet.
+   * @param packet           The packet to encode
+   * @param encoding         The encoding to use, FIXED or COMPACT
+   * @param buffer           The buffer to store the frame, of at least MAX_SIZE bytes
+   * @return                 The size of the frame
+   */
+  static size_t encode(const Packet& packet, int encoding, uint8_t* buffer);
+  /**
+   * \brief Decode a frame of either encoding.
+   * @return                 A boolean indicating whether the frame is well-formed
+   */
+  static bool decode(const uint8_t* buffer, size_t size, Packet& packet);
+  /**
+   * \brief The encoding of a frame, as given by its size.
+   */
+  static int encodingOf(size_t size)
+  {
+    return (size == sizeof(Packet)) ? FIXED : COMPACT;
+  }
+};
+
+}  // namespace zalpha_api
+
+#endif  // ZALPHA_API_IMPL_CODEC_HPP
@@ -0,0 +1,225 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <cstring>
+#include <sstream>
+
+#include "connection_monitor.hpp"
+#include "clock_sync.hpp"
+
+
+namespace zalpha_api
+{
+
+ConnectionMonitor::ConnectionMonitor() :
+  running_(false), next_events_(NULL)
+{
+  reset();
+}
+
+ConnectionMonitor::~ConnectionMonitor()
+{
+  stop();
+}
+
+void ConnectionMonitor::reset()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::memset(&status_, 0, sizeof(status_));
+  status_.state = Zalpha::CS_CONNECTING;
+}
+
+bool ConnectionMonitor::start(zmq::context_t& context, zmq::socket_t& socket)
+{
+  // every socket needs an endpoint of its own, as the monitors of several transports may share a context
+  static std::atomic<unsigned> next_id(0);
+  std::ostringstream endpoint;
+  endpoint << "inproc://zalpha-monitor-" << next_id++;
+
+  std::auto_ptr<zmq::socket_t> events;
+  try
+  {
+    int mask = ZMQ_EVENT_CONNECTED | ZMQ_EVENT_CONNECT_DELAYED | ZMQ_EVENT_CONNECT_RETRIED |
+               ZMQ_EVENT_DISCONNECTED | ZMQ_EVENT_MONITOR_STOPPED;
+#ifdef ZMQ_EVENT_HANDSHAKE_SUCCEEDED
+    mask |= ZMQ_EVENT_HANDSHAKE_SUCCEEDED | ZMQ_EVENT_HANDSHAKE_FAILED_NO_DETAIL |
+            ZMQ_EVENT_HANDSHAKE_FAILED_PROTOCOL | ZMQ_EVENT_HANDSHAKE_FAILED_AUTH;
+#endif
+    if (zmq_socket_monitor((void*) socket, endpoint.str().c_str(), mask) != 0)
+    {
+      return false;
+    }
+    events.reset(new zmq::socket_t(context, ZMQ_PAIR));
+    int linger = 0;
+    int timeout = STOP_POLL_INTERVAL;
+    events->setsockopt(ZMQ_LINGER, &linger, sizeof(linger));
+    events->setsockopt(ZMQ_RCVTIMEO, &timeout, sizeof(timeout));
+    events->connect(endpoint.str().c_str());
+  }
+  catch (const zmq::error_t&)
+  {
+    zmq_socket_monitor((void*) socket, NULL, 0);
+    return false;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    delete next_events_;
+    next_events_ = events.release();
+  }
+  started_.notify_one();
+
+  // the thread outlives the sockets, so that replacing one does not start another thread
+  if (!thread_.joinable())
+  {
+    running_ = true;
+    thread_ = std::thread(&ConnectionMonitor::run, this);
+  }
+  return true;
+}
+
+void ConnectionMonitor::stop()
+{
+  if (thread_.joinable())
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      running_ = false;
+    }
+    started_.notify_one();
+    thread_.join();
+  }
+
+  delete next_events_;
+  next_events_ = NULL;
+}
+
+void ConnectionMonitor::getStatus(ConnectionStatus& status)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  status = status_;
+}
+
+bool ConnectionMonitor::isDown()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return status_.state == Zalpha::CS_DISCONNECTED;
+}
+
+void ConnectionMonitor::run()
+{
+  zmq::socket_t* events = NULL;
+  while (running_)
+  {
+    {
+      // switch over to the socket that replaced the one watched, or wait for one once it is closed
+      std::unique_lock<std::mutex> lock(mutex_);
+      while (running_ && !events && !next_events_)
+      {
+        started_.wait(lock);
+      }
+      if (next_events_)
+      {
+        delete events;
+        events = next_events_;
+        next_events_ = NULL;
+      }
+    }
+    if (!events) continue;
+
+    // each event is a frame of the event number and its value, followed by a frame of the endpoint
+    zmq::message_t message;
+    try
+    {
+      if (!events->recv(&message)) continue;
+    }
+    catch (const zmq::error_t& ex)
+    {
+      if (ex.num() == EINTR) continue;
+      delete events;
+      events = NULL;
+      continue;
+    }
+    int64_t time = ClockSync::now();
+    uint16_t event = 0;
+    if (message.size() >= sizeof(event))
+    {
+      std::memcpy(&event, message.data(), sizeof(event));
+    }
+    while (message.more())
+    {
+      events->recv(&message);
+    }
+
+    if (event == ZMQ_EVENT_MONITOR_STOPPED)
+    {
+      delete events;
+      events = NULL;
+      continue;
+    }
+    handle(event, time);
+  }
+  delete events;
+}
+
+void ConnectionMonitor::handle(uint16_t event, int64_t time)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  switch (event)
+  {
+#ifdef ZMQ_EVENT_HANDSHAKE_SUCCEEDED
+  case ZMQ_EVENT_CONNECTED:
+    // the session is only usable once the ZMTP handshake succeeds
+    break;
+  case ZMQ_EVENT_HANDSHAKE_SUCCEEDED:
+#else
+  case ZMQ_EVENT_CONNECTED:
+#endif
+    if (status_.connects > 0)
+    {
+      status_.reconnects++;
+    }
+    status_.connects++;
+    status_.last_connect = time;
+    status_.state = Zalpha::CS_CONNECTED;
+    break;
+  case ZMQ_EVENT_CONNECT_DELAYED:
+    // a connection attempt under way, the state is only known from its outcome
+    break;
+  case ZMQ_EVENT_CONNECT_RETRIED:
+    status_.retries++;
+    status_.last_retry = time;
+    status_.state = Zalpha::CS_DISCONNECTED;
+    break;
+  case ZMQ_EVENT_DISCONNECTED:
+    status_.disconnects++;
+    status_.last_disconnect = time;
+    status_.state = Zalpha::CS_DISCONNECTED;
+    break;
+#ifdef ZMQ_EVENT_HANDSHAKE_SUCCEEDED
+  case ZMQ_EVENT_HANDSHAKE_FAILED_NO_DETAIL:
+  case ZMQ_EVENT_HANDSHAKE_FAILED_PROTOCOL:
+  case ZMQ_EVENT_HANDSHAKE_FAILED_AUTH:
+    status_.handshake_failures++;
+    break;
+#endif
+  default:
+    break;
+  }
+}
+
+}  // namespace zalpha_api
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef ZALPHA_API_IMPL_CONNECTION_MONITOR_HPP
+#define ZALPHA_API_IMPL_CONNECTION_MONITOR_HPP
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <zmq.hpp>
+
+#include <zalpha_api/zalpha_api_export.h>
+#include <zalpha_api/zalpha.hpp>
+
+
+namespace zalpha_api
+{
+
+/**
+ * \brief ConnectionMonitor follows the TCP sessions of a ZMQ socket with zmq_socket_monitor().
+ *
+ * A thread of its own receives the events of the socket as they happen, so that their times are accurate and the
+ * state is known without a round trip. A socket that is replaced, for eg: after a reply timed out, is watched again
+ * with start(), by the same thread and with the counters carried over.
+ */
+class ZALPHA_API_NO_EXPORT ConnectionMonitor
+{
+public:
+  enum
+  {
+    STOP_POLL_INTERVAL = 100,  ///< Time between the checks of a stop request, in ms
+  };
+
+public:
+  ConnectionMonitor();
+  virtual ~ConnectionMonitor();
+
+  /**
+   * \brief Forget the sessions of the previous endpoint, before connecting to a new one.
+   */
+  void reset();
+  /**
+   * \brief Watch the events of a socket, until it is closed or replaced by another one.
+   * @return                 A boolean indicating whether the socket can be monitored
+   */
+  bool start(zmq::context_t& context, zmq::socket_t& socket);
+  /**
+   * \brief Stop the thread, once the last socket watched is closed.
+   */
+  void stop();
+
+  void getStatus(ConnectionStatus& status);
+  /**
+   * \brief Whether the session was lost, or the connection attempts failed, and it is not up again.
+   */
+  bool isDown();
+
+private:
+  void run();
+  void handle(uint16_t event, int64_t time);
+
+private:
+  std::thread thread_;
+  std::atomic<bool> running_;
+
+  std::mutex mutex_;  ///< guards the status, updated by the thread, and the next events socket
+  std::condition_variable started_;
+  zmq::socket_t* next_events_;  ///< the events of the socket passed to start(), until the thread takes them over
+  ConnectionStatus status_;
+};
+
+}  // namespace zalpha_api
+
+#endif  // ZALPHA_API_IMPL_CONNECTION_MONITOR_HPP
@@ -0,0 +1,536 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "curve_fitter_impl.hpp"
+#include "packet.hpp"
+
+
+namespace zalpha_api
+{
+
+static const double PI = 3.14159265358979323846;  // PI is not defined by every compiler
+static const double MIN_DISTANCE = 1e-9;  // in m, between two waypoints that are not repeats
+static const double MIN_ROTATION = 1e-6;  // in rad, below which no rotation is inserted
+
+static double wrapAngle(double angle)
+{
+  return std::atan2(std::sin(angle), std::cos(angle));
+}
+
+CurveFitterImpl::CurveFitterImpl() :
+  tolerance_(0.02), min_radius_(0.1), corner_angle_(PI / 4.0),
+  pose_x_(0.0), pose_y_(0.0), pose_heading_(0.0), motions_(NULL),
+  errnum_(0)
+{
+}
+
+CurveFitterImpl::~CurveFitterImpl()
+{
+}
+
+void CurveFitterImpl::setTolerance(double tolerance)
+{
+  tolerance_ = std::max(tolerance, 1e-6);
+}
+
+void CurveFitterImpl::setMinRadius(double radius)
+{
+  min_radius_ = std::max(radius, 0.0);
+}
+
+void CurveFitterImpl::setCornerAngle(double angle)
+{
+  corner_angle_ = std::min(std::fabs(angle), PI);
+}
+
+bool CurveFitterImpl::fit(const std::vector<PathPoint>& points, double heading, std::vector<PathMotion>& motions)
+{
+  motions.clear();
+  x_.clear();
+  y_.clear();
+  s_.clear();
+  index_.clear();
+  for (size_t i = 0; i < points.size(); i++)
+  {
+    if (!x_.empty() && std::hypot(points[i].x - x_.back(), points[i].y - y_.back()) < MIN_DISTANCE)
+    {
+      index_.back() = i;
+      continue;
+    }
+    s_.push_back(x_.empty() ? 0.0 : s_.back() + std::hypot(points[i].x - x_.back(), points[i].y - y_.back()));
+    x_.push_back(points[i].x);
+    y_.push_back(points[i].y);
+    index_.push_back(i);
+  }
+  if (x_.size() < 2)
+  {
+    errnum_ = Packet::RESULT_ERROR_INVALID_COMMAND;
+    errmsg_ = "Invalid parameters in API call.";
+    return false;
+  }
+
+  size_t n = x_.size();
+  findCorners();
+  u_.resize(n);
+
+  motions_ = &motions;
+  pose_x_ = x_[0];
+  pose_y_ = y_[0];
+  pose_heading_ = heading;
+
+  // each curve is the longest one that fits from the current pose, up to the next corner
+  size_t first = 0;
+  size_t piece_start = 0;
+  while (first + 1 < n)
+  {
+    if (corner_[first])
+    {
+      piece_start = first;
+    }
+    size_t piece_end = first + 1;
+    while (piece_end + 1 < n && !corner_[piece_end])
+    {
+      piece_end++;
+    }
+
+    double dx, dy;
+    direction(first, ahead(first, piece_end, TANGENT_WINDOW * tolerance_), dx, dy);
+    double path_heading = std::atan2(dy, dx);
+    if (std::fabs(wrapAngle(path_heading - pose_heading_)) > corner_angle_)
+    {
+      addRotation(path_heading, first);
+    }
+
+    Bezier bezier;
+    double error = 0.0;
+    size_t last = longestSpan(first, piece_start, piece_end, std::cos(pose_heading_), std::sin(pose_heading_), bezier,
+                              error);
+    if (last == first)
+    {
+      // no curve from the current heading fits, so turn to the path first
+      addRotation(path_heading, first);
+      last = longestSpan(first, piece_start, piece_end, dx, dy, bezier, error);
+    }
+    if (last == first)
+    {
+      // the path turns too tightly for any curve, so it is cut into straight lines within the tolerance,
+      // each one ending before the path turns back along it
+      last = first + 1;
+      while (last < piece_end && withinLine(first, last + 1) &&
+             std::hypot(x_[last + 1] - x_[first], y_[last + 1] - y_[first]) >
+             std::hypot(x_[last] - x_[first], y_[last] - y_[first]))
+      {
+        last++;
+      }
+      direction(first, last, dx, dy);
+      addRotation(std::atan2(dy, dx), first);
+      double third = std::hypot(x_[last] - x_[first], y_[last] - y_[first]) / 3.0;
+      bezier.x[0] = x_[first];
+      bezier.y[0] = y_[first];
+      bezier.x[1] = x_[first] + dx * third;
+      bezier.y[1] = y_[first] + dy * third;
+      bezier.x[2] = x_[last] - dx * third;
+      bezier.y[2] = y_[last] - dy * third;
+      bezier.x[3] = x_[last];
+      bezier.y[3] = y_[last];
+      error = 0.0;
+    }
+    addBezier(bezier, last, error);
+    first = last;
+  }
+  motions_ = NULL;
+
+  for (size_t i = 0; i < motions.size(); i++)
+  {
+    const PathMotion& motion = motions[i];
+    bool finite = (motion.type == CurveFitter::MT_ROTATE) ? std::isfinite(motion.angle) :
+                  std::isfinite(motion.x) && std::isfinite(motion.y) && std::isfinite(motion.cp1_x) &&
+                  std::isfinite(motion.cp1_y) && std::isfinite(motion.cp2_x) && std::isfinite(motion.cp2_y);
+    if (!finite)
+    {
+      motions.clear();
+      errnum_ = Packet::RESULT_ERROR_INVALID_COMMAND;
+      errmsg_ = "Invalid parameters in API call.";
+      return false;
+    }
+  }
+  return true;
+}
+
+void CurveFitterImpl::direction(size_t from, size_t to, double& tx, double& ty) const
+{
+  // a path that retraces itself, for eg: out and back along an aisle, may come back to the same waypoint,
+  // so the window is widened until its ends differ, or narrowed to a single step, which always does
+  size_t start = from;
+  size_t end = to;
+  while (std::hypot(x_[end] - x_[start], y_[end] - y_[start]) < MIN_DISTANCE && end + 1 < x_.size())
+  {
+    end++;
+  }
+  while (std::hypot(x_[end] - x_[start], y_[end] - y_[start]) < MIN_DISTANCE && start > 0)
+  {
+    start--;
+  }
+  if (std::hypot(x_[end] - x_[start], y_[end] - y_[start]) < MIN_DISTANCE)
+  {
+    start = from;
+    end = from + 1;
+  }
+  double dx = x_[end] - x_[start];
+  double dy = y_[end] - y_[start];
+  double length = std::hypot(dx, dy);
+  tx = dx / length;
+  ty = dy / length;
+}
+
+size_t CurveFitterImpl::behind(size_t index, size_t lowest, double distance) const
+{
+  // the waypoint at most a distance behind, but never the waypoint itself
+  size_t k = std::lower_bound(s_.begin() + lowest, s_.begin() + index, s_[index] - distance) - s_.begin();
+  return std::min(k, index - 1);
+}
+
+size_t CurveFitterImpl::ahead(size_t index, size_t highest, double distance) const
+{
+  size_t k = std::upper_bound(s_.begin() + index + 1, s_.begin() + highest + 1, s_[index] + distance) - s_.begin();
+  return std::max(k - 1, index + 1);
+}
+
+void CurveFitterImpl::findCorners()
+{
+  // the turn is measured over a window, so that the noise of dense waypoints does not look like corners
+  size_t n = x_.size();
+  double window = CORNER_WINDOW * tolerance_;
+  std::vector<double> turn(n, 0.0);
+  for (size_t k = 1; k + 1 < n; k++)
+  {
+    double ax, ay, bx, by;
+    direction(behind(k, 0, window), k, ax, ay);
+    direction(k, ahead(k, n - 1, window), bx, by);
+    turn[k] = std::atan2(std::fabs(ax * by - ay * bx), ax * bx + ay * by);
+  }
+
+  // a corner is seen across the whole window, only its sharpest waypoint is kept
+  corner_.assign(n, false);
+  for (size_t k = 1; k + 1 < n; k++)
+  {
+    if (turn[k] <= corner_angle_) continue;
+    bool sharpest = true;
+    for (size_t j = behind(k, 0, window); j < k && sharpest; j++)
+    {
+      sharpest = turn[j] < turn[k];
+    }
+    for (size_t j = k + 1; j <= ahead(k, n - 1, window) && sharpest; j++)
+    {
+      sharpest = turn[j] <= turn[k];
+    }
+    corner_[k] = sharpest;
+  }
+}
+
+void CurveFitterImpl::endTangent(size_t index, size_t piece_start, size_t piece_end, double& tx, double& ty) const
+{
+  // the path arrives straight into a corner, elsewhere it carries on through the waypoint
+  double window = TANGENT_WINDOW * tolerance_;
+  size_t from = behind(index, piece_start, window);
+  size_t to = (index == piece_end) ? index : ahead(index, piece_end, window);
+  direction(from, to, tx, ty);
+}
+
+size_t CurveFitterImpl::longestSpan(size_t first, size_t piece_start, size_t piece_end, double t1x, double t1y,
+                                    Bezier& bezier, double& error)
+{
+  Bezier candidate;
+  double candidate_error;
+  double t2x, t2y;
+
+  // the deviation grows with the span, but a short span cannot absorb a small heading error without turning
+  // sharply, so the span doubles until it deviates, then bisects between the longest span that does not deviate
+  // and the shortest one that does
+  size_t good = first;
+  size_t short_span = first;
+  size_t long_span = piece_end + 1;
+  for (size_t step = 1; short_span < piece_end; step *= 2)
+  {
+    size_t last = std::min(first + step, piece_end);
+    endTangent(last, piece_start, piece_end, t2x, t2y);
+    int result = fitSpan(first, last, t1x, t1y, t2x, t2y, candidate, candidate_error);
+    if (result == FIT_TOLERANCE)
+    {
+      long_span = last;
+      break;
+    }
+    if (result == FIT_OK)
+    {
+      good = last;
+      bezier = candidate;
+      error = candidate_error;
+    }
+    short_span = last;
+  }
+  while (long_span - short_span > 1)
+  {
+    size_t last = short_span + (long_span - short_span) / 2;
+    endTangent(last, piece_start, piece_end, t2x, t2y);
+    int result = fitSpan(first, last, t1x, t1y, t2x, t2y, candidate, candidate_error);
+    if (result == FIT_TOLERANCE)
+    {
+      long_span = last;
+      continue;
+    }
+    if (result == FIT_OK)
+    {
+      good = last;
+      bezier = candidate;
+      error = candidate_error;
+    }
+    short_span = last;
+  }
+  return good;
+}
+
+int CurveFitterImpl::fitSpan(size_t first, size_t last, double t1x, double t1y, double t2x, double t2y,
+                             Bezier& bezier, double& error)
+{
+  size_t count = last - first + 1;
+  const double* x = &x_[first];
+  const double* y = &y_[first];
+  double* u = &u_[0];
+
+  // chord-length parameters
+  const double* s = &s_[first];
+  double scale = 1.0 / (s[count - 1] - s[0]);
+  for (size_t k = 0; k < count; k++)
+  {
+    u[k] = (s[k] - s[0]) * scale;
+  }
+
+  bezier.x[0] = x[0];
+  bezier.y[0] = y[0];
+  bezier.x[3] = x[count - 1];
+  bezier.y[3] = y[count - 1];
+  solveHandles(first, count, t1x, t1y, t2x, t2y, bezier);
+  error = maxError(first, count, bezier);
+
+  // the parameters are only worth refining when the curve is close
+  for (int i = 0; i < MAX_ITERATIONS && error > tolerance_ && error < 4.0 * tolerance_; i++)
+  {
+    reparameterize(first, count, bezier);
+    solveHandles(first, count, t1x, t1y, t2x, t2y, bezier);
+    error = maxError(first, count, bezier);
+  }
+  if (error > tolerance_) return FIT_TOLERANCE;
+  return withinCurvature(bezier) ? FIT_OK : FIT_CURVATURE;
+}
+
+void CurveFitterImpl::solveHandles(size_t first, size_t count, double t1x, double t1y, double t2x, double t2y,
+                                   Bezier& bezier)
+{
+  const double* x = &x_[first];
+  const double* y = &y_[first];
+  const double* u = &u_[0];
+  double x0 = bezier.x[0], y0 = bezier.y[0];
+  double x3 = bezier.x[3], y3 = bezier.y[3];
+
+  // the least-squares lengths of the handles along the end tangents
+  double c00 = 0.0, c01 = 0.0, c11 = 0.0, r0 = 0.0, r1 = 0.0;
+  double dot = t1x * t2x + t1y * t2y;
+  for (size_t k = 0; k < count; k++)
+  {
+    double s = u[k];
+    double v = 1.0 - s;
+    double b0 = v * v * v;
+    double b1 = 3.0 * s * v * v;
+    double b2 = 3.0 * s * s * v;
+    double b3 = s * s * s;
+    double dx = x[k] - (x0 * (b0 + b1) + x3 * (b2 + b3));
+    double dy = y[k] - (y0 * (b0 + b1) + y3 * (b2 + b3));
+    c00 += b1 * b1;
+    c01 -= b1 * b2 * dot;
+    c11 += b2 * b2;
+    r0 += b1 * (dx * t1x + dy * t1y);
+    r1 -= b2 * (dx * t2x + dy * t2y);
+  }
+
+  double det = c00 * c11 - c01 * c01;
+  bool singular = std::fabs(det) <= 1e-12 * c00 * c11;
+  double alpha1 = singular ? 0.0 : (r0 * c11 - r1 * c01) / det;
+  double alpha2 = singular ? 0.0 : (c00 * r1 - c01 * r0) / det;
+  double chord = std::hypot(x3 - x0, y3 - y0);
+  if (alpha1 < 1e-6 * chord || alpha2 < 1e-6 * chord || alpha1 > chord || alpha2 > chord)
+  {
+    // the handles would point backwards or loop, fall back to the usual third of the chord
+    alpha1 = alpha2 = chord / 3.0;
+  }
+  bezier.x[1] = x0 + t1x * alpha1;
+  bezier.y[1] = y0 + t1y * alpha1;
+  bezier.x[2] = x3 - t2x * alpha2;
+  bezier.y[2] = y3 - t2y * alpha2;
+}
+
+double CurveFitterImpl::maxError(size_t first, size_t count, const Bezier& bezier)
+{
+  const double* x = &x_[first];
+  const double* y = &y_[first];
+  const double* u = &u_[0];
+
+  double max_squared = 0.0;
+  for (size_t k = 0; k < count; k++)
+  {
+    double s = u[k];
+    double v = 1.0 - s;
+    double b0 = v * v * v;
+    double b1 = 3.0 * s * v * v;
+    double b2 = 3.0 * s * s * v;
+    double b3 = s * s * s;
+    double dx = b0 * bezier.x[0] + b1 * bezier.x[1] + b2 * bezier.x[2] + b3 * bezier.x[3] - x[k];
+    double dy = b0 * bezier.y[0] + b1 * bezier.y[1] + b2 * bezier.y[2] + b3 * bezier.y[3] - y[k];
+    double squared = dx * dx + dy * dy;
+    max_squared = (squared > max_squared) ? squared : max_squared;
+  }
+  return std::sqrt(max_squared);
+}
+
+void CurveFitterImpl::reparameterize(size_t first, size_t count, const Bezier& bezier)
+{
+  const double* x = &x_[first];
+  const double* y = &y_[first];
+  double* u = &u_[0];
+
+  // one Newton-Raphson step towards the closest point of the curve to each waypoint
+  for (size_t k = 0; k < count; k++)
+  {
+    double s = u[k];
+    double v = 1.0 - s;
+    double dx = v * v * v * bezier.x[0] + 3.0 * s * v * v * bezier.x[1] + 3.0 * s * s * v * bezier.x[2]
+                + s * s * s * bezier.x[3] - x[k];
+    double dy = v * v * v * bezier.y[0] + 3.0 * s * v * v * bezier.y[1] + 3.0 * s * s * v * bezier.y[2]
+                + s * s * s * bezier.y[3] - y[k];
+    double d1x = 3.0 * (v * v * (bezier.x[1] - bezier.x[0]) + 2.0 * s * v * (bezier.x[2] - bezier.x[1])
+                        + s * s * (bezier.x[3] - bezier.x[2]));
+    double d1y = 3.0 * (v * v * (bezier.y[1] - bezier.y[0]) + 2.0 * s * v * (bezier.y[2] - bezier.y[1])
+                        + s * s * (bezier.y[3] - bezier.y[2]));
+    double d2x = 6.0 * (v * (bezier.x[2] - 2.0 * bezier.x[1] + bezier.x[0])
+                        + s * (bezier.x[3] - 2.0 * bezier.x[2] + bezier.x[1]));
+    double d2y = 6.0 * (v * (bezier.y[2] - 2.0 * bezier.y[1] + bezier.y[0])
+                        + s * (bezier.y[3] - 2.0 * bezier.y[2] + bezier.y[1]));
+    double numerator = dx * d1x + dy * d1y;
+    double denominator = d1x * d1x + d1y * d1y + dx * d2x + dy * d2y;
+    s -= (denominator != 0.0) ? numerator / denominator : 0.0;
+    u[k] = std::min(std::max(s, 0.0), 1.0);
+  }
+}
+
+bool CurveFitterImpl::withinLine(size_t first, size_t last) const
+{
+  double dx, dy;
+  direction(first, last, dx, dy);
+  for (size_t k = first + 1; k < last; k++)
+  {
+    if (std::fabs((x_[k] - x_[first]) * dy - (y_[k] - y_[first]) * dx) > tolerance_) return false;
+  }
+  return true;
+}
+
+bool CurveFitterImpl::withinCurvature(const Bezier& bezier) const
+{
+  // without a minimum radius, only the cusps are rejected
+  bool bounded = min_radius_ > 0.0;
+  double max_curvature = bounded ? 1.0 / min_radius_ : 0.0;
+  double last_dx = 0.0, last_dy = 0.0;
+  for (int i = 0; i <= CURVATURE_SAMPLES; i++)
+  {
+    double s = (double) i / CURVATURE_SAMPLES;
+    double v = 1.0 - s;
+    double d1x = 3.0 * (v * v * (bezier.x[1] - bezier.x[0]) + 2.0 * s * v * (bezier.x[2] - bezier.x[1])
+                        + s * s * (bezier.x[3] - bezier.x[2]));
+    double d1y = 3.0 * (v * v * (bezier.y[1] - bezier.y[0]) + 2.0 * s * v * (bezier.y[2] - bezier.y[1])
+                        + s * s * (bezier.y[3] - bezier.y[2]));
+    double d2x = 6.0 * (v * (bezier.x[2] - 2.0 * bezier.x[1] + bezier.x[0])
+                        + s * (bezier.x[3] - 2.0 * bezier.x[2] + bezier.x[1]));
+    double d2y = 6.0 * (v * (bezier.y[2] - 2.0 * bezier.y[1] + bezier.y[0])
+                        + s * (bezier.y[3] - 2.0 * bezier.y[2] + bezier.y[1]));
+    double speed_squared = d1x * d1x + d1y * d1y;
+    // a cusp, where the curve stops, has no bounded curvature
+    if (speed_squared < 1e-18) return false;
+    if (bounded && std::fabs(d1x * d2y - d1y * d2x) > max_curvature * speed_squared * std::sqrt(speed_squared))
+    {
+      return false;
+    }
+    // nor a cusp between the samples, where a straight curve doubles back on itself
+    if (i > 0 && d1x * last_dx + d1y * last_dy <= 0.0) return false;
+    last_dx = d1x;
+    last_dy = d1y;
+  }
+  return true;
+}
+
+void CurveFitterImpl::addBezier(const Bezier& bezier, size_t last, double error)
+{
+  double c = std::cos(pose_heading_);
+  double s = std::sin(pose_heading_);
+  float local_x[4], local_y[4];
+  for (int i = 0; i < 4; i++)
+  {
+    double dx = bezier.x[i] - pose_x_;
+    double dy = bezier.y[i] - pose_y_;
+    local_x[i] = (float) (dx * c + dy * s);
+    local_y[i] = (float) (-dx * s + dy * c);
+  }
+
+  PathMotion motion;
+  motion.type = CurveFitter::MT_BEZIER;
+  motion.x = local_x[3];
+  motion.y = local_y[3];
+  motion.cp1_x = local_x[1];
+  motion.cp1_y = local_y[1];
+  motion.cp2_x = local_x[2];
+  motion.cp2_y = local_y[2];
+  motion.last_point = index_[last];
+  motion.error = error;
+  motions_->push_back(motion);
+
+  pose_x_ = bezier.x[3];
+  pose_y_ = bezier.y[3];
+  pose_heading_ = std::atan2(bezier.y[3] - bezier.y[2], bezier.x[3] - bezier.x[2]);
+}
+
+void CurveFitterImpl::addRotation(double heading, size_t point)
+{
+  double angle = wrapAngle(heading - pose_heading_);
+
+  // a second turn at the same waypoint is merged into the first one
+  if (!motions_->empty() && motions_->back().type == CurveFitter::MT_ROTATE &&
+      motions_->back().last_point == index_[point])
+  {
+    angle = wrapAngle(motions_->back().angle + angle);
+    motions_->pop_back();
+    pose_heading_ = heading;
+  }
+  if (std::fabs(angle) < MIN_ROTATION) return;
+
+  PathMotion motion;
+  motion.type = CurveFitter::MT_ROTATE;
+  motion.angle = (float) angle;
+  motion.last_point = index_[point];
+  motions_->push_back(motion);
+  pose_heading_ = heading;
+}
+
+}  // namespace zalpha_api
@@ -0,0 +1,129 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ZALPHA_API_IMPL_CURVE_FITTER_IMPL_HPP
+#define ZALPHA_API_IMPL_CURVE_FITTER_IMPL_HPP
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+#include <zalpha_api/zalpha_api_export.h>
+#include <zalpha_api/curve_fitter.hpp>
+
+
+namespace zalpha_api
+{
+
+/**
+ * \brief CurveFitterImpl is an internal implementation class that provides the Bezier curve fitting.
+ *
+ * The curves are fitted with the least-squares method of Schneider, "An Algorithm for Automatically Fitting
+ * Digitized Curves", with both end tangents fixed, and a few Newton-Raphson steps on the parameters of the
+ * waypoints. The waypoints and the per-waypoint terms are kept in separate arrays, so that the loops over them
+ * are plain arithmetic the compiler can vectorize.
+ */
+class ZALPHA_API_NO_EXPORT CurveFitterImpl
+{
+public:
+  enum
+  {
+    MAX_ITERATIONS = 4,       ///< Number of reparameterizations of a curve that does not fit
+    CURVATURE_SAMPLES = 16,   ///< Number of intervals at which the curvature of a curve is checked
+    CORNER_WINDOW = 10,       ///< Arc length over which the turn at a waypoint is measured, in tolerances
+    TANGENT_WINDOW = 5,       ///< Arc length over which the direction of the path is measured, in tolerances
+  };
+
+public:
+  CurveFitterImpl();
+  virtual ~CurveFitterImpl();
+
+  void setTolerance(double tolerance);
+  void setMinRadius(double radius);
+  void setCornerAngle(double angle);
+  bool fit(const std::vector<PathPoint>& points, double heading, std::vector<PathMotion>& motions);
+
+  int getError()
+  {
+    return errnum_;
+  }
+  std::string getErrorMessage()
+  {
+    return errmsg_;
+  }
+
+private:
+  /**
+   * \brief The outcome of fitting a curve to a span of waypoints.
+   */
+  enum FitResult
+  {
+    FIT_OK = 0,
+    FIT_TOLERANCE = 1,  ///< a waypoint is too far, a shorter span may fit
+    FIT_CURVATURE = 2,  ///< the curve turns too tightly, a longer span may fit
+  };
+  /**
+   * \brief A cubic Bezier curve in the path frame.
+   */
+  struct Bezier
+  {
+    double x[4];
+    double y[4];
+  };
+
+  void direction(size_t from, size_t to, double& tx, double& ty) const;
+  size_t behind(size_t index, size_t lowest, double distance) const;
+  size_t ahead(size_t index, size_t highest, double distance) const;
+  void findCorners();
+  void endTangent(size_t index, size_t piece_start, size_t piece_end, double& tx, double& ty) const;
+  size_t longestSpan(size_t first, size_t piece_start, size_t piece_end, double t1x, double t1y, Bezier& bezier,
+                     double& error);
+  int fitSpan(size_t first, size_t last, double t1x, double t1y, double t2x, double t2y, Bezier& bezier,
+               double& error);
+  void solveHandles(size_t first, size_t count, double t1x, double t1y, double t2x, double t2y, Bezier& bezier);
+  double maxError(size_t first, size_t count, const Bezier& bezier);
+  void reparameterize(size_t first, size_t count, const Bezier& bezier);
+  bool withinLine(size_t first, size_t last) const;
+  bool withinCurvature(const Bezier& bezier) const;
+  void addBezier(const Bezier& bezier, size_t last, double error);
+  void addRotation(double heading, size_t point);
+
+private:
+  double tolerance_;
+  double min_radius_;
+  double corner_angle_;
+
+  // the waypoints without repeats, and the parameters of the waypoints of the span being fitted
+  std::vector<double> x_;
+  std::vector<double> y_;
+  std::vector<double> s_;      ///< arc length of each waypoint
+  std::vector<size_t> index_;  ///< index of each waypoint in the points given
+  std::vector<bool> corner_;
+  std::vector<double> u_;
+
+  // the pose of the AGV at the start of the next motion
+  double pose_x_;
+  double pose_y_;
+  double pose_heading_;
+  std::vector<PathMotion>* motions_;
+
+  int errnum_;
+  std::string errmsg_;
+};
+
+}  // namespace zalpha_api
+
+#endif  // ZALPHA_API_IMPL_CURVE_FITTER_IMPL_HPP
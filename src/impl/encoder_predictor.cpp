@@ -0,0 +1,200 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "encoder_predictor.hpp"
+
+
+namespace zalpha_api
+{
+
+static const double MIN_SCALE_DISTANCE = 0.1;  // in m, below which the counts per meter are too coarse
+
+/**
+ * \brief The distance covered in dt by a wheel ramping from speed v0 towards v1 at the limits, then holding v1.
+ */
+static double ramp(double v0, double v1, double acceleration, double deceleration, double dt)
+{
+  double rate = (std::fabs(v1) > std::fabs(v0)) ? acceleration : deceleration;
+  if (rate <= 0.0)
+  {
+    return v1 * dt;
+  }
+  double ramp_time = std::fabs(v1 - v0) / rate;
+  if (dt <= ramp_time)
+  {
+    double v = v0 + ((v1 > v0) ? rate : -rate) * dt;
+    return 0.5 * (v0 + v) * dt;
+  }
+  return 0.5 * (v0 + v1) * ramp_time + v1 * (dt - ramp_time);
+}
+
+EncoderPredictor::EncoderPredictor()
+{
+  reset();
+}
+
+void EncoderPredictor::resetSamples()
+{
+  distance_.samples = 0;
+  count_.samples = 0;
+}
+
+void EncoderPredictor::reset()
+{
+  resetSamples();
+  counts_per_meter_ = 0.0;
+  has_target_ = false;
+  has_limits_ = false;
+}
+
+void EncoderPredictor::addDistance(double left, double right, int64_t time)
+{
+  add(distance_, left, right, time);
+}
+
+void EncoderPredictor::addCount(int64_t left, int64_t right, int64_t time)
+{
+  add(count_, left, right, time);
+
+  // the counts and the distances share their origin, so a reading of both gives the scale
+  if (distance_.samples > 0 && distance_.time[1] == time)
+  {
+    double distance = std::fabs(distance_.value[1][0]) + std::fabs(distance_.value[1][1]);
+    if (distance >= MIN_SCALE_DISTANCE)
+    {
+      counts_per_meter_ = (std::fabs((double) left) + std::fabs((double) right)) / distance;
+    }
+  }
+}
+
+void EncoderPredictor::setTarget(float left_speed, float right_speed, int64_t time)
+{
+  has_target_ = true;
+  target_[0] = left_speed;
+  target_[1] = right_speed;
+  target_time_ = time;
+}
+
+void EncoderPredictor::clearTarget()
+{
+  has_target_ = false;
+}
+
+void EncoderPredictor::setLimits(float acceleration, float deceleration)
+{
+  has_limits_ = true;
+  acceleration_ = acceleration;
+  deceleration_ = deceleration;
+}
+
+bool EncoderPredictor::recentDistance(int64_t now, int64_t max_age, double& left, double& right, int64_t& time) const
+{
+  double value[2];
+  if (!recent(distance_, now, max_age, value, time)) return false;
+  left = value[0];
+  right = value[1];
+  return true;
+}
+
+bool EncoderPredictor::recentCount(int64_t now, int64_t max_age, int64_t& left, int64_t& right, int64_t& time) const
+{
+  double value[2];
+  if (!recent(count_, now, max_age, value, time)) return false;
+  left = (int64_t) value[0];
+  right = (int64_t) value[1];
+  return true;
+}
+
+bool EncoderPredictor::predictDistance(int64_t now, int64_t max_age, double& left, double& right) const
+{
+  double value[2];
+  if (!predict(distance_, 1.0, now, max_age, value)) return false;
+  left = value[0];
+  right = value[1];
+  return true;
+}
+
+bool EncoderPredictor::predictCount(int64_t now, int64_t max_age, int64_t& left, int64_t& right) const
+{
+  double value[2];
+  if (!predict(count_, counts_per_meter_, now, max_age, value)) return false;
+  left = (int64_t) std::floor(value[0] + 0.5);
+  right = (int64_t) std::floor(value[1] + 0.5);
+  return true;
+}
+
+void EncoderPredictor::add(Track& track, double left, double right, int64_t time)
+{
+  if (track.samples > 0 && time <= track.time[1])
+  {
+    // a sample captured before the latest one, for eg: a reply overtaken by another thread, says nothing new
+    if (time < track.time[1]) return;
+    track.value[1][0] = left;
+    track.value[1][1] = right;
+    return;
+  }
+  track.time[0] = track.time[1];
+  track.value[0][0] = track.value[1][0];
+  track.value[0][1] = track.value[1][1];
+  track.time[1] = time;
+  track.value[1][0] = left;
+  track.value[1][1] = right;
+  track.samples = std::min(track.samples + 1, 2);
+}
+
+bool EncoderPredictor::recent(const Track& track, int64_t now, int64_t max_age, double value[2], int64_t& time) const
+{
+  if (track.samples == 0 || now - track.time[1] > max_age) return false;
+  value[0] = track.value[1][0];
+  value[1] = track.value[1][1];
+  time = track.time[1];
+  return true;
+}
+
+bool EncoderPredictor::predict(const Track& track, double scale, int64_t now, int64_t max_age, double value[2]) const
+{
+  if (track.samples == 0 || now - track.time[1] > max_age) return false;
+
+  int64_t interval = (track.samples == 2) ? track.time[1] - track.time[0] : 0;
+  bool has_slope = interval > 0 && interval <= MAX_SLOPE_INTERVAL;
+  bool has_ramp = has_target_ && scale > 0.0;
+  // without a slope, the wheels are taken to run at the target
+  if (!has_slope && !has_ramp) return false;
+
+  double age = std::max(now - track.time[1], (int64_t) 0) * 1e-6;
+  for (int wheel = 0; wheel < 2; wheel++)
+  {
+    double target = has_ramp ? target_[wheel] * scale : 0.0;
+    double speed = has_slope ? (track.value[1][wheel] - track.value[0][wheel]) / (interval * 1e-6) : target;
+    if (!has_ramp)
+    {
+      value[wheel] = track.value[1][wheel] + speed * age;
+      continue;
+    }
+
+    // the wheel holds its speed until the target was sent, then ramps towards it
+    double hold = std::min(std::max(target_time_ - track.time[1], (int64_t) 0) * 1e-6, age);
+    double acceleration = has_limits_ ? acceleration_ * scale : 0.0;
+    double deceleration = has_limits_ ? deceleration_ * scale : 0.0;
+    value[wheel] = track.value[1][wheel] + speed * hold + ramp(speed, target, acceleration, deceleration, age - hold);
+  }
+  return true;
+}
+
+}  // namespace zalpha_api
@@ -0,0 +1,113 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ZALPHA_API_IMPL_ENCODER_PREDICTOR_HPP
+#define ZALPHA_API_IMPL_ENCODER_PREDICTOR_HPP
+
+#include <stdint.h>
+
+#include <zalpha_api/zalpha_api_export.h>
+
+
+namespace zalpha_api
+{
+
+/**
+ * \brief EncoderPredictor keeps the last encoder samples, and extrapolates them with a model of the wheels.
+ *
+ * The speed of each wheel is the slope of the last two samples. When the client commanded a target speed,
+ * the wheel holds its speed until the command, then ramps towards the target at the acceleration limits.
+ * Otherwise, for eg: while an action drives the wheels, the wheel holds its speed.
+ *
+ * The distances and the raw counts are tracked separately. The raw counts ramp towards the target once
+ * the counts per meter are known from a reading that carries both, such as GET_TELEMETRY.
+ */
+class ZALPHA_API_NO_EXPORT EncoderPredictor
+{
+public:
+  enum
+  {
+    MAX_SLOPE_INTERVAL = 1000000,  ///< Longest time between two samples that still gives the speed, in us
+  };
+
+public:
+  EncoderPredictor();
+
+  /**
+   * \brief Forget the samples, after the encoders were reset.
+   */
+  void resetSamples();
+  /**
+   * \brief Forget everything, after a new connection.
+   */
+  void reset();
+
+  void addDistance(double left, double right, int64_t time);
+  void addCount(int64_t left, int64_t right, int64_t time);
+  void setTarget(float left_speed, float right_speed, int64_t time);
+  /**
+   * \brief Forget the target, the wheels are driven at speeds unknown to the client.
+   */
+  void clearTarget();
+  void setLimits(float acceleration, float deceleration);
+  bool hasLimits() const
+  {
+    return has_limits_;
+  }
+
+  /**
+   * \brief The last distances, when they were captured at most max_age ago.
+   */
+  bool recentDistance(int64_t now, int64_t max_age, double& left, double& right, int64_t& time) const;
+  bool recentCount(int64_t now, int64_t max_age, int64_t& left, int64_t& right, int64_t& time) const;
+  /**
+   * \brief The distances extrapolated to now, from the last ones when they were captured at most max_age ago.
+   */
+  bool predictDistance(int64_t now, int64_t max_age, double& left, double& right) const;
+  bool predictCount(int64_t now, int64_t max_age, int64_t& left, int64_t& right) const;
+
+private:
+  /**
+   * \brief The last two samples of a kind, in the units of the kind.
+   */
+  struct Track
+  {
+    int samples;
+    int64_t time[2];     ///< [1] is the latest
+    double value[2][2];  ///< [sample][wheel]
+  };
+
+  static void add(Track& track, double left, double right, int64_t time);
+  bool recent(const Track& track, int64_t now, int64_t max_age, double value[2], int64_t& time) const;
+  bool predict(const Track& track, double scale, int64_t now, int64_t max_age, double value[2]) const;
+
+private:
+  Track distance_;
+  Track count_;
+  double counts_per_meter_;  ///< 0 until a reading carried both
+
+  bool has_target_;
+  float target_[2];
+  int64_t target_time_;
+
+  bool has_limits_;
+  float acceleration_;
+  float deceleration_;
+};
+
+}  // namespace zalpha_api
+
+#endif  // ZALPHA_API_IMPL_ENCODER_PREDICTOR_HPP
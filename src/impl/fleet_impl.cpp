@@ -0,0 +1,334 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cerrno>
+#include <pthread.h>
+#include <algorithm>
+
+#include "fleet_impl.hpp"
+#include "monotonic_clock.hpp"
+#include "transport.hpp"
+
+
+namespace zalpha_api
+{
+
+FleetImpl::FleetImpl() :
+  addresses_(NULL), report_(NULL), timeout_(0), probes_(0), next_(0)
+{
+}
+
+FleetImpl::~FleetImpl()
+{
+  disconnect();
+}
+
+size_t FleetImpl::bringUp(const std::vector<std::string>& addresses, std::vector<RobotHandshake>& report,
+                          int parallelism, int timeout, int probes)
+{
+  disconnect();
+
+  robots_.resize(addresses.size());
+  for (size_t i = 0; i < robots_.size(); i++)
+  {
+    robots_[i] = new Zalpha();
+  }
+  ready_.assign(addresses.size(), false);
+  report.assign(addresses.size(), RobotHandshake());
+
+  addresses_ = &addresses;
+  report_ = &report;
+  timeout_ = timeout;
+  probes_ = probes;
+  next_ = 0;
+
+  // the workers take the robots in turn, the calling thread is one of them
+  size_t num_workers = std::min((size_t) std::max(parallelism, 1), addresses.size());
+  std::vector<pthread_t> workers;
+  for (size_t i = 1; i < num_workers; i++)
+  {
+    pthread_t worker;
+    if (pthread_create(&worker, NULL, &FleetImpl::workerMain, this) != 0) break;
+    workers.push_back(worker);
+  }
+  work();
+  for (size_t i = 0; i < workers.size(); i++)
+  {
+    pthread_join(workers[i], NULL);
+  }
+
+  size_t num_ready = 0;
+  for (size_t i = 0; i < report.size(); i++)
+  {
+    ready_[i] = report[i].reachable && report[i].compatible;
+    if (ready_[i]) num_ready++;
+  }
+  openLanes(addresses);
+  addresses_ = NULL;
+  report_ = NULL;
+  return num_ready;
+}
+
+void FleetImpl::disconnect()
+{
+  for (size_t i = 0; i < robots_.size(); i++)
+  {
+    delete robots_[i];
+  }
+  robots_.clear();
+  ready_.clear();
+
+  for (size_t i = 0; i < lanes_.size(); i++)
+  {
+    if (!lanes_[i]) continue;
+    lanes_[i]->disconnect();
+    delete lanes_[i];
+  }
+  lanes_.clear();
+}
+
+size_t FleetImpl::broadcast(Packet& packet, uint16_t command, BroadcastReport& report,
+                            const std::vector<size_t>& selection, int deadline)
+{
+  report = BroadcastReport();
+  report.acks.assign(robots_.size(), BroadcastAck());
+
+  std::vector<size_t> targets;
+  for (size_t i = 0; i < (selection.empty() ? lanes_.size() : selection.size()); i++)
+  {
+    size_t index = selection.empty() ? i : selection[i];
+    if (selection.empty() && !lanes_[index]) continue;
+    if (index >= robots_.size() || report.acks[index].selected) continue;
+
+    BroadcastAck& ack = report.acks[index];
+    ack.selected = true;
+    report.num_selected++;
+    if (!lanes_[index])
+    {
+      fail(ack, Packet::DISCONNECTED, "Robot is not connected.");
+      continue;
+    }
+    targets.push_back(index);
+  }
+  if (targets.empty()) return 0;
+
+  // the requests go out back to back, the replies are only waited for once all of them are sent
+  packet.command = command;
+  std::vector<size_t> pending;
+  int64_t start = monotonicNow();
+  for (size_t i = 0; i < targets.size(); i++)
+  {
+    Transport& lane = *lanes_[targets[i]];
+    if (!lane.sendRequest(packet))
+    {
+      fail(report.acks[targets[i]], lane.getError(), lane.getErrorMessage());
+      continue;
+    }
+    pending.push_back(targets[i]);
+  }
+  report.fan_out = monotonicNow() - start;
+
+  int64_t end = start + (int64_t) deadline * 1000;
+  std::vector<zmq_pollitem_t> items;
+  std::vector<size_t> polled;
+  while (!pending.empty())
+  {
+    int64_t remaining = end - monotonicNow();
+    if (remaining <= 0) break;
+
+    items.clear();
+    polled.clear();
+    std::vector<size_t> waiting;
+    for (size_t i = 0; i < pending.size(); i++)
+    {
+      zmq_pollitem_t item;
+      if (lanes_[pending[i]]->getPollItem(item))
+      {
+        items.push_back(item);
+        polled.push_back(pending[i]);
+      }
+      else
+      {
+        waiting.push_back(pending[i]);
+      }
+    }
+
+    pending.clear();
+    if (!waiting.empty())
+    {
+      // a lane that cannot be polled, for eg: shm://, is waited on alone, it answers within microseconds
+      Transport& lane = *lanes_[waiting[0]];
+      lane.setTimeout((int) ((remaining + 999) / 1000));
+      receive(waiting[0], command, start, report);
+      lane.setTimeout(0);
+      pending.insert(pending.end(), waiting.begin() + 1, waiting.end());
+      pending.insert(pending.end(), polled.begin(), polled.end());
+      continue;
+    }
+
+    if (zmq_poll(&items[0], (int) items.size(), (long) ((remaining + 999) / 1000)) < 0 && zmq_errno() != EINTR)
+    {
+      pending = polled;
+      break;
+    }
+    for (size_t i = 0; i < items.size(); i++)
+    {
+      if (!(items[i].revents & ZMQ_POLLIN) || !receive(polled[i], command, start, report))
+      {
+        pending.push_back(polled[i]);
+      }
+    }
+  }
+
+  for (size_t i = 0; i < pending.size(); i++)
+  {
+    // a zero-timeout wait drops the request, so that the lane is ready for the next broadcast
+    Packet reply;
+    lanes_[pending[i]]->waitReply(reply);
+    fail(report.acks[pending[i]], Packet::TIMEOUT, "Timed out waiting for acknowledgement.");
+  }
+  return report.num_acknowledged;
+}
+
+void* FleetImpl::workerMain(void* arg)
+{
+  static_cast<FleetImpl*>(arg)->work();
+  return NULL;
+}
+
+void FleetImpl::work()
+{
+  for (;;)
+  {
+    size_t index = next_++;
+    if (index >= addresses_->size()) break;
+    handshake(index);
+  }
+}
+
+void FleetImpl::openLanes(const std::vector<std::string>& addresses)
+{
+  lanes_.assign(robots_.size(), NULL);
+  for (size_t i = 0; i < robots_.size(); i++)
+  {
+    if (!ready_[i]) continue;
+
+    std::string url = Transport::resolveUrl(addresses[i]);
+    Transport* lane = Transport::create(url);
+    if (!lane) continue;
+    // the lanes never block, the broadcast waits on all of them at once
+    lane->setTimeout(0);
+    if (!lane->connect(url))
+    {
+      delete lane;
+      continue;
+    }
+    lanes_[i] = lane;
+  }
+}
+
+bool FleetImpl::receive(size_t index, uint16_t command, int64_t start, BroadcastReport& report)
+{
+  Transport& lane = *lanes_[index];
+  BroadcastAck& ack = report.acks[index];
+  Packet reply;
+  reply.command = 0;
+  if (!lane.waitReply(reply))
+  {
+    // a readable socket may only hold a late reply of an earlier request
+    if (lane.getError() == Packet::TIMEOUT) return false;
+    fail(ack, lane.getError(), lane.getErrorMessage());
+    return true;
+  }
+
+  ack.latency = monotonicNow() - start;
+  if (reply.command != command)
+  {
+    fail(ack, Packet::INVALID_REPLY, "Invalid reply format.");
+  }
+  else if (reply.data.u16[0] == Packet::RESULT_OK)
+  {
+    ack.acknowledged = true;
+    if (report.num_acknowledged++ == 0)
+    {
+      report.first_ack = ack.latency;
+    }
+    report.last_ack = ack.latency;
+    report.spread = report.last_ack - report.first_ack;
+  }
+  else if (reply.data.u16[0] == Packet::RESULT_ERROR_INVALID_COMMAND)
+  {
+    fail(ack, Packet::RESULT_ERROR_INVALID_COMMAND, "Invalid parameters in API call.");
+  }
+  else if (reply.data.u16[0] == Packet::RESULT_ERROR_BUSY)
+  {
+    fail(ack, Packet::RESULT_ERROR_BUSY, "Target is busy.");
+  }
+  else if (reply.data.u16[0] == Packet::RESULT_ERROR_EXPIRED)
+  {
+    fail(ack, Packet::RESULT_ERROR_EXPIRED, "Command expired before it was executed.");
+  }
+  else
+  {
+    fail(ack, Packet::UNKNOWN_ERROR, "Unknown error.");
+  }
+  return true;
+}
+
+void FleetImpl::fail(BroadcastAck& ack, int errnum, const std::string& errmsg)
+{
+  ack.error = errnum;
+  ack.error_message = errmsg;
+}
+
+void FleetImpl::handshake(size_t index)
+{
+  Zalpha& robot = *robots_[index];
+  RobotHandshake& result = (*report_)[index];
+  result.address = (*addresses_)[index];
+
+  robot.setTimeout(timeout_);
+  if (!robot.connect(result.address))
+  {
+    result.error = robot.getError();
+    result.error_message = robot.getErrorMessage();
+    return;
+  }
+
+  // the first command waits for the connection, the next ones measure the round trip alone
+  int64_t start = monotonicNow();
+  if (!robot.versionInfo(result.version))
+  {
+    result.error = robot.getError();
+    result.error_message = robot.getErrorMessage();
+    robot.disconnect();
+    return;
+  }
+  result.handshake_time = monotonicNow() - start;
+  result.round_trip = result.handshake_time;
+  result.reachable = true;
+  result.compatible = versionCompatible(result.version);
+
+  std::string version;
+  for (int i = 0; i < probes_; i++)
+  {
+    start = monotonicNow();
+    if (!robot.versionInfo(version)) break;
+    result.round_trip = std::min(result.round_trip, monotonicNow() - start);
+  }
+}
+
+}  // namespace zalpha_api
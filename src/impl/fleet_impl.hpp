@@ -0,0 +1,86 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ZALPHA_API_IMPL_FLEET_IMPL_HPP
+#define ZALPHA_API_IMPL_FLEET_IMPL_HPP
+
+#include <stddef.h>
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include <zalpha_api/zalpha_api_export.h>
+#include <zalpha_api/fleet.hpp>
+#include "packet.hpp"
+
+
+namespace zalpha_api
+{
+
+class ZALPHA_API_NO_EXPORT Transport;
+
+/**
+ * \brief FleetImpl is an internal implementation class that provides the fleet bring-up and the broadcast commands.
+ */
+class ZALPHA_API_NO_EXPORT FleetImpl
+{
+public:
+  FleetImpl();
+  virtual ~FleetImpl();
+
+  size_t bringUp(const std::vector<std::string>& addresses, std::vector<RobotHandshake>& report,
+                 int parallelism, int timeout, int probes);
+  void disconnect();
+
+  size_t size() const
+  {
+    return robots_.size();
+  }
+  Zalpha& robot(size_t index)
+  {
+    return *robots_.at(index);
+  }
+  bool isReady(size_t index) const
+  {
+    return ready_.at(index);
+  }
+  size_t broadcast(Packet& packet, uint16_t command, BroadcastReport& report, const std::vector<size_t>& selection,
+                   int deadline);
+
+private:
+  static void* workerMain(void* arg);
+  void work();
+  void handshake(size_t index);
+  void openLanes(const std::vector<std::string>& addresses);
+  bool receive(size_t index, uint16_t command, int64_t start, BroadcastReport& report);
+  static void fail(BroadcastAck& ack, int errnum, const std::string& errmsg);
+
+private:
+  std::vector<Zalpha*> robots_;
+  std::vector<bool> ready_;
+  std::vector<Transport*> lanes_;  ///< the broadcast lane of each robot, NULL when it is not ready
+
+  // the state of a bring-up, shared by its workers
+  const std::vector<std::string>* addresses_;
+  std::vector<RobotHandshake>* report_;
+  int timeout_;
+  int probes_;
+  std::atomic<size_t> next_;
+};
+
+}  // namespace zalpha_api
+
+#endif  // ZALPHA_API_IMPL_FLEET_IMPL_HPP
@@ -0,0 +1,333 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include "io_manager_impl.hpp"
+#include "monotonic_clock.hpp"
+#include "packet.hpp"
+
+
+namespace zalpha_api
+{
+
+IoManagerImpl::IoManagerImpl() :
+  timeout_(DEFAULT_TIMEOUT), timeout_changed_(false), flush_window_(DEFAULT_FLUSH_WINDOW), poll_interval_(DEFAULT_POLL_INTERVAL),
+  running_(false),
+  pending_outputs_(0), pending_mask_(0), flush_deadline_(0), write_in_flight_(false), write_failed_(false),
+  has_inputs_(false), inputs_(0), inputs_timestamp_(0), next_poll_(0),
+  event_count_(0)
+{
+  WorkerThread::initCondition(&wake_);
+  WorkerThread::initCondition(&idle_);
+  WorkerThread::initCondition(&events_);
+
+  resetStatistics();
+}
+
+IoManagerImpl::~IoManagerImpl()
+{
+  disconnect();
+  pthread_cond_destroy(&events_);
+  pthread_cond_destroy(&idle_);
+  pthread_cond_destroy(&wake_);
+}
+
+bool IoManagerImpl::connect(const std::string& server_address)
+{
+  if (running_)
+  {
+    worker_.setError(Packet::CONNECTED, "Already connected to API server.");
+    return false;
+  }
+  if (!zalpha_.connect(server_address))
+  {
+    worker_.setCommandError(zalpha_);
+    return false;
+  }
+  zalpha_.setTimeout(timeout_, 0);
+  timeout_changed_ = false;
+
+  pending_mask_ = 0;
+  write_in_flight_ = write_failed_ = false;
+  has_inputs_ = false;
+  next_poll_ = monotonicNow();
+  resetStatistics();
+
+  running_ = true;
+  int error = worker_.start(&IoManagerImpl::threadMain, this);
+  if (error != 0)
+  {
+    running_ = false;
+    zalpha_.disconnect();
+    worker_.setSystemError("Failed to start the I/O thread", error);
+    return false;
+  }
+  return true;
+}
+
+void IoManagerImpl::disconnect()
+{
+  worker_.lock();
+  bool running = running_;
+  running_ = false;
+  pthread_cond_signal(&wake_);
+  pthread_cond_broadcast(&idle_);
+  pthread_cond_broadcast(&events_);
+  worker_.unlock();
+  if (!running) return;
+
+  worker_.join();
+  zalpha_.disconnect();
+}
+
+void IoManagerImpl::setTimeout(int timeout)
+{
+  // applied by the I/O thread, the only user of the connection while it runs
+  worker_.lock();
+  timeout_ = timeout;
+  timeout_changed_ = true;
+  pthread_cond_signal(&wake_);
+  worker_.unlock();
+}
+
+void IoManagerImpl::setFlushWindow(int window)
+{
+  worker_.lock();
+  flush_window_ = std::max(window, 0) * 1000;
+  worker_.unlock();
+}
+
+void IoManagerImpl::setPollInterval(int interval)
+{
+  worker_.lock();
+  poll_interval_ = std::max(interval, 0) * 1000;
+  next_poll_ = monotonicNow();
+  pthread_cond_signal(&wake_);
+  worker_.unlock();
+}
+
+void IoManagerImpl::writeOutputs(uint32_t outputs, uint32_t mask)
+{
+  worker_.lock();
+  statistics_.writes++;
+  if (pending_mask_ == 0)
+  {
+    flush_deadline_ = monotonicNow() + flush_window_;
+    pthread_cond_signal(&wake_);
+  }
+  Packet::mergeOutputs(pending_outputs_, pending_mask_, outputs, mask);
+  worker_.unlock();
+}
+
+bool IoManagerImpl::flush(int timeout)
+{
+  int64_t deadline = (timeout >= 0) ? monotonicNow() + timeout * 1000LL : -1;
+
+  worker_.lock();
+  if (pending_mask_ != 0)
+  {
+    // no need to wait for the end of the window
+    flush_deadline_ = monotonicNow();
+    pthread_cond_signal(&wake_);
+  }
+  while (running_ && (pending_mask_ != 0 || write_in_flight_))
+  {
+    if (!worker_.wait(&idle_, deadline)) break;
+  }
+  bool success = running_ && pending_mask_ == 0 && !write_in_flight_ && !write_failed_;
+  worker_.unlock();
+  return success;
+}
+
+bool IoManagerImpl::getInputs(uint32_t& inputs, int64_t& timestamp)
+{
+  worker_.lock();
+  bool has_inputs = has_inputs_;
+  inputs = inputs_;
+  timestamp = inputs_timestamp_;
+  worker_.unlock();
+  return has_inputs;
+}
+
+bool IoManagerImpl::waitInputEvent(uint32_t rising_mask, uint32_t falling_mask, InputEvent& event, int timeout)
+{
+  int64_t deadline = (timeout >= 0) ? monotonicNow() + timeout * 1000LL : -1;
+
+  worker_.lock();
+  uint64_t next = event_count_;
+  bool found = false;
+  while (running_ && !found)
+  {
+    // the events older than the buffer are lost to a waiter that was not scheduled in time
+    next = std::max(next, (event_count_ > EVENT_BUFFER_SIZE) ? event_count_ - EVENT_BUFFER_SIZE : 0);
+    for (; next < event_count_ && !found; next++)
+    {
+      const InputEvent& candidate = event_buffer_[next % EVENT_BUFFER_SIZE];
+      if ((candidate.rising & rising_mask) || (candidate.falling & falling_mask))
+      {
+        event = candidate;
+        found = true;
+      }
+    }
+    if (!found && !worker_.wait(&events_, deadline)) break;
+  }
+  worker_.unlock();
+  return found;
+}
+
+void IoManagerImpl::getStatistics(IoStatistics& statistics)
+{
+  worker_.lock();
+  statistics = statistics_;
+  worker_.unlock();
+}
+
+void IoManagerImpl::resetStatistics()
+{
+  worker_.lock();
+  std::memset(&statistics_, 0, sizeof(statistics_));
+  worker_.unlock();
+}
+
+int IoManagerImpl::getError()
+{
+  return worker_.getError();
+}
+
+std::string IoManagerImpl::getErrorMessage()
+{
+  return worker_.getErrorMessage();
+}
+
+void* IoManagerImpl::threadMain(void* arg)
+{
+  static_cast<IoManagerImpl*>(arg)->run();
+  return NULL;
+}
+
+void IoManagerImpl::run()
+{
+  worker_.lock();
+  while (running_)
+  {
+    if (timeout_changed_)
+    {
+      zalpha_.setTimeout(timeout_, 0);
+      timeout_changed_ = false;
+    }
+
+    int64_t now = monotonicNow();
+    int64_t wake = -1;
+
+    if (pending_mask_ != 0)
+    {
+      if (now >= flush_deadline_)
+      {
+        sendOutputs();
+        continue;
+      }
+      wake = flush_deadline_;
+    }
+    if (poll_interval_ > 0)
+    {
+      if (now >= next_poll_)
+      {
+        pollInputs(now);
+        continue;
+      }
+      wake = (wake < 0) ? next_poll_ : std::min(wake, next_poll_);
+    }
+    worker_.wait(&wake_, wake);
+  }
+  worker_.unlock();
+}
+
+void IoManagerImpl::sendOutputs()
+{
+  uint32_t outputs = pending_outputs_;
+  uint32_t mask = pending_mask_;
+  pending_mask_ = 0;
+  write_in_flight_ = true;
+  worker_.unlock();
+
+  bool success = zalpha_.setOutputs(outputs, mask);
+
+  worker_.lock();
+  write_in_flight_ = false;
+  write_failed_ = !success;
+  statistics_.flushes++;
+  if (!success)
+  {
+    setCommandError();
+
+    // merge back the outputs that were not written again in the meantime, and retry later
+    if (pending_mask_ == 0)
+    {
+      flush_deadline_ = monotonicNow() + RETRY_INTERVAL;
+    }
+    Packet::mergeOutputs(pending_outputs_, pending_mask_, outputs, mask & ~pending_mask_);
+  }
+  pthread_cond_broadcast(&idle_);
+}
+
+void IoManagerImpl::pollInputs(int64_t now)
+{
+  // keep the cadence, unless the poll is late by a whole interval
+  next_poll_ += poll_interval_;
+  if (next_poll_ <= now)
+  {
+    next_poll_ = now + poll_interval_;
+  }
+  worker_.unlock();
+
+  uint32_t inputs;
+  int64_t timestamp;
+  bool success = zalpha_.getInputs(inputs, timestamp);
+
+  worker_.lock();
+  statistics_.polls++;
+  if (!success)
+  {
+    setCommandError();
+    return;
+  }
+
+  uint32_t changed = inputs ^ inputs_;
+  if (has_inputs_ && changed != 0)
+  {
+    InputEvent& event = event_buffer_[event_count_ % EVENT_BUFFER_SIZE];
+    event.rising = changed & inputs;
+    event.falling = changed & ~inputs;
+    event.inputs = inputs;
+    event.timestamp = timestamp;
+    event_count_++;
+    statistics_.events++;
+    pthread_cond_broadcast(&events_);
+  }
+  has_inputs_ = true;
+  inputs_ = inputs;
+  inputs_timestamp_ = timestamp;
+}
+
+void IoManagerImpl::setCommandError()
+{
+  statistics_.failures++;
+  worker_.setCommandError(zalpha_);
+}
+
+}  // namespace zalpha_api
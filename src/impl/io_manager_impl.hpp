@@ -0,0 +1,106 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ZALPHA_API_IMPL_IO_MANAGER_IMPL_HPP
+#define ZALPHA_API_IMPL_IO_MANAGER_IMPL_HPP
+
+#include <pthread.h>
+#include <stdint.h>
+#include <string>
+
+#include <zalpha_api/zalpha_api_export.h>
+#include <zalpha_api/io_manager.hpp>
+#include "worker_thread.hpp"
+#include "zalpha_impl.hpp"
+
+
+namespace zalpha_api
+{
+
+/**
+ * \brief IoManagerImpl is an internal implementation class that provides the I/O thread.
+ */
+class ZALPHA_API_NO_EXPORT IoManagerImpl
+{
+public:
+  enum
+  {
+    DEFAULT_TIMEOUT = 500,          ///< Timeout of the commands, in ms
+    DEFAULT_FLUSH_WINDOW = 2000,    ///< Time during which the writes are merged, in us
+    DEFAULT_POLL_INTERVAL = 10000,  ///< Interval between the polls of the inputs, in us
+    RETRY_INTERVAL = 100000,        ///< Interval between the attempts of a failed write, in us
+    EVENT_BUFFER_SIZE = 64,         ///< Number of recent events kept for the waiters
+  };
+
+public:
+  IoManagerImpl();
+  virtual ~IoManagerImpl();
+
+  bool connect(const std::string& server_address);
+  void disconnect();
+  void setTimeout(int timeout);
+  void setFlushWindow(int window);
+  void setPollInterval(int interval);
+  void writeOutputs(uint32_t outputs, uint32_t mask);
+  bool flush(int timeout);
+  bool getInputs(uint32_t& inputs, int64_t& timestamp);
+  bool waitInputEvent(uint32_t rising_mask, uint32_t falling_mask, InputEvent& event, int timeout);
+  void getStatistics(IoStatistics& statistics);
+  void resetStatistics();
+
+  int getError();
+  std::string getErrorMessage();
+
+private:
+  static void* threadMain(void* arg);
+  void run();
+  void sendOutputs();
+  void pollInputs(int64_t now);
+  void setCommandError();
+
+private:
+  ZalphaImpl zalpha_;
+  int timeout_;
+  bool timeout_changed_;  ///< the timeout is applied by the I/O thread, the only user of the connection
+  int flush_window_;
+  int poll_interval_;
+
+  WorkerThread worker_;  ///< its mutex guards the outputs, the inputs and the events
+  bool running_;
+  pthread_cond_t wake_;    ///< signals the I/O thread of a write or a new setting
+  pthread_cond_t idle_;    ///< signals the flushers of a completed write
+  pthread_cond_t events_;  ///< signals the waiters of a new input event
+
+  uint32_t pending_outputs_;
+  uint32_t pending_mask_;     ///< the outputs written since the last flush
+  int64_t flush_deadline_;
+  bool write_in_flight_;
+  bool write_failed_;
+
+  bool has_inputs_;
+  uint32_t inputs_;
+  int64_t inputs_timestamp_;
+  int64_t next_poll_;
+
+  InputEvent event_buffer_[EVENT_BUFFER_SIZE];
+  uint64_t event_count_;
+
+  IoStatistics statistics_;
+};
+
+}  // namespace zalpha_api
+
+#endif  // ZALPHA_API_IMPL_IO_MANAGER_IMPL_HPP
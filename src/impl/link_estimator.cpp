@@ -0,0 +1,92 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "link_estimator.hpp"
+
+
+namespace zalpha_api
+{
+
+static const double RTT_GAIN = 1.0 / 8;
+static const double VARIATION_GAIN = 1.0 / 4;
+static const double LOSS_GAIN = 1.0 / 16;
+
+LinkEstimator::LinkEstimator()
+{
+  reset();
+}
+
+void LinkEstimator::reset()
+{
+  round_trips_ = 0;
+  losses_ = 0;
+  rtt_ = 0.0;
+  rtt_variation_ = 0.0;
+  loss_rate_ = 0.0;
+  max_ = 0;
+}
+
+void LinkEstimator::addRoundTrip(int64_t rtt)
+{
+  if (round_trips_ == 0)
+  {
+    // the first sample seeds the estimates as in RFC 6298
+    rtt_ = rtt;
+    rtt_variation_ = rtt / 2.0;
+  }
+  else
+  {
+    rtt_variation_ += VARIATION_GAIN * (std::fabs(rtt_ - rtt) - rtt_variation_);
+    rtt_ += RTT_GAIN * (rtt - rtt_);
+  }
+  loss_rate_ -= LOSS_GAIN * loss_rate_;
+  max_ = std::max(max_, rtt);
+  window_[round_trips_ % WINDOW] = rtt;
+  round_trips_++;
+}
+
+void LinkEstimator::addLoss()
+{
+  loss_rate_ += LOSS_GAIN * (1.0 - loss_rate_);
+  losses_++;
+}
+
+void LinkEstimator::getQuality(LinkQuality& quality) const
+{
+  quality.round_trips = round_trips_;
+  quality.losses = losses_;
+  quality.rtt = rtt_;
+  quality.rtt_variation = rtt_variation_;
+  quality.loss_rate = loss_rate_;
+  quality.max = max_;
+  quality.min = quality.p50 = quality.p90 = quality.p99 = 0;
+
+  size_t count = (size_t) std::min<uint64_t>(round_trips_, WINDOW);
+  if (count == 0) return;
+
+  std::vector<int64_t> sorted(window_, window_ + count);
+  std::sort(sorted.begin(), sorted.end());
+  quality.min = sorted[0];
+  quality.p50 = sorted[(count - 1) * 50 / 100];
+  quality.p90 = sorted[(count - 1) * 90 / 100];
+  quality.p99 = sorted[(count - 1) * 99 / 100];
+}
+
+}  // namespace zalpha_api
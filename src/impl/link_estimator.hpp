@@ -0,0 +1,67 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ZALPHA_API_IMPL_LINK_ESTIMATOR_HPP
+#define ZALPHA_API_IMPL_LINK_ESTIMATOR_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <zalpha_api/zalpha_api_export.h>
+#include <zalpha_api/zalpha.hpp>
+
+
+namespace zalpha_api
+{
+
+/**
+ * \brief LinkEstimator follows the round-trip time and the loss rate of a link, see LinkQuality.
+ */
+class ZALPHA_API_NO_EXPORT LinkEstimator
+{
+public:
+  enum
+  {
+    WINDOW = 256,  ///< Number of the most recent round trips kept for the percentiles
+  };
+
+public:
+  LinkEstimator();
+
+  void reset();
+  /**
+   * \brief Add the round-trip time of a request that got its reply, in us.
+   */
+  void addRoundTrip(int64_t rtt);
+  /**
+   * \brief Add a request whose reply timed out.
+   */
+  void addLoss();
+  void getQuality(LinkQuality& quality) const;
+
+private:
+  uint64_t round_trips_;
+  uint64_t losses_;
+  double rtt_;
+  double rtt_variation_;
+  double loss_rate_;
+  int64_t max_;
+  int64_t window_[WINDOW];  ///< ring of the most recent round-trip times
+};
+
+}  // namespace zalpha_api
+
+#endif  // ZALPHA_API_IMPL_LINK_ESTIMATOR_HPP
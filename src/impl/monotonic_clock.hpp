@@ -0,0 +1,53 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ZALPHA_API_IMPL_MONOTONIC_CLOCK_HPP
+#define ZALPHA_API_IMPL_MONOTONIC_CLOCK_HPP
+
+#include <stdint.h>
+#include <time.h>
+
+
+namespace zalpha_api
+{
+
+/**
+ * \brief The time of CLOCK_MONOTONIC, in microseconds.
+ *
+ * This is the one clock of the library, ClockSync::now() included, so that its times can be compared with each
+ * other and passed to the POSIX waits through toTimespec().
+ */
+inline int64_t monotonicNow()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/**
+ * \brief Convert a time of CLOCK_MONOTONIC in microseconds, for clock_nanosleep() and pthread_cond_timedwait().
+ */
+inline struct timespec toTimespec(int64_t time)
+{
+  struct timespec ts;
+  ts.tv_sec = time / 1000000;
+  ts.tv_nsec = (time % 1000000) * 1000;
+  return ts;
+}
+
+}  // namespace zalpha_api
+
+#endif  // ZALPHA_API_IMPL_MONOTONIC_CLOCK_HPP
@@ -17,6 +17,9 @@
 #ifndef ZALPHA_API_IMPL_PACKET_HPP
 #define ZALPHA_API_IMPL_PACKET_HPP
 
+#include <stdint.h>
+#include <cstring>
+
 #include <zalpha_api/zalpha_api_export.h>
 
 
@@ -31,13 +34,34 @@ namespace zalpha_api
  * <table>
  * <tr><th>Byte Offset</th><th>Size (bytes)</th><th>Description</th></tr>
  * <tr><td>0 - 1</td><td>2</td><td>Command</td></tr>
- * <tr><td>2 - 7</td><td>6</td><td>Reserved</td></tr>
+ * <tr><td>2 - 3</td><td>2</td><td>Sequence number (reserved[0]), 0 when unused</td></tr>
+ * <tr><td>4 - 7</td><td>4</td><td>Deadline (reserved[1] - reserved[2]), 0 when unused</td></tr>
  * <tr><td>8 - 71</td><td>64</td><td>Data</td></tr>
  * </table>
  *
  * All the integer and floating-point data types uses a little-endian (LE) machine format.
  *
  * Both request and reply will share the same data packet format.
+ *
+ * The sequence number is set by transports that may reorder or lose packets, such as UDP.
+ * The server copies it from the request into the reply.
+ *
+ * The replies of the encoder, safety flag and input readings carry the time at which the reading was captured in
+ * data.u64[TIMESTAMP_INDEX] (data bytes 24 - 31), in microseconds of the monotonic clock of the robot, or 0 when
+ * the server does not stamp its readings. The TIME_SYNC command relates the robot clock to the client clock:
+ * its reply carries the robot time at which the request was received in data.u64[0] and the robot time at which
+ * the reply was sent in data.u64[1].
+ *
+ * A motion request may carry a deadline, the low 32 bits of the robot time in microseconds beyond which it must not
+ * be executed. The server rejects a request received after its deadline with RESULT_ERROR_EXPIRED, so that the
+ * setpoints queued during a stall of the link are dropped instead of being executed late.
+ *
+ * The motion and halt requests may carry the halt epoch of the client in data.u32[HALT_EPOCH_INDEX] (data bytes
+ * 32 - 35), 0 when unused. Its high 16 bits identify the client, and its low 16 bits count the halt requests of the
+ * client: a halt request carries its own count, and a motion request the count of the halts issued before it.
+ * The server rejects with RESULT_ERROR_EXPIRED a motion request whose count is behind that of a halt request of
+ * the same client it already executed, so that a motion overtaken by a halt on the priority lane of the client is
+ * not executed after it.
  */
 class ZALPHA_API_NO_EXPORT Packet
 {
@@ -49,6 +73,8 @@ public:
   {
     /* General */
     VERSION_INFO = 0xFA00,
+    SET_ENCODING,
+    TIME_SYNC,
     /* Differential Base */
     SET_ACCELERATION = 0xFA10,
     GET_ACCELERATION,
@@ -68,6 +94,7 @@ public:
     GET_SAFETY_FLAG = 0xFA30,
     GET_ENCODER_AND_SAFETY_FLAG,
     GET_RAW_ENCODER_AND_SAFETY_FLAG,
+    GET_TELEMETRY,
     /* Power */
     GET_BATTERY = 0xFA40,
     SET_CHARGING,
@@ -80,19 +107,155 @@ public:
     RESULT_OK = 0xF900,
     RESULT_ERROR_INVALID_COMMAND = 0xF901,
     RESULT_ERROR_BUSY = 0xF902,
+    RESULT_ERROR_EXPIRED = 0xF903,
     INVALID_REPLY = 0xF910,
     UNKNOWN_ERROR = 0xF911,
+    INVALID_ENDPOINT = 0xF912,
+    TIMEOUT = 0xF913,
+    SYSTEM_ERROR = 0xF914,
     CONNECTED = 0xF920,
     DISCONNECTED = 0xF921,
   };
   enum
   {
     MAX_PAYLOAD = 64,  // must be a multiple of 8.
+    TIMESTAMP_INDEX = 3,  // index in data.u64 of the capture time of the readings.
+    HALT_EPOCH_INDEX = 8,  // index in data.u32 of the halt epoch of the motion and halt requests.
   };
 
+public:
+  /**
+   * \brief Constructor, clears the packet to zero.
+   */
+  Packet()
+  {
+    std::memset(this, 0, sizeof(Packet));
+  }
+
+  /**
+   * \brief Whether a command only reads the server state, and can be repeated safely.
+   */
+  static bool isIdempotent(uint16_t command)
+  {
+    switch (command)
+    {
+    case VERSION_INFO:
+    case TIME_SYNC:
+    case GET_ACCELERATION:
+    case GET_TARGET_SPEED:
+    case GET_ACTION_STATUS:
+    case GET_ENCODER:
+    case GET_RAW_ENCODER:
+    case GET_SAFETY_FLAG:
+    case GET_ENCODER_AND_SAFETY_FLAG:
+    case GET_RAW_ENCODER_AND_SAFETY_FLAG:
+    case GET_TELEMETRY:
+    case GET_BATTERY:
+    case GET_CHARGING:
+    case GET_INPUTS:
+    case GET_OUTPUTS:
+      return true;
+    default:
+      return false;
+    }
+  }
+
+  /**
+   * \brief Whether a request brings the AGV to a halt, and goes through the priority lane of the client.
+   */
+  static bool isHalt(uint16_t command, const Packet& request)
+  {
+    switch (command)
+    {
+    case STOP_ACTION:
+    case PAUSE_ACTION:
+      return true;
+    case SET_TARGET_SPEED:
+      return request.data.f[0] == 0.0f && request.data.f[1] == 0.0f;
+    default:
+      return false;
+    }
+  }
+
+  /**
+   * \brief Whether a request sets the AGV in motion, and may carry a deadline.
+   */
+  static bool isMotion(uint16_t command, const Packet& request)
+  {
+    switch (command)
+    {
+    case SET_TARGET_SPEED:
+      return !isHalt(command, request);
+    case MOVE_STRAIGHT:
+    case MOVE_BEZIER:
+    case ROTATE:
+    case RESUME_ACTION:
+      return true;
+    default:
+      return false;
+    }
+  }
+
+  /**
+   * \brief The deadline of a request, in the low 32 bits of the robot time in \f$\mu s\f$, or 0 when it has none.
+   */
+  uint32_t deadline() const
+  {
+    return reserved[1] | ((uint32_t) reserved[2] << 16);
+  }
+  void setDeadline(uint32_t deadline)
+  {
+    reserved[1] = (uint16_t) deadline;
+    reserved[2] = (uint16_t) (deadline >> 16);
+  }
+  /**
+   * \brief Whether the deadline of a request has passed at a robot time.
+   *
+   * The deadlines wrap around every 71 minutes, they are compared within half of that.
+   */
+  bool expired(uint64_t robot_time) const
+  {
+    uint32_t limit = deadline();
+    return limit != 0 && (int32_t) (limit - (uint32_t) robot_time) < 0;
+  }
+
+  /**
+   * \brief The halt epoch of a request, or 0 when it has none.
+   */
+  uint32_t haltEpoch() const
+  {
+    return data.u32[HALT_EPOCH_INDEX];
+  }
+  void setHaltEpoch(uint32_t epoch)
+  {
+    data.u32[HALT_EPOCH_INDEX] = epoch;
+  }
+  /**
+   * \brief Whether the epoch of a halt request is ahead of the epoch of a motion request of the same client.
+   *
+   * The counts wrap around, they are compared within half of their range.
+   */
+  static bool supersedes(uint32_t halt_epoch, uint32_t motion_epoch)
+  {
+    return halt_epoch != 0 && motion_epoch != 0 && (halt_epoch >> 16) == (motion_epoch >> 16) &&
+           (int16_t) (uint16_t) (halt_epoch - motion_epoch) > 0;
+  }
+
+  /**
+   * \brief Merges a SET_OUTPUTS write into the outputs that are still to be written.
+   *
+   * The bits of \a outputs_mask take their value from \a outputs, the other bits of \a value are kept, and \a mask
+   * gathers the bits written so far.
+   */
+  static void mergeOutputs(uint32_t& value, uint32_t& mask, uint32_t outputs, uint32_t outputs_mask)
+  {
+    value = (value & ~outputs_mask) | (outputs & outputs_mask);
+    mask |= outputs_mask;
+  }
+
 public:
   uint16_t command;  ///< Command type
-  uint16_t reserved[3];  ///< Reserved
+  uint16_t reserved[3];  ///< Reserved, reserved[0] holds the sequence number and reserved[1] - reserved[2] the deadline
   union
   {
     uint8_t u8[MAX_PAYLOAD];
@@ -0,0 +1,146 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "path.hpp"
+
+
+namespace zalpha_api
+{
+
+static const double MIN_SEGMENT = 1e-6;
+
+Path::Path()
+{
+}
+
+bool Path::set(const std::vector<PathPoint>& points)
+{
+  points_.clear();
+  lengths_.clear();
+  for (size_t i = 0; i < points.size(); i++)
+  {
+    if (!points_.empty())
+    {
+      double length = std::hypot(points[i].x - points_.back().x, points[i].y - points_.back().y);
+      if (length < MIN_SEGMENT) continue;
+      lengths_.push_back(lengths_.back() + length);
+    }
+    else
+    {
+      lengths_.push_back(0.0);
+    }
+    points_.push_back(points[i]);
+  }
+  return !empty();
+}
+
+std::vector<PathPoint> Path::spline(const std::vector<PathPoint>& points, double step)
+{
+  std::vector<PathPoint> samples;
+  if (points.size() < 3)
+  {
+    return points;
+  }
+
+  for (size_t i = 0; i + 1 < points.size(); i++)
+  {
+    // the end points are mirrored to give the first and last segments a tangent
+    const PathPoint& p1 = points[i];
+    const PathPoint& p2 = points[i + 1];
+    PathPoint p0 = (i > 0) ? points[i - 1] : PathPoint(2 * p1.x - p2.x, 2 * p1.y - p2.y);
+    PathPoint p3 = (i + 2 < points.size()) ? points[i + 2] : PathPoint(2 * p2.x - p1.x, 2 * p2.y - p1.y);
+
+    int count = std::max(1, (int) std::ceil(std::hypot(p2.x - p1.x, p2.y - p1.y) / step));
+    for (int k = 0; k < count; k++)
+    {
+      double t = (double) k / count;
+      double t2 = t * t, t3 = t2 * t;
+      double a = -0.5 * t3 + t2 - 0.5 * t;
+      double b = 1.5 * t3 - 2.5 * t2 + 1.0;
+      double c = -1.5 * t3 + 2.0 * t2 + 0.5 * t;
+      double d = 0.5 * t3 - 0.5 * t2;
+      samples.push_back(PathPoint(a * p0.x + b * p1.x + c * p2.x + d * p3.x,
+                                  a * p0.y + b * p1.y + c * p2.y + d * p3.y));
+    }
+  }
+  samples.push_back(points.back());
+  return samples;
+}
+
+PathPoint Path::pointAt(double s) const
+{
+  if (empty()) return PathPoint();
+  if (s <= 0.0) return points_.front();
+  if (s >= length()) return points_.back();
+
+  size_t i = segmentAt(s);
+  double t = (s - lengths_[i]) / (lengths_[i + 1] - lengths_[i]);
+  return PathPoint(points_[i].x + t * (points_[i + 1].x - points_[i].x),
+                   points_[i].y + t * (points_[i + 1].y - points_[i].y));
+}
+
+double Path::headingAt(double s) const
+{
+  if (empty()) return 0.0;
+
+  size_t i = segmentAt(std::max(0.0, std::min(s, length())));
+  return std::atan2(points_[i + 1].y - points_[i].y, points_[i + 1].x - points_[i].x);
+}
+
+Path::Projection Path::project(double x, double y, size_t first_segment, double max_s) const
+{
+  Projection best;
+  best.segment = 0;
+  best.s = best.x = best.y = best.heading = best.lateral = 0.0;
+  if (empty()) return best;
+
+  double best_distance = -1.0;
+  for (size_t i = std::min(first_segment, points_.size() - 2); i + 1 < points_.size(); i++)
+  {
+    if (i > first_segment && lengths_[i] > max_s) break;
+
+    const PathPoint& a = points_[i];
+    const PathPoint& b = points_[i + 1];
+    double dx = b.x - a.x, dy = b.y - a.y;
+    double length = lengths_[i + 1] - lengths_[i];
+    double t = std::max(0.0, std::min(1.0, ((x - a.x) * dx + (y - a.y) * dy) / (length * length)));
+    double px = a.x + t * dx, py = a.y + t * dy;
+    double distance = std::hypot(x - px, y - py);
+    if (best_distance < 0.0 || distance < best_distance)
+    {
+      best_distance = distance;
+      best.segment = i;
+      best.s = lengths_[i] + t * length;
+      best.x = px;
+      best.y = py;
+      best.heading = std::atan2(dy, dx);
+      // the side from the cross product of the segment and the offset
+      best.lateral = (dx * (y - a.y) - dy * (x - a.x)) / length;
+    }
+  }
+  return best;
+}
+
+size_t Path::segmentAt(double s) const
+{
+  size_t i = std::upper_bound(lengths_.begin(), lengths_.end(), s) - lengths_.begin();
+  return std::min(std::max(i, (size_t) 1), points_.size() - 1) - 1;
+}
+
+}  // namespace zalpha_api
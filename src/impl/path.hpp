@@ -0,0 +1,98 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ZALPHA_API_IMPL_PATH_HPP
+#define ZALPHA_API_IMPL_PATH_HPP
+
+#include <stddef.h>
+#include <vector>
+
+#include <zalpha_api/zalpha_api_export.h>
+#include <zalpha_api/path_follower.hpp>
+
+
+namespace zalpha_api
+{
+
+/**
+ * \brief Path is a polyline parameterized by its arc length.
+ */
+class ZALPHA_API_NO_EXPORT Path
+{
+public:
+  /**
+   * \brief The closest point of the path to a position.
+   */
+  struct Projection
+  {
+    size_t segment;  ///< index of the segment of the point
+    double s;        ///< arc length of the point, in m
+    double x;
+    double y;
+    double heading;  ///< direction of the segment, in rad
+    double lateral;  ///< distance of the position from the path, +ve on the left, in m
+  };
+
+public:
+  Path();
+
+  /**
+   * \brief Set the points of the polyline, the repeated points are dropped.
+   * @return                 A boolean indicating whether there are at least two distinct points
+   */
+  bool set(const std::vector<PathPoint>& points);
+  /**
+   * \brief Sample a Catmull-Rom spline through the points, which passes through every point.
+   * @param points           The points to pass through
+   * @param step             The largest distance between two samples, in m
+   * @return                 The samples, including the given points
+   */
+  static std::vector<PathPoint> spline(const std::vector<PathPoint>& points, double step);
+
+  bool empty() const
+  {
+    return points_.size() < 2;
+  }
+  double length() const
+  {
+    return empty() ? 0.0 : lengths_.back();
+  }
+
+  /**
+   * \brief The point at an arc length, clamped to the ends of the path.
+   */
+  PathPoint pointAt(double s) const;
+  /**
+   * \brief The direction of the path at an arc length, clamped to the ends of the path, in rad.
+   */
+  double headingAt(double s) const;
+  /**
+   * \brief The closest point to a position, among the segments from a first one up to an arc length,
+   *        so that a path crossing itself is followed in order.
+   */
+  Projection project(double x, double y, size_t first_segment, double max_s) const;
+
+private:
+  size_t segmentAt(double s) const;
+
+private:
+  std::vector<PathPoint> points_;
+  std::vector<double> lengths_;  ///< arc length of each point
+};
+
+}  // namespace zalpha_api
+
+#endif  // ZALPHA_API_IMPL_PATH_HPP
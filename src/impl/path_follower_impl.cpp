@@ -0,0 +1,419 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "path_follower_impl.hpp"
+#include "monotonic_clock.hpp"
+#include "packet.hpp"
+
+
+namespace zalpha_api
+{
+
+static const double MIN_SPEED = 0.02;       // the speed below which the AGV may not move, in m/s
+static const double MAX_PREDICTION = 0.5;   // the longest pose prediction, in s
+
+static double wrapAngle(double angle)
+{
+  return std::atan2(std::sin(angle), std::cos(angle));
+}
+
+/**
+ * \brief Move a wheel speed towards its target within the acceleration limits, a zero limit does not limit.
+ */
+static float ramp(float current, float target, float acceleration, float deceleration, double dt)
+{
+  bool speeding_up = std::fabs(target) > std::fabs(current) && current * target >= 0.0f;
+  float limit = speeding_up ? acceleration : deceleration;
+  if (limit <= 0.0f) return target;
+
+  float step = (float)(limit * dt);
+  return std::max(current - step, std::min(current + step, target));
+}
+
+PathFollowerImpl::PathFollowerImpl() :
+  connected_(false),
+  algorithm_(PathFollower::PURE_PURSUIT), speed_(0.3f), lookahead_(0.5), stanley_gain_(1.0), wheel_base_(0.5),
+  goal_tolerance_(0.02),
+  period_(0), saved_timeout_(-1), saved_retries_(0), running_(false)
+{
+  WorkerThread::initCondition(&stopped_);
+
+  std::memset(&status_, 0, sizeof(status_));
+}
+
+PathFollowerImpl::~PathFollowerImpl()
+{
+  disconnect();
+  pthread_cond_destroy(&stopped_);
+}
+
+bool PathFollowerImpl::connect(const std::string& server_address)
+{
+  if (!zalpha_.connect(server_address))
+  {
+    worker_.setCommandError(zalpha_);
+    return false;
+  }
+  connected_ = true;
+  return true;
+}
+
+void PathFollowerImpl::disconnect()
+{
+  stop();
+  zalpha_.disconnect();
+  connected_ = false;
+}
+
+bool PathFollowerImpl::setPath(const std::vector<PathPoint>& points, bool spline)
+{
+  bool valid = path_.set(spline ? Path::spline(points, SPLINE_STEP / 1000.0) : points);
+  if (!valid)
+  {
+    worker_.setError(Packet::RESULT_ERROR_INVALID_COMMAND, "Invalid parameters in API call.");
+  }
+  return valid;
+}
+
+void PathFollowerImpl::setAlgorithm(int algorithm)
+{
+  algorithm_ = algorithm;
+}
+
+void PathFollowerImpl::setSpeed(float speed)
+{
+  speed_ = std::fabs(speed);
+}
+
+void PathFollowerImpl::setLookahead(double distance)
+{
+  lookahead_ = std::max(distance, 0.01);
+}
+
+void PathFollowerImpl::setStanleyGain(double gain)
+{
+  stanley_gain_ = gain;
+}
+
+void PathFollowerImpl::setWheelBase(double wheel_base)
+{
+  wheel_base_ = wheel_base;
+}
+
+void PathFollowerImpl::setGoalTolerance(double tolerance)
+{
+  goal_tolerance_ = std::max(tolerance, 0.001);
+}
+
+bool PathFollowerImpl::start(int period)
+{
+  if (!connected_)
+  {
+    worker_.setError(Packet::DISCONNECTED, "Disconnected from API server.");
+    return false;
+  }
+  if (worker_.started() && running_)
+  {
+    worker_.setError(Packet::RESULT_ERROR_BUSY, "Follower is already started.");
+    return false;
+  }
+  if (period <= 0 || path_.empty() || speed_ <= 0.0f || wheel_base_ <= 0.0)
+  {
+    worker_.setError(Packet::RESULT_ERROR_INVALID_COMMAND, "Invalid parameters in API call.");
+    return false;
+  }
+  join();
+
+  // the setup reads use the default timeout, the cycles then wait at most one period for each reply
+  int64_t timestamp;
+  zalpha_.getTimeout(saved_timeout_, saved_retries_);
+  zalpha_.setTimeout(1000, 2);
+  if (!zalpha_.getAcceleration(acceleration_, deceleration_) ||
+      !zalpha_.getEncoder(last_left_, last_right_, timestamp))
+  {
+    worker_.setCommandError(zalpha_);
+    zalpha_.setTimeout(saved_timeout_, saved_retries_);
+    return false;
+  }
+  zalpha_.setTimeout(std::max(period / 1000, 1), 0);
+
+  x_ = y_ = theta_ = 0.0;
+  segment_ = 0;
+  s_ = 0.0;
+  command_left_ = command_right_ = 0.0f;
+  round_trip_ = 0;
+  consecutive_failures_ = 0;
+  period_ = period;
+
+  worker_.lock();
+  std::memset(&status_, 0, sizeof(status_));
+  status_.state = PathFollower::FOLLOWING;
+  status_.distance_to_goal = path_.length();
+  worker_.unlock();
+
+  running_ = true;
+  int error = worker_.start(&PathFollowerImpl::threadMain, this);
+  if (error != 0)
+  {
+    running_ = false;
+    zalpha_.setTimeout(saved_timeout_, saved_retries_);
+    worker_.lock();
+    status_.state = PathFollower::IDLE;
+    worker_.setSystemError("Failed to start the control thread", error);
+    worker_.unlock();
+    return false;
+  }
+  return true;
+}
+
+void PathFollowerImpl::stop()
+{
+  if (!worker_.started()) return;
+
+  running_ = false;
+  join();
+  zalpha_.setTargetSpeed(0.0f, 0.0f);
+
+  worker_.lock();
+  if (status_.state == PathFollower::FOLLOWING)
+  {
+    status_.state = PathFollower::IDLE;
+    pthread_cond_broadcast(&stopped_);
+  }
+  status_.left_speed = status_.right_speed = 0.0f;
+  worker_.unlock();
+}
+
+bool PathFollowerImpl::wait(int timeout)
+{
+  int64_t deadline = (timeout >= 0) ? monotonicNow() + timeout * 1000LL : -1;
+
+  worker_.lock();
+  while (status_.state == PathFollower::FOLLOWING)
+  {
+    if (!worker_.wait(&stopped_, deadline)) break;
+  }
+  bool stopped = status_.state != PathFollower::FOLLOWING;
+  worker_.unlock();
+  return stopped;
+}
+
+void PathFollowerImpl::getStatus(FollowerStatus& status)
+{
+  worker_.lock();
+  status = status_;
+  worker_.unlock();
+}
+
+int PathFollowerImpl::getError()
+{
+  return worker_.getError();
+}
+
+std::string PathFollowerImpl::getErrorMessage()
+{
+  return worker_.getErrorMessage();
+}
+
+void* PathFollowerImpl::threadMain(void* arg)
+{
+  static_cast<PathFollowerImpl*>(arg)->run();
+  return NULL;
+}
+
+void PathFollowerImpl::run()
+{
+  int64_t deadline = monotonicNow();
+  while (running_)
+  {
+    WorkerThread::sleepUntil(deadline);
+    if (!running_ || cycle()) break;
+
+    // skip the deadlines that passed during an overrun, the next cycle uses a fresh reading anyway
+    int64_t now = monotonicNow();
+    deadline += period_;
+    if (now >= deadline)
+    {
+      deadline += ((now - deadline) / period_ + 1) * period_;
+    }
+  }
+  running_ = false;
+}
+
+bool PathFollowerImpl::cycle()
+{
+  double left_distance, right_distance;
+  int64_t timestamp;
+  if (!zalpha_.getEncoder(left_distance, right_distance, timestamp))
+  {
+    return fail();
+  }
+
+  // odometry, with the heading at the middle of the step
+  double delta_left = left_distance - last_left_;
+  double delta_right = right_distance - last_right_;
+  last_left_ = left_distance;
+  last_right_ = right_distance;
+  double delta_theta = (delta_right - delta_left) / wheel_base_;
+  double delta_s = (delta_left + delta_right) / 2.0;
+  x_ += delta_s * std::cos(theta_ + delta_theta / 2.0);
+  y_ += delta_s * std::sin(theta_ + delta_theta / 2.0);
+  theta_ = wrapAngle(theta_ + delta_theta);
+
+  // the command reaches the AGV half a round trip from now, predict the pose at that time with the current command
+  double dt = (monotonicNow() - timestamp + round_trip_ / 2) * 1e-6;
+  dt = std::max(0.0, std::min(dt, MAX_PREDICTION));
+  double v = (command_left_ + command_right_) / 2.0;
+  double w = (command_right_ - command_left_) / wheel_base_;
+  double x = x_ + v * dt * std::cos(theta_ + w * dt / 2.0);
+  double y = y_ + v * dt * std::sin(theta_ + w * dt / 2.0);
+  double theta = wrapAngle(theta_ + w * dt);
+
+  // the search for the closest point stays near the last one, so that a path crossing itself is followed in order
+  Path::Projection projection = path_.project(x, y, segment_, s_ + std::max(2.0 * lookahead_, 1.0));
+  segment_ = projection.segment;
+  s_ = projection.s;
+  double remaining = path_.length() - projection.s;
+
+  worker_.lock();
+  status_.cycles++;
+  status_.x = x_;
+  status_.y = y_;
+  status_.theta = theta_;
+  status_.progress = projection.s / path_.length();
+  status_.distance_to_goal = remaining;
+  status_.cross_track_error = projection.lateral;
+  status_.heading_error = wrapAngle(theta - projection.heading);
+  worker_.unlock();
+
+  // done when the goal is within the tolerance, or behind the AGV at the end of the path
+  PathPoint goal = path_.pointAt(path_.length());
+  double goal_ahead = (goal.x - x) * std::cos(theta) + (goal.y - y) * std::sin(theta);
+  if (remaining <= goal_tolerance_ &&
+      (std::hypot(goal.x - x, goal.y - y) <= goal_tolerance_ || goal_ahead <= 0.0))
+  {
+    zalpha_.setTargetSpeed(0.0f, 0.0f);
+    finish(PathFollower::FINISHED);
+    return true;
+  }
+
+  // slow down to stop at the end of the path
+  double speed = speed_;
+  if (deceleration_ > 0.0f)
+  {
+    speed = std::min(speed, std::sqrt(2.0 * deceleration_ * remaining));
+  }
+  speed = std::max(speed, std::min((double) speed_, MIN_SPEED));
+
+  double kappa = curvature(projection, x, y, theta, speed);
+  double left = speed * (1.0 - kappa * wheel_base_ / 2.0);
+  double right = speed * (1.0 + kappa * wheel_base_ / 2.0);
+  // keep the curvature when the outer wheel would exceed the cruise speed
+  double fastest = std::max(std::fabs(left), std::fabs(right));
+  if (fastest > speed_)
+  {
+    left *= speed_ / fastest;
+    right *= speed_ / fastest;
+  }
+
+  double step = period_ * 1e-6;
+  command_left_ = ramp(command_left_, (float) left, acceleration_, deceleration_, step);
+  command_right_ = ramp(command_right_, (float) right, acceleration_, deceleration_, step);
+
+  int64_t start = monotonicNow();
+  if (!zalpha_.setTargetSpeed(command_left_, command_right_))
+  {
+    return fail();
+  }
+  int64_t round_trip = monotonicNow() - start;
+  round_trip_ = (round_trip_ == 0) ? round_trip : (round_trip_ * 7 + round_trip) / 8;
+  consecutive_failures_ = 0;
+
+  worker_.lock();
+  status_.left_speed = command_left_;
+  status_.right_speed = command_right_;
+  worker_.unlock();
+  return false;
+}
+
+double PathFollowerImpl::curvature(const Path::Projection& projection, double x, double y, double theta,
+                                   double speed)
+{
+  if (algorithm_ == PathFollower::STANLEY)
+  {
+    // the steering angle, converted into the curvature of an arc to a point one lookahead distance away,
+    // on top of the curvature of the path over the lookahead distance, which keeps an arc without a steady error
+    double heading_error = wrapAngle(projection.heading - theta);
+    double delta = heading_error - std::atan2(stanley_gain_ * projection.lateral, speed + MIN_SPEED);
+    delta = std::max(-M_PI / 2.0, std::min(delta, M_PI / 2.0));
+    double path_curvature = wrapAngle(path_.headingAt(projection.s + lookahead_ / 2.0) -
+                                      path_.headingAt(projection.s - lookahead_ / 2.0)) / lookahead_;
+    return path_curvature + 2.0 * std::sin(delta) / lookahead_;
+  }
+
+  // pure pursuit, the path is extended straight beyond its end so that the target never gets too close
+  double s = projection.s + lookahead_;
+  PathPoint target = path_.pointAt(s);
+  if (s > path_.length())
+  {
+    double heading = path_.headingAt(path_.length());
+    target.x += (s - path_.length()) * std::cos(heading);
+    target.y += (s - path_.length()) * std::sin(heading);
+  }
+  double dx = target.x - x, dy = target.y - y;
+  double lateral = -std::sin(theta) * dx + std::cos(theta) * dy;
+  double distance_squared = dx * dx + dy * dy;
+  return (distance_squared > 0.0) ? 2.0 * lateral / distance_squared : 0.0;
+}
+
+bool PathFollowerImpl::fail()
+{
+  consecutive_failures_++;
+  worker_.lock();
+  status_.failures++;
+  worker_.setCommandError(zalpha_);
+  worker_.unlock();
+
+  if (consecutive_failures_ < PathFollower::MAX_FAILURES) return false;
+
+  zalpha_.setTargetSpeed(0.0f, 0.0f);
+  finish(PathFollower::FAILED);
+  return true;
+}
+
+void PathFollowerImpl::finish(int state)
+{
+  command_left_ = command_right_ = 0.0f;
+  worker_.lock();
+  status_.state = state;
+  status_.left_speed = status_.right_speed = 0.0f;
+  pthread_cond_broadcast(&stopped_);
+  worker_.unlock();
+}
+
+void PathFollowerImpl::join()
+{
+  if (!worker_.started()) return;
+
+  worker_.join();
+  zalpha_.setTimeout(saved_timeout_, saved_retries_);
+}
+
+}  // namespace zalpha_api
@@ -0,0 +1,116 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ZALPHA_API_IMPL_PATH_FOLLOWER_IMPL_HPP
+#define ZALPHA_API_IMPL_PATH_FOLLOWER_IMPL_HPP
+
+#include <pthread.h>
+#include <stdint.h>
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include <zalpha_api/zalpha_api_export.h>
+#include <zalpha_api/path_follower.hpp>
+#include "path.hpp"
+#include "worker_thread.hpp"
+#include "zalpha_impl.hpp"
+
+
+namespace zalpha_api
+{
+
+/**
+ * \brief PathFollowerImpl is an internal implementation class that provides the path tracking thread.
+ */
+class ZALPHA_API_NO_EXPORT PathFollowerImpl
+{
+public:
+  enum
+  {
+    SPLINE_STEP = 50,  ///< Largest distance between the samples of a spline, in mm
+  };
+
+public:
+  PathFollowerImpl();
+  virtual ~PathFollowerImpl();
+
+  bool connect(const std::string& server_address);
+  void disconnect();
+  bool setPath(const std::vector<PathPoint>& points, bool spline);
+  void setAlgorithm(int algorithm);
+  void setSpeed(float speed);
+  void setLookahead(double distance);
+  void setStanleyGain(double gain);
+  void setWheelBase(double wheel_base);
+  void setGoalTolerance(double tolerance);
+  bool start(int period);
+  void stop();
+  bool wait(int timeout);
+  void getStatus(FollowerStatus& status);
+
+  int getError();
+  std::string getErrorMessage();
+
+private:
+  static void* threadMain(void* arg);
+  void run();
+  bool cycle();
+  double curvature(const Path::Projection& projection, double x, double y, double theta, double speed);
+  bool fail();
+  void finish(int state);
+  void join();
+
+private:
+  ZalphaImpl zalpha_;
+  bool connected_;
+
+  Path path_;
+  int algorithm_;
+  float speed_;
+  double lookahead_;
+  double stanley_gain_;
+  double wheel_base_;
+  double goal_tolerance_;
+
+  int period_;
+  int saved_timeout_;  ///< the timeout of the connection before start(), restored once the thread has ended
+  int saved_retries_;
+  std::atomic<bool> running_;
+
+  // the control state, only used by the control thread while it runs
+  float acceleration_;
+  float deceleration_;
+  double last_left_;
+  double last_right_;
+  double x_;
+  double y_;
+  double theta_;
+  size_t segment_;
+  double s_;
+  float command_left_;
+  float command_right_;
+  int64_t round_trip_;
+  int consecutive_failures_;
+
+  WorkerThread worker_;  ///< its mutex guards the status
+  pthread_cond_t stopped_;
+  FollowerStatus status_;
+};
+
+}  // namespace zalpha_api
+
+#endif  // ZALPHA_API_IMPL_PATH_FOLLOWER_IMPL_HPP
@@ -0,0 +1,306 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include "setpoint_mailbox_impl.hpp"
+#include "monotonic_clock.hpp"
+#include "packet.hpp"
+
+
+namespace zalpha_api
+{
+
+SetpointMailboxImpl::Slot::Slot() :
+  posted(false), dirty(false), in_flight(false), failed(false), last_send(0)
+{
+}
+
+SetpointMailboxImpl::SetpointMailboxImpl() :
+  timeout_(DEFAULT_TIMEOUT), timeout_changed_(false), keep_alive_(0), running_(false),
+  left_speed_(0.0f), right_speed_(0.0f), speed_sent_(false), sent_left_speed_(0.0f), sent_right_speed_(0.0f),
+  outputs_value_(0), outputs_mask_(0), sent_outputs_value_(0), sent_outputs_mask_(0)
+{
+  WorkerThread::initCondition(&wake_);
+  WorkerThread::initCondition(&idle_);
+
+  resetStatistics();
+}
+
+SetpointMailboxImpl::~SetpointMailboxImpl()
+{
+  disconnect();
+  pthread_cond_destroy(&idle_);
+  pthread_cond_destroy(&wake_);
+}
+
+bool SetpointMailboxImpl::connect(const std::string& server_address)
+{
+  if (running_)
+  {
+    worker_.setError(Packet::CONNECTED, "Already connected to API server.");
+    return false;
+  }
+  if (!zalpha_.connect(server_address))
+  {
+    worker_.setCommandError(zalpha_);
+    return false;
+  }
+  zalpha_.setTimeout(timeout_, 0);
+  timeout_changed_ = false;
+
+  speed_ = Slot();
+  speed_sent_ = false;
+  outputs_ = Slot();
+  outputs_mask_ = 0;
+  sent_outputs_mask_ = 0;
+  resetStatistics();
+
+  running_ = true;
+  int error = worker_.start(&SetpointMailboxImpl::threadMain, this);
+  if (error != 0)
+  {
+    running_ = false;
+    zalpha_.disconnect();
+    worker_.setSystemError("Failed to start the sender thread", error);
+    return false;
+  }
+  return true;
+}
+
+void SetpointMailboxImpl::disconnect()
+{
+  worker_.lock();
+  bool running = running_;
+  running_ = false;
+  pthread_cond_signal(&wake_);
+  pthread_cond_broadcast(&idle_);
+  worker_.unlock();
+  if (!running) return;
+
+  worker_.join();
+  zalpha_.disconnect();
+}
+
+void SetpointMailboxImpl::setTimeout(int timeout)
+{
+  // applied by the sender thread, the only user of the connection while it runs
+  worker_.lock();
+  timeout_ = timeout;
+  timeout_changed_ = true;
+  pthread_cond_signal(&wake_);
+  worker_.unlock();
+}
+
+void SetpointMailboxImpl::setKeepAlive(int interval)
+{
+  worker_.lock();
+  keep_alive_ = (interval > 0) ? interval * 1000 : 0;
+  pthread_cond_signal(&wake_);
+  worker_.unlock();
+}
+
+void SetpointMailboxImpl::postTargetSpeed(float left_speed, float right_speed)
+{
+  worker_.lock();
+  statistics_.posted++;
+  if (speed_.dirty)
+  {
+    statistics_.superseded++;
+  }
+  left_speed_ = left_speed;
+  right_speed_ = right_speed;
+  speed_.posted = speed_.dirty = true;
+  pthread_cond_signal(&wake_);
+  worker_.unlock();
+}
+
+void SetpointMailboxImpl::postOutputs(uint32_t outputs, uint32_t mask)
+{
+  worker_.lock();
+  statistics_.posted++;
+  if (outputs_.dirty)
+  {
+    statistics_.superseded++;
+  }
+  Packet::mergeOutputs(outputs_value_, outputs_mask_, outputs, mask);
+  outputs_.posted = outputs_.dirty = true;
+  pthread_cond_signal(&wake_);
+  worker_.unlock();
+}
+
+bool SetpointMailboxImpl::flush(int timeout)
+{
+  int64_t deadline = (timeout >= 0) ? monotonicNow() + timeout * 1000LL : -1;
+
+  worker_.lock();
+  while (running_ && !isIdle())
+  {
+    if (!worker_.wait(&idle_, deadline)) break;
+  }
+  bool success = running_ && isIdle() && !speed_.failed && !outputs_.failed;
+  worker_.unlock();
+  return success;
+}
+
+void SetpointMailboxImpl::getStatistics(MailboxStatistics& statistics)
+{
+  worker_.lock();
+  statistics = statistics_;
+  worker_.unlock();
+}
+
+void SetpointMailboxImpl::resetStatistics()
+{
+  worker_.lock();
+  std::memset(&statistics_, 0, sizeof(statistics_));
+  worker_.unlock();
+}
+
+int SetpointMailboxImpl::getError()
+{
+  return worker_.getError();
+}
+
+std::string SetpointMailboxImpl::getErrorMessage()
+{
+  return worker_.getErrorMessage();
+}
+
+void* SetpointMailboxImpl::threadMain(void* arg)
+{
+  static_cast<SetpointMailboxImpl*>(arg)->run();
+  return NULL;
+}
+
+void SetpointMailboxImpl::run()
+{
+  worker_.lock();
+  while (running_)
+  {
+    if (timeout_changed_)
+    {
+      zalpha_.setTimeout(timeout_, 0);
+      timeout_changed_ = false;
+    }
+
+    int64_t now = monotonicNow();
+    int64_t wake = -1;
+
+    // send every due setpoint in turn, so that a fast producer of one kind does not starve the other,
+    // the speed goes first as it matters more
+    bool speed_unchanged = speed_sent_ && left_speed_ == sent_left_speed_ && right_speed_ == sent_right_speed_;
+    bool speed_due = isDue(speed_, speed_unchanged, now, wake);
+    bool outputs_unchanged = outputs_mask_ == sent_outputs_mask_ &&
+                             (outputs_value_ & outputs_mask_) == (sent_outputs_value_ & sent_outputs_mask_);
+    bool outputs_due = isDue(outputs_, outputs_unchanged, now, wake);
+    speed_.in_flight = speed_due;
+    outputs_.in_flight = outputs_due;
+
+    if (speed_due)
+    {
+      float left_speed = left_speed_;
+      float right_speed = right_speed_;
+      worker_.unlock();
+
+      int64_t time = monotonicNow();
+      bool success = zalpha_.setTargetSpeed(left_speed, right_speed);
+
+      worker_.lock();
+      if (success)
+      {
+        speed_sent_ = true;
+        sent_left_speed_ = left_speed;
+        sent_right_speed_ = right_speed;
+      }
+      complete(speed_, success, time);
+    }
+    if (outputs_due && running_)
+    {
+      // the newest outputs, including those posted while the speed was in flight
+      uint32_t value = outputs_value_;
+      uint32_t mask = outputs_mask_;
+      outputs_.dirty = false;
+      worker_.unlock();
+
+      int64_t time = monotonicNow();
+      bool success = zalpha_.setOutputs(value, mask);
+
+      worker_.lock();
+      if (success)
+      {
+        sent_outputs_value_ = value;
+        sent_outputs_mask_ = mask;
+      }
+      complete(outputs_, success, time);
+    }
+    if (speed_due || outputs_due) continue;
+
+    pthread_cond_broadcast(&idle_);
+    worker_.wait(&wake_, wake);
+  }
+  worker_.unlock();
+}
+
+bool SetpointMailboxImpl::isDue(Slot& slot, bool unchanged, int64_t now, int64_t& wake)
+{
+  if (!slot.posted) return false;
+
+  if (slot.dirty)
+  {
+    slot.dirty = false;
+    if (!unchanged || slot.failed) return true;
+    statistics_.unchanged++;
+  }
+
+  // an unchanged setpoint is refreshed at the keep-alive interval, and a failed one retried
+  int64_t interval = (keep_alive_ > 0) ? keep_alive_ : (slot.failed ? RETRY_INTERVAL : 0);
+  if (interval == 0) return false;
+
+  int64_t due = slot.last_send + interval;
+  if (now >= due)
+  {
+    if (!slot.failed)
+    {
+      statistics_.keep_alives++;
+    }
+    return true;
+  }
+  wake = (wake < 0) ? due : std::min(wake, due);
+  return false;
+}
+
+void SetpointMailboxImpl::complete(Slot& slot, bool success, int64_t time)
+{
+  slot.in_flight = false;
+  slot.failed = !success;
+  slot.last_send = time;
+  statistics_.sent++;
+  if (!success)
+  {
+    statistics_.failures++;
+    worker_.setCommandError(zalpha_);
+  }
+  pthread_cond_broadcast(&idle_);
+}
+
+bool SetpointMailboxImpl::isIdle() const
+{
+  return !speed_.dirty && !speed_.in_flight && !outputs_.dirty && !outputs_.in_flight;
+}
+
+}  // namespace zalpha_api
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ZALPHA_API_IMPL_SETPOINT_MAILBOX_IMPL_HPP
+#define ZALPHA_API_IMPL_SETPOINT_MAILBOX_IMPL_HPP
+
+#include <pthread.h>
+#include <stdint.h>
+#include <string>
+
+#include <zalpha_api/zalpha_api_export.h>
+#include <zalpha_api/setpoint_mailbox.hpp>
+#include "worker_thread.hpp"
+#include "zalpha_impl.hpp"
+
+
+namespace zalpha_api
+{
+
+/**
+ * \brief SetpointMailboxImpl is an internal implementation class that provides the setpoint mailbox.
+ */
+class ZALPHA_API_NO_EXPORT SetpointMailboxImpl
+{
+public:
+  enum
+  {
+    DEFAULT_TIMEOUT = 500,     ///< Timeout of the commands, in ms
+    RETRY_INTERVAL = 100000,   ///< Interval between the attempts of a failed command without keep-alive, in us
+  };
+
+public:
+  SetpointMailboxImpl();
+  virtual ~SetpointMailboxImpl();
+
+  bool connect(const std::string& server_address);
+  void disconnect();
+  void setTimeout(int timeout);
+  void setKeepAlive(int interval);
+  void postTargetSpeed(float left_speed, float right_speed);
+  void postOutputs(uint32_t outputs, uint32_t mask);
+  bool flush(int timeout);
+  void getStatistics(MailboxStatistics& statistics);
+  void resetStatistics();
+
+  int getError();
+  std::string getErrorMessage();
+
+private:
+  /**
+   * \brief The state of one kind of setpoint in the mailbox.
+   */
+  struct Slot
+  {
+    bool posted;        ///< a setpoint has been posted since connect()
+    bool dirty;         ///< a setpoint has been posted since the last send
+    bool in_flight;     ///< a command is being sent
+    bool failed;        ///< the last command failed
+    int64_t last_send;  ///< the time of the last command, in us
+
+    Slot();
+  };
+
+  static void* threadMain(void* arg);
+  void run();
+  bool isDue(Slot& slot, bool unchanged, int64_t now, int64_t& wake);
+  void complete(Slot& slot, bool success, int64_t time);
+  bool isIdle() const;
+
+private:
+  ZalphaImpl zalpha_;
+  int timeout_;
+  bool timeout_changed_;  ///< the timeout is applied by the sender thread, the only user of the connection
+  int keep_alive_;
+
+  WorkerThread worker_;  ///< its mutex guards the mailbox
+  bool running_;
+  pthread_cond_t wake_;  ///< signals the sender of a new setpoint
+  pthread_cond_t idle_;  ///< signals the flushers of a completed command
+
+  Slot speed_;
+  float left_speed_;
+  float right_speed_;
+  bool speed_sent_;
+  float sent_left_speed_;
+  float sent_right_speed_;
+
+  Slot outputs_;
+  uint32_t outputs_value_;
+  uint32_t outputs_mask_;
+  uint32_t sent_outputs_value_;
+  uint32_t sent_outputs_mask_;
+
+  MailboxStatistics statistics_;
+};
+
+}  // namespace zalpha_api
+
+#endif  // ZALPHA_API_IMPL_SETPOINT_MAILBOX_IMPL_HPP
@@ -0,0 +1,271 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cerrno>
+#include <cstring>
+#include <new>
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "shm_segment.hpp"
+#include "monotonic_clock.hpp"
+
+
+namespace zalpha_api
+{
+
+static_assert(ATOMIC_INT_LOCK_FREE == 2, "the shared memory rings need lock-free atomics");
+
+static inline void cpuRelax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#else
+  std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+}
+
+/**
+ * \brief Whether busy-polling may pay off, it only delays the other side when there is a single CPU to share.
+ */
+static bool canSpin()
+{
+  static const bool multiprocessor = sysconf(_SC_NPROCESSORS_ONLN) > 1;
+  return multiprocessor;
+}
+
+bool ShmRing::push(const Packet& packet)
+{
+  uint32_t index = tail.load(std::memory_order_relaxed);
+  if (index - head.load(std::memory_order_acquire) >= RING_SIZE)
+  {
+    return false;
+  }
+  slot[index % RING_SIZE] = packet;
+  tail.store(index + 1, std::memory_order_seq_cst);
+
+  // seq_cst on both sides, so that either the consumer sees the new tail or the producer sees it waiting
+  if (waiting.load(std::memory_order_seq_cst))
+  {
+    ShmSegment::wake(tail);
+  }
+  return true;
+}
+
+bool ShmRing::pop(Packet& packet)
+{
+  uint32_t index = head.load(std::memory_order_relaxed);
+  if (index == tail.load(std::memory_order_acquire))
+  {
+    return false;
+  }
+  packet = slot[index % RING_SIZE];
+  head.store(index + 1, std::memory_order_release);
+  return true;
+}
+
+ShmSegment::ShmSegment() :
+  layout_(NULL), owner_(false), errnum_(0)
+{
+}
+
+ShmSegment::~ShmSegment()
+{
+  close();
+}
+
+std::string ShmSegment::segmentName(const std::string& name)
+{
+  return "/zalpha-" + name;
+}
+
+bool ShmSegment::create(const std::string& name)
+{
+  name_ = segmentName(name);
+  shm_unlink(name_.c_str());
+  int fd = shm_open(name_.c_str(), O_RDWR | O_CREAT | O_EXCL, 0666);
+  if (fd < 0)
+  {
+    setError(Packet::SYSTEM_ERROR, name_ + ": " + strerror(errno));
+    return false;
+  }
+  if (ftruncate(fd, sizeof(ShmLayout)) != 0)
+  {
+    setError(Packet::SYSTEM_ERROR, name_ + ": " + strerror(errno));
+    ::close(fd);
+    shm_unlink(name_.c_str());
+    return false;
+  }
+  if (!map(fd))
+  {
+    shm_unlink(name_.c_str());
+    return false;
+  }
+  owner_ = true;
+
+  new (layout_) ShmLayout();
+  layout_->version = ShmLayout::VERSION;
+  layout_->server_pid = getpid();
+  layout_->doorbell = 0;
+  layout_->server_waiting = 0;
+  for (int i = 0; i < ShmLayout::NUM_CHANNELS; i++)
+  {
+    ShmChannel& channel = layout_->channel[i];
+    channel.owner = 0;
+    channel.sequence = 0;
+    channel.request.head = channel.request.tail = channel.request.waiting = 0;
+    channel.reply.head = channel.reply.tail = channel.reply.waiting = 0;
+  }
+  layout_->magic.store(ShmLayout::MAGIC, std::memory_order_release);
+  return true;
+}
+
+bool ShmSegment::open(const std::string& name)
+{
+  name_ = segmentName(name);
+  int fd = shm_open(name_.c_str(), O_RDWR, 0);
+  if (fd < 0)
+  {
+    setError(Packet::INVALID_ENDPOINT, name_ + ": " + strerror(errno));
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size != (off_t) sizeof(ShmLayout))
+  {
+    setError(Packet::INVALID_ENDPOINT, name_ + ": Not a segment of this API version.");
+    ::close(fd);
+    return false;
+  }
+  if (!map(fd))
+  {
+    return false;
+  }
+  if (layout_->magic.load(std::memory_order_acquire) != ShmLayout::MAGIC ||
+      layout_->version != ShmLayout::VERSION)
+  {
+    setError(Packet::INVALID_ENDPOINT, name_ + ": Not a segment of this API version.");
+    close();
+    return false;
+  }
+  return true;
+}
+
+void ShmSegment::close()
+{
+  if (!layout_) return;
+
+  munmap(layout_, sizeof(ShmLayout));
+  layout_ = NULL;
+  if (owner_)
+  {
+    shm_unlink(name_.c_str());
+    owner_ = false;
+  }
+}
+
+int ShmSegment::claimChannel()
+{
+  int32_t pid = getpid();
+  for (int i = 0; i < ShmLayout::NUM_CHANNELS; i++)
+  {
+    ShmChannel& channel = layout_->channel[i];
+    int32_t owner = channel.owner.load();
+    if (owner != 0 && (owner == pid || kill(owner, 0) == 0 || errno != ESRCH)) continue;
+    if (!channel.owner.compare_exchange_strong(owner, pid)) continue;
+
+    // the replies left over by the previous owner are dropped
+    channel.reply.head.store(channel.reply.tail.load());
+    return i;
+  }
+  setError(Packet::SYSTEM_ERROR, name_ + ": All channels are in use.");
+  return -1;
+}
+
+void ShmSegment::releaseChannel(int index)
+{
+  layout_->channel[index].owner.store(0);
+}
+
+bool ShmSegment::wait(std::atomic<uint32_t>& word, std::atomic<uint32_t>& waiting, uint32_t value, int64_t timeout)
+{
+  int64_t start = monotonicNow();
+  int64_t deadline = (timeout >= 0) ? start + timeout : -1;
+
+  // the other side usually answers within the spin time, which saves the cost of a sleep and a wake-up
+  for (int i = 0; canSpin(); i++)
+  {
+    if (word.load(std::memory_order_acquire) != value) return true;
+    cpuRelax();
+    if ((i & 63) == 63)
+    {
+      int64_t now = monotonicNow();
+      if (deadline >= 0 && now >= deadline) return false;
+      if (now - start >= SPIN_TIME) break;
+    }
+  }
+
+  waiting.store(1, std::memory_order_seq_cst);
+  bool changed = false;
+  for (;;)
+  {
+    if (word.load(std::memory_order_seq_cst) != value)
+    {
+      changed = true;
+      break;
+    }
+
+    struct timespec ts;
+    struct timespec* pts = NULL;
+    if (deadline >= 0)
+    {
+      int64_t remaining = deadline - monotonicNow();
+      if (remaining <= 0) break;
+      ts = toTimespec(remaining);
+      pts = &ts;
+    }
+    // the segment is shared between processes, so the futex cannot be private
+    syscall(SYS_futex, &word, FUTEX_WAIT, value, pts, NULL, 0);
+  }
+  waiting.store(0, std::memory_order_relaxed);
+  return changed;
+}
+
+void ShmSegment::wake(std::atomic<uint32_t>& word)
+{
+  syscall(SYS_futex, &word, FUTEX_WAKE, INT32_MAX, NULL, NULL, 0);
+}
+
+bool ShmSegment::map(int fd)
+{
+  void* address = mmap(NULL, sizeof(ShmLayout), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (address == MAP_FAILED)
+  {
+    setError(Packet::SYSTEM_ERROR, name_ + ": " + strerror(errno));
+    return false;
+  }
+  layout_ = static_cast<ShmLayout*>(address);
+  return true;
+}
+
+}  // namespace zalpha_api
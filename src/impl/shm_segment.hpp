@@ -0,0 +1,183 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ZALPHA_API_IMPL_SHM_SEGMENT_HPP
+#define ZALPHA_API_IMPL_SHM_SEGMENT_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <string>
+
+#include <zalpha_api/zalpha_api_export.h>
+#include "packet.hpp"
+
+
+namespace zalpha_api
+{
+
+/**
+ * \brief A single-producer single-consumer ring of packets in shared memory.
+ *
+ * The indices only ever increase, the slot of an index is its value modulo RING_SIZE. The consumer sleeps on
+ * the tail with a futex after setting waiting, so that the producer only makes a system call when it is needed.
+ */
+struct ZALPHA_API_NO_EXPORT ShmRing
+{
+  enum
+  {
+    RING_SIZE = 16,  // must be a power of 2.
+  };
+
+  alignas(64) std::atomic<uint32_t> head;     ///< next index to read, written by the consumer
+  alignas(64) std::atomic<uint32_t> tail;     ///< next index to write, written by the producer
+  std::atomic<uint32_t> waiting;              ///< 1 while the consumer sleeps on the tail
+  alignas(64) Packet slot[RING_SIZE];
+
+  /**
+   * \brief Append a packet, and wake the consumer if it sleeps.
+   * @return                 A boolean indicating whether there was a free slot
+   */
+  bool push(const Packet& packet);
+  /**
+   * \brief Remove the oldest packet.
+   * @return                 A boolean indicating whether there was a packet
+   */
+  bool pop(Packet& packet);
+};
+
+/**
+ * \brief The requests and replies of one client, claimed by the process ID of the client.
+ */
+struct ZALPHA_API_NO_EXPORT ShmChannel
+{
+  std::atomic<int32_t> owner;       ///< process ID of the client, 0 when the channel is free
+  std::atomic<uint32_t> sequence;   ///< last sequence number used, carried over to the next owner
+  ShmRing request;
+  ShmRing reply;
+};
+
+/**
+ * \brief The layout of the shared memory segment.
+ */
+struct ZALPHA_API_NO_EXPORT ShmLayout
+{
+  enum
+  {
+    MAGIC = 0x5A414C50,  // "ZALP"
+    VERSION = 1,
+    NUM_CHANNELS = 8,
+  };
+
+  std::atomic<uint32_t> magic;      ///< written last by the server, once the segment is initialized
+  uint32_t version;
+  int32_t server_pid;
+  alignas(64) std::atomic<uint32_t> doorbell;  ///< incremented by the clients after each request
+  std::atomic<uint32_t> server_waiting;        ///< 1 while the server sleeps on the doorbell
+  ShmChannel channel[NUM_CHANNELS];
+};
+
+/**
+ * \brief ShmSegment maps the shared memory segment of a co-located API server, in /dev/shm.
+ *
+ * The server creates the segment and serves the request rings of every channel, each client claims a channel of
+ * its own. The packets are copied into the rings as they are, without any encoding.
+ */
+class ZALPHA_API_NO_EXPORT ShmSegment
+{
+public:
+  enum
+  {
+    SPIN_TIME = 50,  ///< Time to busy-poll before sleeping on a futex, in us, when there is more than one CPU
+  };
+
+public:
+  ShmSegment();
+  virtual ~ShmSegment();
+
+  /**
+   * \brief The name of the segment of an endpoint name, for eg: "/zalpha-robot1" for "robot1".
+   */
+  static std::string segmentName(const std::string& name);
+
+  /**
+   * \brief Create and initialize the segment, replacing a stale one, on the server.
+   */
+  bool create(const std::string& name);
+  /**
+   * \brief Map the segment created by a server, on the client.
+   */
+  bool open(const std::string& name);
+  /**
+   * \brief Unmap the segment, and remove it on the server.
+   */
+  void close();
+
+  ShmLayout* layout()
+  {
+    return layout_;
+  }
+
+  /**
+   * \brief Claim a free channel, or the channel of a client process that no longer exists.
+   * @return                 The index of the channel, or -1 if all of them are in use
+   */
+  int claimChannel();
+  void releaseChannel(int index);
+
+  /**
+   * \brief Wait until a word no longer holds a value, busy-polling for SPIN_TIME first.
+   * @param word             The word to watch, the tail of a ring or the doorbell
+   * @param waiting          The flag telling the other side to wake this one up
+   * @param value            The value last seen
+   * @param timeout          The maximum time to wait, in us, or -1 to wait indefinitely
+   * @return                 A boolean indicating whether the word changed before the timeout
+   */
+  static bool wait(std::atomic<uint32_t>& word, std::atomic<uint32_t>& waiting, uint32_t value, int64_t timeout);
+  /**
+   * \brief Wake up the threads sleeping on a word.
+   */
+  static void wake(std::atomic<uint32_t>& word);
+
+  int getError()
+  {
+    return errnum_;
+  }
+  std::string getErrorMessage()
+  {
+    return errmsg_;
+  }
+
+private:
+  bool map(int fd);
+  void setError(int errnum, const std::string& errmsg)
+  {
+    errnum_ = errnum;
+    errmsg_ = errmsg;
+  }
+
+private:
+  ShmLayout* layout_;
+  std::string name_;
+  bool owner_;  ///< whether this side created the segment
+
+  int errnum_;
+  std::string errmsg_;
+};
+
+}  // namespace zalpha_api
+
+#endif  // ZALPHA_API_IMPL_SHM_SEGMENT_HPP
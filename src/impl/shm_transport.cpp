@@ -0,0 +1,135 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "shm_transport.hpp"
+#include "monotonic_clock.hpp"
+#include "packet.hpp"
+
+
+namespace zalpha_api
+{
+
+ShmTransport::ShmTransport() :
+  channel_(NULL), channel_index_(-1), sequence_(0)
+{
+}
+
+ShmTransport::~ShmTransport()
+{
+  disconnect();
+}
+
+bool ShmTransport::connect(const std::string& url)
+{
+  // shm://name
+  std::string name = url.substr(url.find("://") + 3);
+  if (name.empty() || name.find('/') != std::string::npos)
+  {
+    setError(Packet::INVALID_ENDPOINT, "Invalid shared memory name: " + url);
+    return false;
+  }
+
+  if (!segment_.open(name))
+  {
+    setError(segment_.getError(), segment_.getErrorMessage());
+    return false;
+  }
+  channel_index_ = segment_.claimChannel();
+  if (channel_index_ < 0)
+  {
+    setError(segment_.getError(), segment_.getErrorMessage());
+    segment_.close();
+    return false;
+  }
+  channel_ = &segment_.layout()->channel[channel_index_];
+  // carry on from the sequence number of the previous owner, so that its late replies are not taken for ours
+  sequence_ = (uint16_t) channel_->sequence.load();
+  return true;
+}
+
+void ShmTransport::disconnect()
+{
+  if (!channel_) return;
+
+  segment_.releaseChannel(channel_index_);
+  segment_.close();
+  channel_ = NULL;
+  channel_index_ = -1;
+}
+
+bool ShmTransport::sendRequest(const Packet& packet)
+{
+  // sequence number 0 is reserved for transports without sequencing
+  if (++sequence_ == 0)
+  {
+    ++sequence_;
+  }
+  channel_->sequence.store(sequence_, std::memory_order_relaxed);
+
+  Packet request = packet;
+  request.reserved[0] = sequence_;
+  if (!channel_->request.push(request))
+  {
+    setError(Packet::SYSTEM_ERROR, "API server is not reading its requests.");
+    return false;
+  }
+  bytes_sent_ += sizeof(Packet);
+
+  ShmLayout* layout = segment_.layout();
+  layout->doorbell.fetch_add(1, std::memory_order_seq_cst);
+  if (layout->server_waiting.load(std::memory_order_seq_cst))
+  {
+    ShmSegment::wake(layout->doorbell);
+  }
+  return true;
+}
+
+bool ShmTransport::waitReply(Packet& packet)
+{
+  int64_t deadline = (timeout_ >= 0) ? monotonicNow() + (int64_t) timeout_ * 1000 : -1;
+  ShmRing& ring = channel_->reply;
+
+  for (;;)
+  {
+    // discard the late replies of earlier requests
+    Packet reply;
+    while (ring.pop(reply))
+    {
+      bytes_received_ += sizeof(Packet);
+      if (reply.reserved[0] == sequence_)
+      {
+        packet = reply;
+        return true;
+      }
+    }
+
+    // the ring is empty, so its tail is the head
+    uint32_t tail = ring.head.load(std::memory_order_relaxed);
+    int64_t remaining = -1;
+    if (deadline >= 0)
+    {
+      remaining = deadline - monotonicNow();
+      if (remaining < 0) remaining = 0;
+    }
+    if (!ShmSegment::wait(ring.tail, ring.waiting, tail, remaining))
+    {
+      setError(Packet::TIMEOUT, "Timed out waiting for reply.");
+      return false;
+    }
+  }
+}
+
+}  // namespace zalpha_api
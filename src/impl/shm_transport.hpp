@@ -0,0 +1,59 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ZALPHA_API_IMPL_SHM_TRANSPORT_HPP
+#define ZALPHA_API_IMPL_SHM_TRANSPORT_HPP
+
+#include <stdint.h>
+
+#include <zalpha_api/zalpha_api_export.h>
+#include "shm_segment.hpp"
+#include "transport.hpp"
+
+
+namespace zalpha_api
+{
+
+/**
+ * \brief ShmTransport exchanges the packets with a co-located API server through the rings of a shared memory
+ *        segment, see ShmSegment.
+ *
+ * A round trip takes no system call when the server answers within the spin time, and the packets are copied
+ * into the rings as they are, so the wire encoding has no effect. Like UdpTransport, every request carries a new
+ * sequence number, and the late replies of the requests that timed out are discarded.
+ */
+class ZALPHA_API_NO_EXPORT ShmTransport : public Transport
+{
+public:
+  ShmTransport();
+  virtual ~ShmTransport();
+
+  virtual bool connect(const std::string& url);
+  virtual void disconnect();
+
+  virtual bool sendRequest(const Packet& packet);
+  virtual bool waitReply(Packet& packet);
+
+private:
+  ShmSegment segment_;
+  ShmChannel* channel_;
+  int channel_index_;
+  uint16_t sequence_;
+};
+
+}  // namespace zalpha_api
+
+#endif  // ZALPHA_API_IMPL_SHM_TRANSPORT_HPP
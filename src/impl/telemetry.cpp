@@ -0,0 +1,145 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "telemetry.hpp"
+
+
+namespace zalpha_api
+{
+
+enum
+{
+  HEADER_SIZE = 3,
+};
+
+size_t Telemetry::encodeFields(const TelemetrySample& sample, const TelemetrySample& reference, uint8_t* payload)
+{
+  uint8_t mask = 0;
+  uint8_t* dst = payload + 1;
+  for (int i = 0; i < TelemetrySample::NUM_FIELDS; i++)
+  {
+    uint64_t value = zigzag(sample.field[i] - reference.field[i]);
+    if (value == 0) continue;
+
+    mask |= (1 << i);
+    while (value >= 0x80)
+    {
+      *dst++ = (uint8_t)(value | 0x80);
+      value >>= 7;
+    }
+    *dst++ = (uint8_t) value;
+  }
+  payload[0] = mask;
+  return dst - payload;
+}
+
+bool Telemetry::decodeFields(const uint8_t* payload, size_t size, const TelemetrySample& reference, TelemetrySample& sample)
+{
+  if (size < 1) return false;
+
+  uint8_t mask = payload[0];
+  const uint8_t* src = payload + 1;
+  const uint8_t* end = payload + size;
+  for (int i = 0; i < TelemetrySample::NUM_FIELDS; i++)
+  {
+    uint64_t value = 0;
+    if (mask & (1 << i))
+    {
+      int shift = 0;
+      for (;;)
+      {
+        if (src == end || shift > 63) return false;
+        uint8_t byte = *src++;
+        value |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) break;
+        shift += 7;
+      }
+    }
+    sample.field[i] = reference.field[i] + unzigzag(value);
+  }
+  return true;
+}
+
+TelemetryEncoder::TelemetryEncoder(int keyframe_interval) :
+  keyframe_interval_(keyframe_interval), frames_since_keyframe_(0),
+  has_keyframe_(false), keyframe_id_(0)
+{
+}
+
+void TelemetryEncoder::encode(const Packet& request, const TelemetrySample& sample, Packet& reply)
+{
+  bool acknowledged = has_keyframe_ && request.data.u8[1] != 0 && request.data.u8[0] == keyframe_id_;
+
+  if (!acknowledged || ++frames_since_keyframe_ >= keyframe_interval_)
+  {
+    keyframe_ = sample;
+    keyframe_id_++;
+    has_keyframe_ = true;
+    frames_since_keyframe_ = 0;
+
+    reply.data.u8[0] = Telemetry::KEYFRAME;
+    reply.data.u8[1] = keyframe_id_;
+    Telemetry::encodeFields(sample, TelemetrySample(), &reply.data.u8[2]);
+  }
+  else
+  {
+    reply.data.u8[0] = Telemetry::DELTA;
+    reply.data.u8[1] = keyframe_id_;
+    Telemetry::encodeFields(sample, keyframe_, &reply.data.u8[2]);
+  }
+}
+
+TelemetryDecoder::TelemetryDecoder() :
+  has_keyframe_(false), keyframe_id_(0)
+{
+}
+
+void TelemetryDecoder::prepareRequest(Packet& request)
+{
+  request.data.u8[0] = keyframe_id_;
+  request.data.u8[1] = has_keyframe_ ? 1 : 0;
+}
+
+bool TelemetryDecoder::decode(const Packet& reply, TelemetrySample& sample)
+{
+  const uint8_t* payload = &reply.data.u8[2];
+  size_t size = Packet::MAX_PAYLOAD - 2;
+
+  if (reply.data.u8[0] == Telemetry::KEYFRAME)
+  {
+    if (!Telemetry::decodeFields(payload, size, TelemetrySample(), sample))
+    {
+      return false;
+    }
+    keyframe_ = sample;
+    keyframe_id_ = reply.data.u8[1];
+    has_keyframe_ = true;
+    return true;
+  }
+  if (reply.data.u8[0] == Telemetry::DELTA)
+  {
+    // a delta against a keyframe other than ours cannot be reconstructed, ask for a new keyframe
+    if (!has_keyframe_ || reply.data.u8[1] != keyframe_id_)
+    {
+      has_keyframe_ = false;
+      return false;
+    }
+    return Telemetry::decodeFields(payload, size, keyframe_, sample);
+  }
+  return false;
+}
+
+}  // namespace zalpha_api
@@ -0,0 +1,153 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ZALPHA_API_IMPL_TELEMETRY_HPP
+#define ZALPHA_API_IMPL_TELEMETRY_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <zalpha_api/zalpha_api_export.h>
+#include "packet.hpp"
+
+
+namespace zalpha_api
+{
+
+/**
+ * \brief A telemetry sample, as carried by the GET_TELEMETRY command.
+ *
+ * The encoder distances are carried in micrometers, and the capture time in microseconds of the robot clock.
+ */
+struct ZALPHA_API_NO_EXPORT TelemetrySample
+{
+  enum
+  {
+    NUM_FIELDS = 6,
+  };
+
+  int64_t field[NUM_FIELDS];  ///< left count, right count, left distance (um), right distance (um), safety flag, capture time (us)
+
+  TelemetrySample()
+  {
+    for (int i = 0; i < NUM_FIELDS; i++) field[i] = 0;
+  }
+};
+
+/**
+ * \brief Telemetry frames of the GET_TELEMETRY command.
+ *
+ * The request tells the keyframe held by the client:
+ *
+ * <table>
+ * <tr><th>Data Offset</th><th>Size (bytes)</th><th>Description</th></tr>
+ * <tr><td>0</td><td>1</td><td>ID of the keyframe held by the client</td></tr>
+ * <tr><td>1</td><td>1</td><td>1 when the client holds a keyframe, 0 otherwise</td></tr>
+ * </table>
+ *
+ * The reply is either a keyframe or a delta against the keyframe acknowledged in the request:
+ *
+ * <table>
+ * <tr><th>Data Offset</th><th>Size (bytes)</th><th>Description</th></tr>
+ * <tr><td>0</td><td>1</td><td>Frame type, KEYFRAME or DELTA</td></tr>
+ * <tr><td>1</td><td>1</td><td>ID of the keyframe</td></tr>
+ * <tr><td>2</td><td>1</td><td>Bit i is set when field i is present</td></tr>
+ * <tr><td>3 - </td><td>1 - 10 each</td><td>The present fields, as zig-zag varints</td></tr>
+ * </table>
+ *
+ * A keyframe carries the fields against zero, and a delta carries the fields that differ from the keyframe.
+ * A field that is absent is zero. Since every delta refers to a keyframe, a lost frame never corrupts the next ones.
+ * A server that does not stamp its readings leaves the capture time out, which reads as 0.
+ */
+class ZALPHA_API_NO_EXPORT Telemetry
+{
+public:
+  enum
+  {
+    KEYFRAME = 0,
+    DELTA = 1,
+  };
+
+public:
+  static uint64_t zigzag(int64_t value)
+  {
+    return ((uint64_t) value << 1) ^ (uint64_t)(value >> 63);
+  }
+  static int64_t unzigzag(uint64_t value)
+  {
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+  }
+
+  /**
+   * \brief Write the fields of a sample that differ from a reference sample.
+   * @return                 The number of bytes written into the payload
+   */
+  static size_t encodeFields(const TelemetrySample& sample, const TelemetrySample& reference, uint8_t* payload);
+  /**
+   * \brief Read the fields written by encodeFields() on top of a reference sample.
+   * @return                 A boolean indicating whether the payload is well-formed
+   */
+  static bool decodeFields(const uint8_t* payload, size_t size, const TelemetrySample& reference, TelemetrySample& sample);
+};
+
+/**
+ * \brief TelemetryEncoder produces the GET_TELEMETRY replies on the API server.
+ */
+class ZALPHA_API_NO_EXPORT TelemetryEncoder
+{
+public:
+  enum
+  {
+    DEFAULT_KEYFRAME_INTERVAL = 50,  ///< Number of frames between the keyframes
+  };
+
+public:
+  explicit TelemetryEncoder(int keyframe_interval = DEFAULT_KEYFRAME_INTERVAL);
+
+  void encode(const Packet& request, const TelemetrySample& sample, Packet& reply);
+
+private:
+  int keyframe_interval_;
+  int frames_since_keyframe_;
+  bool has_keyframe_;
+  uint8_t keyframe_id_;
+  TelemetrySample keyframe_;
+};
+
+/**
+ * \brief TelemetryDecoder reconstructs the full samples on the client.
+ */
+class ZALPHA_API_NO_EXPORT TelemetryDecoder
+{
+public:
+  TelemetryDecoder();
+
+  void reset()
+  {
+    has_keyframe_ = false;
+  }
+  void prepareRequest(Packet& request);
+  bool decode(const Packet& reply, TelemetrySample& sample);
+
+private:
+  bool has_keyframe_;
+  uint8_t keyframe_id_;
+  TelemetrySample keyframe_;
+};
+
+}  // namespace zalpha_api
+
+#endif  // ZALPHA_API_IMPL_TELEMETRY_HPP
@@ -0,0 +1,87 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstring>
+#include <sstream>
+
+#include "transport.hpp"
+#include "zmq_transport.hpp"
+#ifndef _WINDOWS
+#include "udp_transport.hpp"
+#endif
+#ifdef __linux__
+#include "shm_transport.hpp"
+#endif
+
+
+namespace zalpha_api
+{
+
+Transport::Transport() :
+  timeout_(-1), encoding_(0), bytes_sent_(0), bytes_received_(0), errnum_(0), errtext_("")
+{
+}
+
+Transport::~Transport()
+{
+}
+
+void Transport::getConnectionStatus(ConnectionStatus& status)
+{
+  std::memset(&status, 0, sizeof(status));
+  status.state = Zalpha::CS_UNKNOWN;
+}
+
+std::string Transport::resolveUrl(const std::string& server_address)
+{
+  if (server_address.find("://") != std::string::npos)
+  {
+    return server_address;
+  }
+
+  std::ostringstream oss;
+  oss << "tcp://" << server_address;
+  if (server_address.find(':') == std::string::npos)
+  {
+    oss << ":" << DEFAULT_PORT;
+  }
+  return oss.str();
+}
+
+Transport* Transport::create(const std::string& url)
+{
+  std::string scheme = url.substr(0, url.find("://"));
+
+  if (scheme == "tcp" || scheme == "ipc" || scheme == "inproc")
+  {
+    return new ZmqTransport();
+  }
+#ifndef _WINDOWS
+  if (scheme == "udp")
+  {
+    return new UdpTransport();
+  }
+#endif
+#ifdef __linux__
+  if (scheme == "shm")
+  {
+    return new ShmTransport();
+  }
+#endif
+  return NULL;
+}
+
+}  // namespace zalpha_api
@@ -0,0 +1,176 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ZALPHA_API_IMPL_TRANSPORT_HPP
+#define ZALPHA_API_IMPL_TRANSPORT_HPP
+
+#include <stdint.h>
+#include <string>
+#include <zmq.h>
+
+#include <zalpha_api/zalpha_api_export.h>
+#include <zalpha_api/zalpha.hpp>
+
+
+namespace zalpha_api
+{
+
+class ZALPHA_API_NO_EXPORT Packet;
+
+/**
+ * \brief Transport is the interface used by ZalphaImpl to exchange packets with the API server.
+ *
+ * A transport is created for a single endpoint URL, and carries one request and its reply at a time.
+ */
+class ZALPHA_API_NO_EXPORT Transport
+{
+public:
+  enum
+  {
+    DEFAULT_PORT = 17167,
+  };
+
+public:
+  Transport();
+  virtual ~Transport();
+
+  /**
+   * \brief Convert a server address into an endpoint URL.
+   *
+   * An address containing "://" is returned unchanged. A "host:port" address and a plain "host" address
+   * are mapped to the tcp:// transport, the latter using DEFAULT_PORT.
+   */
+  static std::string resolveUrl(const std::string& server_address);
+  /**
+   * \brief Create the transport that handles the scheme of the given URL.
+   * @return                 The new transport, or NULL if the scheme is not supported
+   */
+  static Transport* create(const std::string& url);
+
+  virtual bool connect(const std::string& url) = 0;
+  virtual void disconnect() = 0;
+
+  /**
+   * \brief Set the time to wait for a reply, in ms. A negative value waits forever.
+   */
+  virtual void setTimeout(int timeout)
+  {
+    timeout_ = timeout;
+  }
+
+  /**
+   * \brief Set the wire encoding of the requests, see Codec. The replies are accepted in either encoding.
+   */
+  void setEncoding(int encoding)
+  {
+    encoding_ = encoding;
+  }
+
+  virtual bool sendRequest(const Packet& packet) = 0;
+  virtual bool waitReply(Packet& packet) = 0;
+
+  /**
+   * \brief Describe the socket to wait on for a reply with zmq_poll(), so that many transports are waited on at once.
+   *
+   * Once the socket is readable, waitReply() returns the reply without waiting, when the timeout is 0.
+   *
+   * @return                 A boolean indicating whether the transport can be polled
+   */
+  virtual bool getPollItem(zmq_pollitem_t& /* item */)
+  {
+    return false;
+  }
+
+  /**
+   * \brief Follow the sessions of the connection, see getConnectionStatus(). Call before connect().
+   */
+  virtual void setMonitored(bool /* monitored */)
+  {
+  }
+  /**
+   * \brief Fail the requests while the monitored connection is down. Call before connect().
+   */
+  virtual void setFailFast(bool /* fail_fast */)
+  {
+  }
+  /**
+   * \brief The sessions of the connection, with the state Zalpha::CS_UNKNOWN when they are not followed.
+   */
+  virtual void getConnectionStatus(ConnectionStatus& status);
+
+  /**
+   * \brief The number of bytes sent and received, excluding the framing of the underlying protocol.
+   */
+  void getTrafficCounters(uint64_t& bytes_sent, uint64_t& bytes_received)
+  {
+    bytes_sent = bytes_sent_;
+    bytes_received = bytes_received_;
+  }
+
+  int getError()
+  {
+    return errnum_;
+  }
+  /**
+   * \brief The error message, valid until the next error of the transport, without a copy.
+   */
+  const char* getErrorText()
+  {
+    return errtext_;
+  }
+  /**
+   * \brief Whether the error message is a string literal, which stays valid after the next error.
+   */
+  bool hasFixedErrorText()
+  {
+    return errtext_ != errmsg_.c_str();
+  }
+  std::string getErrorMessage()
+  {
+    return errtext_;
+  }
+
+protected:
+  void setError(int errnum, const std::string& errmsg)
+  {
+    errnum_ = errnum;
+    errmsg_ = errmsg;
+    errtext_ = errmsg_.c_str();
+  }
+  /**
+   * \brief Record an error with a fixed message, a string literal, which is kept without a copy.
+   */
+  void setError(int errnum, const char* errmsg)
+  {
+    errnum_ = errnum;
+    errtext_ = errmsg;
+  }
+
+protected:
+  int timeout_;
+  int encoding_;
+  uint64_t bytes_sent_;
+  uint64_t bytes_received_;
+
+private:
+  int errnum_;
+  std::string errmsg_;
+  const char* errtext_;  ///< the fixed message, or errmsg_
+};
+
+}  // namespace zalpha_api
+
+#endif  // ZALPHA_API_IMPL_TRANSPORT_HPP
@@ -0,0 +1,187 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <sstream>
+
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "udp_transport.hpp"
+#include "codec.hpp"
+#include "packet.hpp"
+
+
+namespace zalpha_api
+{
+
+UdpTransport::UdpTransport() :
+  fd_(-1), sequence_(0)
+{
+}
+
+UdpTransport::~UdpTransport()
+{
+  disconnect();
+}
+
+bool UdpTransport::connect(const std::string& url)
+{
+  // udp://host[:port]
+  std::string address = url.substr(url.find("://") + 3);
+  std::string host = address;
+  std::ostringstream port;
+  size_t pos = address.rfind(':');
+  if (pos != std::string::npos)
+  {
+    host = address.substr(0, pos);
+    port << address.substr(pos + 1);
+  }
+  else
+  {
+    port << DEFAULT_PORT;
+  }
+
+  struct addrinfo hints;
+  std::memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_DGRAM;
+
+  struct addrinfo* result;
+  int rc = getaddrinfo(host.c_str(), port.str().c_str(), &hints, &result);
+  if (rc != 0)
+  {
+    setError(Packet::INVALID_ENDPOINT, std::string(gai_strerror(rc)));
+    return false;
+  }
+
+  for (struct addrinfo* ai = result; ai != NULL; ai = ai->ai_next)
+  {
+    fd_ = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+    if (fd_ < 0) continue;
+
+    // a connected datagram socket only receives from the server address
+    if (::connect(fd_, ai->ai_addr, ai->ai_addrlen) == 0) break;
+
+    close(fd_);
+    fd_ = -1;
+  }
+  freeaddrinfo(result);
+
+  if (fd_ < 0)
+  {
+    setError(errno, std::string(strerror(errno)));
+    return false;
+  }
+  return true;
+}
+
+void UdpTransport::disconnect()
+{
+  if (fd_ < 0) return;
+
+  close(fd_);
+  fd_ = -1;
+}
+
+bool UdpTransport::sendRequest(const Packet& packet)
+{
+  // sequence number 0 is reserved for transports without sequencing
+  if (++sequence_ == 0)
+  {
+    ++sequence_;
+  }
+
+  Packet request = packet;
+  request.reserved[0] = sequence_;
+
+  uint8_t buffer[Codec::MAX_SIZE];
+  size_t size = Codec::encode(request, encoding_, buffer);
+  if (send(fd_, buffer, size, 0) != (ssize_t) size)
+  {
+    setError(errno, std::string(strerror(errno)));
+    return false;
+  }
+  bytes_sent_ += size;
+  return true;
+}
+
+bool UdpTransport::waitReply(Packet& packet)
+{
+  typedef std::chrono::steady_clock Clock;
+  int timeout = (timeout_ >= 0) ? timeout_ : DEFAULT_TIMEOUT;
+  Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(timeout);
+
+  for (;;)
+  {
+    int remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+    if (remaining < 0)
+    {
+      remaining = 0;
+    }
+
+    struct pollfd pfd;
+    pfd.fd = fd_;
+    pfd.events = POLLIN;
+    int rc = poll(&pfd, 1, remaining);
+    if (rc < 0 && errno != EINTR)
+    {
+      setError(errno, std::string(strerror(errno)));
+      return false;
+    }
+    if (rc == 0)
+    {
+      setError(Packet::TIMEOUT, "Timed out waiting for reply.");
+      return false;
+    }
+    if (rc < 0) continue;
+
+    // one spare byte, so that an oversized datagram is not silently truncated into a valid size
+    uint8_t buffer[Codec::MAX_SIZE + 1];
+    ssize_t size = recv(fd_, buffer, sizeof(buffer), 0);
+    if (size < 0)
+    {
+      // ECONNREFUSED is reported here when nothing listens on the server port
+      setError(errno, std::string(strerror(errno)));
+      return false;
+    }
+    bytes_received_ += size;
+
+    // discard malformed datagrams and late replies of earlier requests
+    Packet reply;
+    if (!Codec::decode(buffer, size, reply) || reply.reserved[0] != sequence_) continue;
+
+    packet = reply;
+    return true;
+  }
+}
+
+bool UdpTransport::getPollItem(zmq_pollitem_t& item)
+{
+  if (fd_ < 0) return false;
+
+  item.socket = NULL;
+  item.fd = fd_;
+  item.events = ZMQ_POLLIN;
+  item.revents = 0;
+  return true;
+}
+
+}  // namespace zalpha_api
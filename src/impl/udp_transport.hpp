@@ -0,0 +1,64 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ZALPHA_API_IMPL_UDP_TRANSPORT_HPP
+#define ZALPHA_API_IMPL_UDP_TRANSPORT_HPP
+
+#include <stdint.h>
+
+#include <zalpha_api/zalpha_api_export.h>
+#include "transport.hpp"
+
+
+namespace zalpha_api
+{
+
+/**
+ * \brief UdpTransport sends each packet as a single datagram, without any ZMQ framing.
+ *
+ * Every request is stamped with a new sequence number in Packet::reserved[0], and only the reply
+ * carrying the same sequence number is accepted. Late replies of earlier requests are discarded,
+ * so a lost datagram never delays the following requests.
+ *
+ * The transport never retransmits by itself. Retries of idempotent reads are left to the caller.
+ */
+class ZALPHA_API_NO_EXPORT UdpTransport : public Transport
+{
+public:
+  enum
+  {
+    DEFAULT_TIMEOUT = 500,  ///< Timeout used when none is set, in ms. A datagram may never get a reply.
+  };
+
+public:
+  UdpTransport();
+  virtual ~UdpTransport();
+
+  virtual bool connect(const std::string& url);
+  virtual void disconnect();
+
+  virtual bool sendRequest(const Packet& packet);
+  virtual bool waitReply(Packet& packet);
+  virtual bool getPollItem(zmq_pollitem_t& item);
+
+private:
+  int fd_;
+  uint16_t sequence_;
+};
+
+}  // namespace zalpha_api
+
+#endif  // ZALPHA_API_IMPL_UDP_TRANSPORT_HPP
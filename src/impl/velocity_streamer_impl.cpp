@@ -0,0 +1,290 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <sys/mman.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "velocity_streamer_impl.hpp"
+#include "monotonic_clock.hpp"
+#include "packet.hpp"
+
+
+namespace zalpha_api
+{
+
+enum
+{
+  PREFAULT_STACK_SIZE = 64 * 1024,
+};
+
+static uint64_t packTarget(float left_speed, float right_speed)
+{
+  float speeds[2] = { left_speed, right_speed };
+  uint64_t target;
+  std::memcpy(&target, speeds, sizeof(target));
+  return target;
+}
+
+static void unpackTarget(uint64_t target, float& left_speed, float& right_speed)
+{
+  float speeds[2];
+  std::memcpy(speeds, &target, sizeof(speeds));
+  left_speed = speeds[0];
+  right_speed = speeds[1];
+}
+
+VelocityStreamerImpl::VelocityStreamerImpl() :
+  connected_(false), priority_(0), cpu_(-1), lock_memory_(false),
+  period_(0), delay_target_(0), max_period_(0), saved_timeout_(-1), saved_retries_(0), running_(false),
+  target_(packTarget(0.0f, 0.0f))
+{
+  resetStatistics();
+}
+
+VelocityStreamerImpl::~VelocityStreamerImpl()
+{
+  disconnect();
+}
+
+bool VelocityStreamerImpl::connect(const std::string& server_address)
+{
+  if (!zalpha_.connect(server_address))
+  {
+    worker_.setCommandError(zalpha_);
+    return false;
+  }
+  connected_ = true;
+  return true;
+}
+
+void VelocityStreamerImpl::disconnect()
+{
+  stop();
+  zalpha_.disconnect();
+  connected_ = false;
+}
+
+void VelocityStreamerImpl::setRealtime(int priority, int cpu, bool lock_memory)
+{
+  priority_ = priority;
+  cpu_ = cpu;
+  lock_memory_ = lock_memory;
+}
+
+void VelocityStreamerImpl::setAdaptiveRate(int delay_target, int max_period)
+{
+  delay_target_ = std::max(delay_target, 0);
+  max_period_ = max_period;
+}
+
+bool VelocityStreamerImpl::start(int period)
+{
+  if (!connected_)
+  {
+    worker_.setError(Packet::DISCONNECTED, "Disconnected from API server.");
+    return false;
+  }
+  if (worker_.started())
+  {
+    worker_.setError(Packet::RESULT_ERROR_BUSY, "Streamer is already started.");
+    return false;
+  }
+  if (period <= 0 || (delay_target_ > 0 && max_period_ < period))
+  {
+    worker_.setError(Packet::RESULT_ERROR_INVALID_COMMAND, "Invalid parameters in API call.");
+    return false;
+  }
+
+  if (lock_memory_ && mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+  {
+    worker_.setSystemError("Failed to lock memory", errno);
+    return false;
+  }
+
+  // a reply later than the next deadline is of no use, the next command supersedes it
+  period_ = period;
+  zalpha_.getTimeout(saved_timeout_, saved_retries_);
+  zalpha_.setTimeout(std::max(period / 1000, 1), 0);
+  resetStatistics();
+
+  running_ = true;
+  int error = worker_.start(&VelocityStreamerImpl::threadMain, this, priority_, cpu_);
+  if (error != 0)
+  {
+    running_ = false;
+    zalpha_.setTimeout(saved_timeout_, saved_retries_);
+    worker_.setSystemError("Failed to start the streaming thread", error);
+    return false;
+  }
+  return true;
+}
+
+void VelocityStreamerImpl::stop()
+{
+  if (!worker_.started()) return;
+
+  running_ = false;
+  worker_.join();
+  zalpha_.setTimeout(saved_timeout_, saved_retries_);
+}
+
+void VelocityStreamerImpl::setTarget(float left_speed, float right_speed)
+{
+  target_ = packTarget(left_speed, right_speed);
+}
+
+void VelocityStreamerImpl::getStatistics(StreamerStatistics& statistics)
+{
+  worker_.lock();
+  statistics = statistics_;
+  uint64_t periods = (statistics_.commands > 1) ? statistics_.commands - 1 : 0;
+  if (periods > 0)
+  {
+    statistics.mean_period = sum_period_ / periods;
+    double variance = sum_period_squared_ / periods - statistics.mean_period * statistics.mean_period;
+    statistics.jitter = std::sqrt(std::max(variance, 0.0));
+  }
+  if (statistics_.commands > 0)
+  {
+    statistics.mean_round_trip = sum_round_trip_ / statistics_.commands;
+  }
+  worker_.unlock();
+}
+
+void VelocityStreamerImpl::resetStatistics()
+{
+  worker_.lock();
+  std::memset(&statistics_, 0, sizeof(statistics_));
+  last_start_ = -1;
+  sum_period_ = 0.0;
+  sum_period_squared_ = 0.0;
+  sum_round_trip_ = 0.0;
+  worker_.unlock();
+}
+
+int VelocityStreamerImpl::getError()
+{
+  return worker_.getError();
+}
+
+std::string VelocityStreamerImpl::getErrorMessage()
+{
+  return worker_.getErrorMessage();
+}
+
+void* VelocityStreamerImpl::threadMain(void* arg)
+{
+  static_cast<VelocityStreamerImpl*>(arg)->run();
+  return NULL;
+}
+
+void VelocityStreamerImpl::run()
+{
+  // touch the stack up front, so that a deep call does not page fault in the middle of a period
+  volatile char stack[PREFAULT_STACK_SIZE];
+  std::memset((char*) stack, 0, sizeof(stack));
+
+  int64_t deadline = monotonicNow();
+  int64_t period = period_;
+  while (running_)
+  {
+    WorkerThread::sleepUntil(deadline);
+    if (!running_) break;
+
+    float left_speed, right_speed;
+    unpackTarget(target_, left_speed, right_speed);
+
+    int64_t start = monotonicNow();
+    bool success = zalpha_.setTargetSpeed(left_speed, right_speed);
+    int64_t end = monotonicNow();
+
+    // skip the deadlines that passed during an overrun instead of catching up with a burst
+    uint64_t missed = 0;
+    int64_t next = deadline + period;
+    if (end >= next)
+    {
+      missed = (end - next) / period + 1;
+      next += missed * period;
+    }
+    record(deadline, start, end, missed, period, success);
+    deadline = next;
+
+    if (delay_target_ > 0)
+    {
+      // the next deadline is kept, the new period applies from there on
+      period = adaptPeriod(period, success);
+    }
+  }
+}
+
+int64_t VelocityStreamerImpl::adaptPeriod(int64_t period, bool success)
+{
+  LinkQuality quality;
+  zalpha_.getLinkQuality(quality);
+  int64_t latency = (int64_t)(quality.rtt + 4.0 * quality.rtt_variation);
+  double queueing = quality.rtt - quality.min;
+
+  // back off quickly on a congested link, and come back in about 16 commands otherwise
+  int64_t next;
+  if (!success || queueing > delay_target_)
+  {
+    next = period + period / 4;
+  }
+  else
+  {
+    next = period - std::max(period / 16, (int64_t) 1);
+  }
+  next = std::max(next, latency);
+  next = std::min(std::max(next, (int64_t) period_), (int64_t) max_period_);
+
+  if (next / 1000 != period / 1000)
+  {
+    zalpha_.setTimeout(std::max((int) (next / 1000), 1), 0);
+  }
+  return next;
+}
+
+void VelocityStreamerImpl::record(int64_t deadline, int64_t start, int64_t end, uint64_t missed, int64_t period,
+                                  bool success)
+{
+  worker_.lock();
+  if (last_start_ >= 0)
+  {
+    int64_t interval = start - last_start_;
+    if (statistics_.commands == 1 || interval < statistics_.min_period) statistics_.min_period = interval;
+    if (interval > statistics_.max_period) statistics_.max_period = interval;
+    sum_period_ += interval;
+    sum_period_squared_ += (double) interval * interval;
+  }
+  last_start_ = start;
+
+  statistics_.commands++;
+  statistics_.missed_deadlines += missed;
+  statistics_.period = period;
+  statistics_.max_lateness = std::max(statistics_.max_lateness, start - deadline);
+  sum_round_trip_ += end - start;
+  if (!success)
+  {
+    statistics_.failures++;
+    worker_.setCommandError(zalpha_);
+  }
+  worker_.unlock();
+}
+
+}  // namespace zalpha_api
@@ -0,0 +1,87 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ZALPHA_API_IMPL_VELOCITY_STREAMER_IMPL_HPP
+#define ZALPHA_API_IMPL_VELOCITY_STREAMER_IMPL_HPP
+
+#include <stdint.h>
+#include <atomic>
+#include <string>
+
+#include <zalpha_api/zalpha_api_export.h>
+#include <zalpha_api/velocity_streamer.hpp>
+#include "worker_thread.hpp"
+#include "zalpha_impl.hpp"
+
+
+namespace zalpha_api
+{
+
+/**
+ * \brief VelocityStreamerImpl is an internal implementation class that provides the velocity streaming thread.
+ */
+class ZALPHA_API_NO_EXPORT VelocityStreamerImpl
+{
+public:
+  VelocityStreamerImpl();
+  virtual ~VelocityStreamerImpl();
+
+  bool connect(const std::string& server_address);
+  void disconnect();
+  void setRealtime(int priority, int cpu, bool lock_memory);
+  void setAdaptiveRate(int delay_target, int max_period);
+  bool start(int period);
+  void stop();
+  void setTarget(float left_speed, float right_speed);
+  void getStatistics(StreamerStatistics& statistics);
+  void resetStatistics();
+
+  int getError();
+  std::string getErrorMessage();
+
+private:
+  static void* threadMain(void* arg);
+  void run();
+  int64_t adaptPeriod(int64_t period, bool success);
+  void record(int64_t deadline, int64_t start, int64_t end, uint64_t missed, int64_t period, bool success);
+
+private:
+  ZalphaImpl zalpha_;
+  bool connected_;
+
+  int priority_;
+  int cpu_;
+  bool lock_memory_;
+
+  int period_;
+  int delay_target_;
+  int max_period_;
+  int saved_timeout_;  ///< the timeout of the connection before start(), restored by stop()
+  int saved_retries_;
+  std::atomic<bool> running_;
+  std::atomic<uint64_t> target_;  ///< the left and right speeds, packed to be exchanged without a lock
+
+  WorkerThread worker_;  ///< its mutex guards the statistics
+  StreamerStatistics statistics_;
+  int64_t last_start_;
+  double sum_period_;
+  double sum_period_squared_;
+  double sum_round_trip_;
+};
+
+}  // namespace zalpha_api
+
+#endif  // ZALPHA_API_IMPL_VELOCITY_STREAMER_IMPL_HPP
@@ -0,0 +1,147 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <sched.h>
+#include <cstring>
+
+#include "worker_thread.hpp"
+#include "monotonic_clock.hpp"
+#include "packet.hpp"
+
+
+namespace zalpha_api
+{
+
+WorkerThread::WorkerThread() :
+  started_(false), errnum_(0)
+{
+  pthread_mutexattr_t attr;
+  pthread_mutexattr_init(&attr);
+  pthread_mutexattr_setprotocol(&attr, PTHREAD_PRIO_INHERIT);
+  pthread_mutex_init(&mutex_, &attr);
+  pthread_mutexattr_destroy(&attr);
+}
+
+WorkerThread::~WorkerThread()
+{
+  join();
+  pthread_mutex_destroy(&mutex_);
+}
+
+void WorkerThread::initCondition(pthread_cond_t* cond)
+{
+  pthread_condattr_t attr;
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+  pthread_cond_init(cond, &attr);
+  pthread_condattr_destroy(&attr);
+}
+
+void WorkerThread::sleepUntil(int64_t deadline)
+{
+  struct timespec ts = toTimespec(deadline);
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+  {
+  }
+}
+
+int WorkerThread::start(void* (*main)(void*), void* arg, int priority, int cpu)
+{
+  pthread_attr_t attr;
+  pthread_attr_init(&attr);
+  if (priority > 0)
+  {
+    struct sched_param param;
+    std::memset(&param, 0, sizeof(param));
+    param.sched_priority = priority;
+    pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+    pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+    pthread_attr_setschedparam(&attr, &param);
+  }
+  if (cpu >= 0)
+  {
+#ifdef __linux__
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+    pthread_attr_setaffinity_np(&attr, sizeof(cpus), &cpus);
+#else
+    pthread_attr_destroy(&attr);
+    return ENOTSUP;
+#endif
+  }
+
+  int error = pthread_create(&thread_, &attr, main, arg);
+  pthread_attr_destroy(&attr);
+  started_ = (error == 0);
+  return error;
+}
+
+void WorkerThread::join()
+{
+  if (!started_) return;
+
+  pthread_join(thread_, NULL);
+  started_ = false;
+}
+
+bool WorkerThread::wait(pthread_cond_t* cond, int64_t deadline)
+{
+  if (deadline < 0)
+  {
+    pthread_cond_wait(cond, &mutex_);
+    return true;
+  }
+  struct timespec ts = toTimespec(deadline);
+  return pthread_cond_timedwait(cond, &mutex_, &ts) != ETIMEDOUT;
+}
+
+void WorkerThread::setError(int errnum, const std::string& errmsg)
+{
+  errnum_ = errnum;
+  errmsg_ = errmsg;
+}
+
+void WorkerThread::setCommandError(ZalphaImpl& zalpha)
+{
+  errnum_ = zalpha.getError();
+  errmsg_ = zalpha.getErrorMessage();
+}
+
+void WorkerThread::setSystemError(const std::string& what, int error)
+{
+  errnum_ = Packet::SYSTEM_ERROR;
+  errmsg_ = what + ": " + std::strerror(error) + ".";
+}
+
+int WorkerThread::getError()
+{
+  lock();
+  int errnum = errnum_;
+  unlock();
+  return errnum;
+}
+
+std::string WorkerThread::getErrorMessage()
+{
+  lock();
+  std::string errmsg = errmsg_;
+  unlock();
+  return errmsg;
+}
+
+}  // namespace zalpha_api
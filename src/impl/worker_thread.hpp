@@ -0,0 +1,107 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ZALPHA_API_IMPL_WORKER_THREAD_HPP
+#define ZALPHA_API_IMPL_WORKER_THREAD_HPP
+
+#include <pthread.h>
+#include <stdint.h>
+#include <string>
+
+#include <zalpha_api/zalpha_api_export.h>
+#include "zalpha_impl.hpp"
+
+
+namespace zalpha_api
+{
+
+/**
+ * \brief WorkerThread is the POSIX thread of a helper component, such as VelocityStreamer, with its mutex and error.
+ *
+ * The mutex has priority inheritance, so that a real-time thread is not held up by the threads that read its state,
+ * and the conditions wait on CLOCK_MONOTONIC, the clock of monotonicNow().
+ */
+class ZALPHA_API_NO_EXPORT WorkerThread
+{
+public:
+  WorkerThread();
+  virtual ~WorkerThread();
+
+  /**
+   * \brief Initialize a condition of the component on CLOCK_MONOTONIC, to be destroyed by the component.
+   */
+  static void initCondition(pthread_cond_t* cond);
+  /**
+   * \brief Sleep until a time of monotonicNow().
+   */
+  static void sleepUntil(int64_t deadline);
+
+  /**
+   * \brief Start the thread, with the SCHED_FIFO policy at a positive priority, and pinned to a non-negative cpu.
+   * @return                 0, or the error number
+   */
+  int start(void* (*main)(void*), void* arg, int priority = 0, int cpu = -1);
+  /**
+   * \brief Wait for the end of the thread, if started.
+   */
+  void join();
+  bool started() const
+  {
+    return started_;
+  }
+
+  void lock()
+  {
+    pthread_mutex_lock(&mutex_);
+  }
+  void unlock()
+  {
+    pthread_mutex_unlock(&mutex_);
+  }
+  /**
+   * \brief Wait on a condition with the mutex locked, until a time of monotonicNow() or forever when negative.
+   * @return                 A boolean indicating whether the condition was signaled before the time
+   */
+  bool wait(pthread_cond_t* cond, int64_t deadline);
+
+  /**
+   * \brief Record an error, with the mutex locked or while the thread does not run.
+   */
+  void setError(int errnum, const std::string& errmsg);
+  /**
+   * \brief Record the error of the last command that failed on a connection, like setError().
+   */
+  void setCommandError(ZalphaImpl& zalpha);
+  /**
+   * \brief Record the failure of a system call, like setError().
+   */
+  void setSystemError(const std::string& what, int error);
+  int getError();
+  std::string getErrorMessage();
+
+private:
+  pthread_t thread_;
+  bool started_;
+
+  pthread_mutex_t mutex_;  ///< guards the state of the component and the error
+
+  int errnum_;
+  std::string errmsg_;
+};
+
+}  // namespace zalpha_api
+
+#endif  // ZALPHA_API_IMPL_WORKER_THREAD_HPP
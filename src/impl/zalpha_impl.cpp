@@ -14,19 +14,26 @@
  * limitations under the License.
  */
 
-#include <sstream>
-
 #include "zalpha_impl.hpp"
+#include <algorithm>
 #include "packet.hpp"
+#include "transport.hpp"
 
 
 namespace zalpha_api
 {
 
+/**
+ * \brief The error of the last command of this thread, or 0, which the commands of other threads leave alone.
+ */
+static thread_local int thread_error = 0;
+
 ZalphaImpl::ZalphaImpl() :
-  context_(1),
-  socket_(context_, ZMQ_REQ),
-  connected_(false), errnum_(0)
+  connected_(false), timeout_(-1), retries_(0), motion_lifetime_(-1), monitored_(false), fail_fast_(false),
+  read_max_age_(0), shared_reads_(0), reused_reads_(0),
+  priority_timeout_(DEFAULT_PRIORITY_TIMEOUT), priority_retries_(DEFAULT_PRIORITY_RETRIES),
+  priority_attempts_(DEFAULT_PRIORITY_RETRIES + 1), halt_client_(0), halt_count_(0), limits_requested_(false), errnum_(0),
+  errtext_("")
 {
 }
 
@@ -34,27 +41,62 @@ ZalphaImpl::~ZalphaImpl()
 {
 }
 
-bool ZalphaImpl::connect(const std::string& server_ip)
+bool ZalphaImpl::connect(const std::string& server_address)
 {
   if (connected_)
   {
-    errnum_ = Packet::CONNECTED;
-    errmsg_ = "Already connected to API server.";
+    setError(Packet::CONNECTED, "Already connected to API server.");
     return false;
   }
 
-  std::ostringstream oss;
-  oss << "tcp://" << server_ip << ":17167";
-  server_url_ = oss.str();
+  server_url_ = Transport::resolveUrl(server_address);
+
+  transport_.reset(Transport::create(server_url_));
+  if (!transport_.get())
+  {
+    setError(Packet::INVALID_ENDPOINT, "Unsupported endpoint: " + server_url_);
+    return false;
+  }
 
-  try
+  transport_->setTimeout(timeout_);
+  // the ordinary lane follows the sessions for both, the priority lane always attempts its halt commands
+  transport_->setMonitored(monitored_ || fail_fast_);
+  transport_->setFailFast(fail_fast_);
+  telemetry_.reset();
+  clock_.reset();
+  resetLinkQuality();
+  {
+    std::lock_guard<std::mutex> lock(flight_mutex_);
+    spare_flights_.clear();
+    flights_.clear();
+  }
+  {
+    std::lock_guard<std::mutex> lock(encoder_mutex_);
+    encoder_.reset();
+    limits_requested_ = false;
+  }
+  if (!transport_->connect(server_url_))
   {
-    socket_.connect(server_url_.c_str());
+    setError(*transport_);
+    transport_.reset();
+    return false;
   }
-  catch (const zmq::error_t& ex)
+
+  // the priority lane has its own socket, and its own sequence numbers on the transports that use them
+  std::lock_guard<std::mutex> lock(priority_mutex_);
+  // a client of its own for every connection, so that the server does not order it with the earlier ones
+  uint32_t mix = (uint32_t) (ClockSync::now() ^ ((uint64_t) (uintptr_t) this >> 4));
+  uint16_t client = (uint16_t) (mix ^ (mix >> 16));
+  halt_client_ = (uint32_t) (client ? client : 1) << 16;
+  halt_count_ = 0;
+  priority_transport_.reset(Transport::create(server_url_));
+  updatePriorityTimeout();
+  if (!priority_transport_->connect(server_url_))
   {
-    errnum_ = ex.num();
-    errmsg_ = ex.what();
+    setError(*priority_transport_);
+    priority_transport_.reset();
+    transport_->disconnect();
+    transport_.reset();
     return false;
   }
 
@@ -66,17 +108,155 @@ void ZalphaImpl::disconnect()
 {
   if (!connected_) return;
 
-  try
+  transport_->disconnect();
+  transport_.reset();
+
+  // waits for a priority command in flight
+  std::lock_guard<std::mutex> lock(priority_mutex_);
+  priority_transport_->disconnect();
+  priority_transport_.reset();
+
+  connected_ = false;
+}
+
+void ZalphaImpl::setTimeout(int timeout, int retries)
+{
+  timeout_ = timeout;
+  retries_ = (retries > 0) ? retries : 0;
+  if (transport_.get())
   {
-    socket_.disconnect(server_url_.c_str());
+    transport_->setTimeout(timeout_);
   }
-  catch (const zmq::error_t& ex)
+  std::lock_guard<std::mutex> lock(priority_mutex_);
+  updatePriorityTimeout();
+}
+
+void ZalphaImpl::getTimeout(int& timeout, int& retries)
+{
+  timeout = timeout_;
+  retries = retries_;
+}
+
+void ZalphaImpl::getConnectionStatus(ConnectionStatus& status)
+{
+  if (!connected_)
   {
-    errnum_ = ex.num();
-    errmsg_ = ex.what();
+    std::memset(&status, 0, sizeof(status));
+    status.state = Zalpha::CS_DISCONNECTED;
+    return;
   }
+  transport_->getConnectionStatus(status);
+}
 
-  connected_ = false;
+void ZalphaImpl::setMonitored(bool enable)
+{
+  monitored_ = enable;
+}
+
+void ZalphaImpl::setFailFast(bool enable)
+{
+  fail_fast_ = enable;
+}
+
+void ZalphaImpl::setMotionLifetime(int lifetime)
+{
+  motion_lifetime_ = lifetime;
+}
+
+void ZalphaImpl::setPriorityTimeout(int timeout, int retries)
+{
+  std::lock_guard<std::mutex> lock(priority_mutex_);
+  priority_timeout_ = timeout;
+  priority_retries_ = (retries > 0) ? retries : 0;
+  updatePriorityTimeout();
+}
+
+void ZalphaImpl::setReadCollapsing(int max_age)
+{
+  std::lock_guard<std::mutex> lock(flight_mutex_);
+  read_max_age_ = max_age;
+}
+
+void ZalphaImpl::getCollapsedReads(uint64_t& shared, uint64_t& reused)
+{
+  std::lock_guard<std::mutex> lock(flight_mutex_);
+  shared = shared_reads_;
+  reused = reused_reads_;
+}
+
+bool ZalphaImpl::setWireEncoding(uint8_t encoding)
+{
+  Packet packet;
+  packet.data.u8[0] = encoding;
+  if (!executeCommand(packet, Packet::SET_ENCODING) || !isResultOk(packet))
+  {
+    return false;
+  }
+  transport_->setEncoding(encoding);
+  std::lock_guard<std::mutex> lock(priority_mutex_);
+  priority_transport_->setEncoding(encoding);
+  return true;
+}
+
+void ZalphaImpl::getTrafficCounters(uint64_t& bytes_sent, uint64_t& bytes_received)
+{
+  bytes_sent = bytes_received = 0;
+  if (transport_.get())
+  {
+    transport_->getTrafficCounters(bytes_sent, bytes_received);
+  }
+  std::lock_guard<std::mutex> lock(priority_mutex_);
+  if (priority_transport_.get())
+  {
+    uint64_t priority_sent, priority_received;
+    priority_transport_->getTrafficCounters(priority_sent, priority_received);
+    bytes_sent += priority_sent;
+    bytes_received += priority_received;
+  }
+}
+
+void ZalphaImpl::getLinkQuality(LinkQuality& quality)
+{
+  std::lock_guard<std::mutex> lock(link_mutex_);
+  link_.getQuality(quality);
+}
+
+void ZalphaImpl::resetLinkQuality()
+{
+  std::lock_guard<std::mutex> lock(link_mutex_);
+  link_.reset();
+}
+
+bool ZalphaImpl::syncClock(int probes)
+{
+  for (int i = 0; i < probes; i++)
+  {
+    Packet packet;
+    RoundTrip round_trip;
+    if (!executeCommand(packet, Packet::TIME_SYNC, &round_trip))
+    {
+      return false;
+    }
+    // a server without a clock answers with a result code only
+    if (packet.data.u64[1] == 0)
+    {
+      setError(Packet::RESULT_ERROR_INVALID_COMMAND, "API server does not support clock synchronization.");
+      return false;
+    }
+    clock_.addSample(round_trip.request_time, packet.data.u64[0], packet.data.u64[1], round_trip.reply_time);
+  }
+  return true;
+}
+
+bool ZalphaImpl::getClockOffset(int64_t& offset, double& drift)
+{
+  if (!clock_.synchronized())
+  {
+    return false;
+  }
+  offset = (int64_t) clock_.offsetAt(ClockSync::now());
+  drift = clock_.drift() * 1e6;
+  return true;
 }
 
 bool ZalphaImpl::versionInfo(std::string& version)
@@ -96,7 +276,13 @@ bool ZalphaImpl::setAcceleration(float acceleration, float deceleration)
   Packet packet;
   packet.data.f[0] = acceleration;
   packet.data.f[1] = deceleration;
-  return executeCommand(packet, Packet::SET_ACCELERATION) && isResultOk(packet);
+  if (!executeCommand(packet, Packet::SET_ACCELERATION) || !isResultOk(packet))
+  {
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(encoder_mutex_);
+  encoder_.setLimits(acceleration, deceleration);
+  return true;
 }
 
 bool ZalphaImpl::getAcceleration(float& acceleration, float& deceleration)
@@ -108,6 +294,8 @@ bool ZalphaImpl::getAcceleration(float& acceleration, float& deceleration)
   }
   acceleration = packet.data.f[0];
   deceleration = packet.data.f[1];
+  std::lock_guard<std::mutex> lock(encoder_mutex_);
+  encoder_.setLimits(acceleration, deceleration);
   return true;
 }
 
@@ -116,7 +304,12 @@ bool ZalphaImpl::setTargetSpeed(float left_speed, float right_speed)
   Packet packet;
   packet.data.f[0] = left_speed;
   packet.data.f[1] = right_speed;
-  return executeCommand(packet, Packet::SET_TARGET_SPEED) && isResultOk(packet);
+  if (!executeCommand(packet, Packet::SET_TARGET_SPEED) || !isResultOk(packet))
+  {
+    return false;
+  }
+  setMotion(true, left_speed, right_speed);
+  return true;
 }
 
 bool ZalphaImpl::getTargetSpeed(float& left_speed, float& right_speed)
@@ -137,7 +330,12 @@ bool ZalphaImpl::moveStraight(float speed, float distance, uint8_t laser_area)
   packet.data.f[0] = speed;
   packet.data.f[1] = distance;
   packet.data.u8[8] = laser_area;
-  return executeCommand(packet, Packet::MOVE_STRAIGHT) && isResultOk(packet);
+  if (!executeCommand(packet, Packet::MOVE_STRAIGHT) || !isResultOk(packet))
+  {
+    return false;
+  }
+  setMotion(false);
+  return true;
 }
 
 bool ZalphaImpl::moveBezier(float speed, float x, float y, float cp1_x, float cp1_y, float cp2_x, float cp2_y, uint8_t laser_area)
@@ -151,7 +349,12 @@ bool ZalphaImpl::moveBezier(float speed, float x, float y, float cp1_x, float cp
   packet.data.f[5] = cp2_x;
   packet.data.f[6] = cp2_y;
   packet.data.u8[28] = laser_area;
-  return executeCommand(packet, Packet::MOVE_BEZIER) && isResultOk(packet);
+  if (!executeCommand(packet, Packet::MOVE_BEZIER) || !isResultOk(packet))
+  {
+    return false;
+  }
+  setMotion(false);
+  return true;
 }
 
 bool ZalphaImpl::rotate(float speed, float angle, uint8_t laser_area)
@@ -160,7 +363,12 @@ bool ZalphaImpl::rotate(float speed, float angle, uint8_t laser_area)
   packet.data.f[0] = speed;
   packet.data.f[1] = angle;
   packet.data.u8[8] = laser_area;
-  return executeCommand(packet, Packet::ROTATE) && isResultOk(packet);
+  if (!executeCommand(packet, Packet::ROTATE) || !isResultOk(packet))
+  {
+    return false;
+  }
+  setMotion(false);
+  return true;
 }
 
 bool ZalphaImpl::getActionStatus(uint8_t& status)
@@ -177,85 +385,216 @@ bool ZalphaImpl::getActionStatus(uint8_t& status)
 bool ZalphaImpl::pauseAction()
 {
   Packet packet;
-  return executeCommand(packet, Packet::PAUSE_ACTION) && isResultOk(packet);
+  if (!executeCommand(packet, Packet::PAUSE_ACTION) || !isResultOk(packet))
+  {
+    return false;
+  }
+  setMotion(true);
+  return true;
 }
 
 bool ZalphaImpl::resumeAction()
 {
   Packet packet;
-  return executeCommand(packet, Packet::RESUME_ACTION) && isResultOk(packet);
+  if (!executeCommand(packet, Packet::RESUME_ACTION) || !isResultOk(packet))
+  {
+    return false;
+  }
+  setMotion(false);
+  return true;
 }
 
 bool ZalphaImpl::stopAction()
 {
   Packet packet;
-  return executeCommand(packet, Packet::STOP_ACTION) && isResultOk(packet);
+  if (!executeCommand(packet, Packet::STOP_ACTION) || !isResultOk(packet))
+  {
+    return false;
+  }
+  setMotion(true);
+  return true;
 }
 
 bool ZalphaImpl::resetEncoder()
 {
   Packet packet;
-  return executeCommand(packet, Packet::RESET_ENCODER) && isResultOk(packet);
+  if (!executeCommand(packet, Packet::RESET_ENCODER) || !isResultOk(packet))
+  {
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(encoder_mutex_);
+  encoder_.resetSamples();
+  return true;
 }
 
-bool ZalphaImpl::getEncoder(double& left_distance, double& right_distance)
+bool ZalphaImpl::getEncoder(double& left_distance, double& right_distance, int64_t& timestamp)
 {
   Packet packet;
-  if (!executeCommand(packet, Packet::GET_ENCODER))
+  RoundTrip round_trip;
+  if (!executeCommand(packet, Packet::GET_ENCODER, &round_trip))
   {
     return false;
   }
   left_distance = packet.data.d[0];
   right_distance = packet.data.d[1];
+  timestamp = captureTime(packet.data.u64[Packet::TIMESTAMP_INDEX], round_trip);
+  std::lock_guard<std::mutex> lock(encoder_mutex_);
+  encoder_.addDistance(left_distance, right_distance, timestamp);
   return true;
 }
 
-bool ZalphaImpl::getRawEncoder(int64_t& left_count, int64_t& right_count)
+bool ZalphaImpl::getRawEncoder(int64_t& left_count, int64_t& right_count, int64_t& timestamp)
 {
   Packet packet;
-  if (!executeCommand(packet, Packet::GET_RAW_ENCODER))
+  RoundTrip round_trip;
+  if (!executeCommand(packet, Packet::GET_RAW_ENCODER, &round_trip))
   {
     return false;
   }
   left_count = packet.data.s64[0];
   right_count = packet.data.s64[1];
+  timestamp = captureTime(packet.data.u64[Packet::TIMESTAMP_INDEX], round_trip);
+  std::lock_guard<std::mutex> lock(encoder_mutex_);
+  encoder_.addCount(left_count, right_count, timestamp);
   return true;
 }
 
-bool ZalphaImpl::getSafetyFlag(uint16_t& safety_flag)
+bool ZalphaImpl::getEncoder(double& left_distance, double& right_distance, int64_t& timestamp, int max_age,
+                            uint8_t& source, int max_prediction)
+{
+  int64_t now = ClockSync::now();
+  {
+    std::lock_guard<std::mutex> lock(encoder_mutex_);
+    if (encoder_.recentDistance(now, max_age, left_distance, right_distance, timestamp))
+    {
+      source = Zalpha::RS_CACHED;
+      return true;
+    }
+  }
+  if (max_prediction > 0)
+  {
+    loadAccelerationLimits();
+    std::lock_guard<std::mutex> lock(encoder_mutex_);
+    if (encoder_.predictDistance(now, max_prediction, left_distance, right_distance))
+    {
+      timestamp = now;
+      source = Zalpha::RS_PREDICTED;
+      return true;
+    }
+  }
+  source = Zalpha::RS_MEASURED;
+  return getEncoder(left_distance, right_distance, timestamp);
+}
+
+bool ZalphaImpl::getRawEncoder(int64_t& left_count, int64_t& right_count, int64_t& timestamp, int max_age,
+                               uint8_t& source, int max_prediction)
+{
+  int64_t now = ClockSync::now();
+  {
+    std::lock_guard<std::mutex> lock(encoder_mutex_);
+    if (encoder_.recentCount(now, max_age, left_count, right_count, timestamp))
+    {
+      source = Zalpha::RS_CACHED;
+      return true;
+    }
+  }
+  if (max_prediction > 0)
+  {
+    loadAccelerationLimits();
+    std::lock_guard<std::mutex> lock(encoder_mutex_);
+    if (encoder_.predictCount(now, max_prediction, left_count, right_count))
+    {
+      timestamp = now;
+      source = Zalpha::RS_PREDICTED;
+      return true;
+    }
+  }
+  source = Zalpha::RS_MEASURED;
+  return getRawEncoder(left_count, right_count, timestamp);
+}
+
+bool ZalphaImpl::getSafetyFlag(uint16_t& safety_flag, int64_t& timestamp)
 {
   Packet packet;
-  if (!executeCommand(packet, Packet::GET_SAFETY_FLAG))
+  RoundTrip round_trip;
+  if (!executeCommand(packet, Packet::GET_SAFETY_FLAG, &round_trip))
   {
     return false;
   }
   safety_flag = packet.data.u16[0];
+  timestamp = captureTime(packet.data.u64[Packet::TIMESTAMP_INDEX], round_trip);
   return true;
 }
 
-bool ZalphaImpl::getEncoderAndSafetyFlag(double& left_distance, double& right_distance, uint16_t& safety_flag)
+bool ZalphaImpl::getEncoderAndSafetyFlag(double& left_distance, double& right_distance, uint16_t& safety_flag,
+                                         int64_t& timestamp)
 {
   Packet packet;
-  if (!executeCommand(packet, Packet::GET_ENCODER_AND_SAFETY_FLAG))
+  RoundTrip round_trip;
+  if (!executeCommand(packet, Packet::GET_ENCODER_AND_SAFETY_FLAG, &round_trip))
   {
     return false;
   }
   left_distance = packet.data.d[0];
   right_distance = packet.data.d[1];
   safety_flag = packet.data.u16[8];
+  timestamp = captureTime(packet.data.u64[Packet::TIMESTAMP_INDEX], round_trip);
+  std::lock_guard<std::mutex> lock(encoder_mutex_);
+  encoder_.addDistance(left_distance, right_distance, timestamp);
   return true;
 }
 
-bool ZalphaImpl::getRawEncoderAndSafetyFlag(int64_t& left_count, int64_t& right_count, uint16_t& safety_flag)
+bool ZalphaImpl::getRawEncoderAndSafetyFlag(int64_t& left_count, int64_t& right_count, uint16_t& safety_flag,
+                                            int64_t& timestamp)
 {
   Packet packet;
-  if (!executeCommand(packet, Packet::GET_RAW_ENCODER_AND_SAFETY_FLAG))
+  RoundTrip round_trip;
+  if (!executeCommand(packet, Packet::GET_RAW_ENCODER_AND_SAFETY_FLAG, &round_trip))
   {
     return false;
   }
   left_count = packet.data.s64[0];
   right_count = packet.data.s64[1];
   safety_flag = packet.data.u16[8];
+  timestamp = captureTime(packet.data.u64[Packet::TIMESTAMP_INDEX], round_trip);
+  std::lock_guard<std::mutex> lock(encoder_mutex_);
+  encoder_.addCount(left_count, right_count, timestamp);
+  return true;
+}
+
+bool ZalphaImpl::getTelemetry(int64_t& left_count, int64_t& right_count, double& left_distance, double& right_distance,
+                              uint16_t& safety_flag, int64_t& timestamp)
+{
+  TelemetrySample sample;
+  RoundTrip round_trip;
+  bool decoded = false;
+
+  // a delta against a keyframe we do not hold is answered with a keyframe on the second attempt
+  for (int attempt = 0; attempt < 2 && !decoded; attempt++)
+  {
+    Packet packet;
+    telemetry_.prepareRequest(packet);
+    if (!executeCommand(packet, Packet::GET_TELEMETRY, &round_trip))
+    {
+      return false;
+    }
+    decoded = telemetry_.decode(packet, sample);
+  }
+  if (!decoded)
+  {
+    setError(Packet::INVALID_REPLY, "Invalid reply format.");
+    return false;
+  }
+
+  left_count = sample.field[0];
+  right_count = sample.field[1];
+  left_distance = sample.field[2] * 1e-6;
+  right_distance = sample.field[3] * 1e-6;
+  safety_flag = (uint16_t) sample.field[4];
+  timestamp = captureTime(sample.field[5], round_trip);
+  std::lock_guard<std::mutex> lock(encoder_mutex_);
+  encoder_.addDistance(left_distance, right_distance, timestamp);
+  encoder_.addCount(left_count, right_count, timestamp);
   return true;
 }
 
@@ -288,14 +627,16 @@ bool ZalphaImpl::getCharging(uint8_t& charging_state)
   return true;
 }
 
-bool ZalphaImpl::getInputs(uint32_t& inputs)
+bool ZalphaImpl::getInputs(uint32_t& inputs, int64_t& timestamp)
 {
   Packet packet;
-  if (!executeCommand(packet, Packet::GET_INPUTS))
+  RoundTrip round_trip;
+  if (!executeCommand(packet, Packet::GET_INPUTS, &round_trip))
   {
     return false;
   }
   inputs = packet.data.u32[0];
+  timestamp = captureTime(packet.data.u64[Packet::TIMESTAMP_INDEX], round_trip);
   return true;
 }
 
@@ -318,83 +659,244 @@ bool ZalphaImpl::getOutputs(uint32_t& outputs)
   return true;
 }
 
-bool ZalphaImpl::executeCommand(Packet& packet, uint16_t command)
+bool ZalphaImpl::isCollapsible(uint16_t command)
+{
+  // a clock probe must make its own round trip, and a telemetry request depends on the keyframe of the decoder
+  return Packet::isIdempotent(command) && command != Packet::TIME_SYNC && command != Packet::GET_TELEMETRY;
+}
+
+bool ZalphaImpl::executeCommand(Packet& packet, uint16_t command, RoundTrip* round_trip)
 {
+  // the error of the thread belongs to its last command, a success clears it
+  thread_error = 0;
   if (!connected_)
   {
-    errnum_ = Packet::DISCONNECTED;
-    errmsg_ = "Disconnected from API server.";
+    setError(Packet::DISCONNECTED, "Disconnected from API server.");
     return false;
   }
-
-  packet.command = command;
-  if (!sendRequest(packet))
+  if (Packet::isHalt(command, packet))
   {
-    return false;
+    // counted before it is sent, so that the motions issued before it are dropped even if they are sent after it
+    packet.setHaltEpoch(halt_client_ | ++halt_count_);
+    return executePriority(packet, command);
   }
 
-  packet.command = 0;
-  if (!waitReply(packet))
+  RoundTrip local;
+  if (!round_trip) round_trip = &local;
+  if (isCollapsible(command))
   {
-    return false;
+    return executeShared(packet, command, *round_trip);
   }
-  if (packet.command != command)
+  int64_t deadline = 0;
+  if (Packet::isMotion(command, packet))
   {
-    errnum_ = Packet::INVALID_REPLY;
-    errmsg_ = "Invalid reply format.";
-    return false;
+    packet.setHaltEpoch(halt_client_ | halt_count_);
+    if (motion_lifetime_ >= 0)
+    {
+      deadline = ClockSync::now() + (int64_t) motion_lifetime_ * 1000;
+    }
   }
-  return true;
+  return executeOrdinary(packet, command, *round_trip, deadline);
 }
 
-bool ZalphaImpl::sendRequest(const Packet& packet)
+bool ZalphaImpl::executeShared(Packet& packet, uint16_t command, RoundTrip& round_trip)
 {
-  zmq::message_t request(sizeof(Packet));
-  const char* src = (const char*) &packet;
-  std::copy(src, src + sizeof(Packet), (char*) request.data());
+  std::unique_lock<std::mutex> lock(flight_mutex_);
+  if (read_max_age_ < 0)
+  {
+    lock.unlock();
+    return executeOrdinary(packet, command, round_trip);
+  }
 
-  try
+  // join the identical read in flight, or reuse one whose request was sent within the freshness window
+  int64_t now = ClockSync::now();
+  std::shared_ptr<Flight> flight;
+  for (std::list<std::shared_ptr<Flight> >::iterator it = flights_.begin(); it != flights_.end(); )
   {
-    if (!socket_.send(request))
+    if ((*it)->done && now - (*it)->round_trip.request_time > read_max_age_)
+    {
+      std::list<std::shared_ptr<Flight> >::iterator next = it;
+      ++next;
+      spare_flights_.splice(spare_flights_.end(), flights_, it);
+      it = next;
+      continue;
+    }
+    if (!flight && (*it)->request.command == command &&
+        std::memcmp((*it)->request.data.u8, packet.data.u8, Packet::MAX_PAYLOAD) == 0)
     {
-      throw zmq::error_t();
+      flight = *it;
     }
+    ++it;
   }
-  catch (const zmq::error_t& ex)
+
+  if (flight)
   {
-    errnum_ = ex.num();
-    errmsg_ = ex.what();
-    return false;
+    if (flight->done)
+    {
+      reused_reads_++;
+    }
+    else
+    {
+      shared_reads_++;
+      while (!flight->done)
+      {
+        flight_done_.wait(lock);
+      }
+    }
+    // a failed read is not kept, so its waiters return the error set by the thread that sent it
+    packet = flight->reply;
+    round_trip = flight->round_trip;
+    if (!flight->success)
+    {
+      thread_error = flight->error;
+    }
+    return flight->success;
   }
-  return true;
+
+  // a spare flight is only reused once the threads that joined it have let go of it
+  if (!spare_flights_.empty() && spare_flights_.front().use_count() == 1)
+  {
+    flights_.splice(flights_.end(), spare_flights_, spare_flights_.begin());
+  }
+  else
+  {
+    flights_.push_back(std::make_shared<Flight>());
+  }
+  flight = flights_.back();
+  flight->request = packet;
+  flight->request.command = command;
+  flight->done = false;
+  lock.unlock();
+
+  bool success = executeOrdinary(packet, command, round_trip);
+
+  lock.lock();
+  flight->reply = packet;
+  flight->round_trip = round_trip;
+  flight->success = success;
+  flight->error = success ? 0 : thread_error;
+  flight->done = true;
+  if (!success || read_max_age_ <= 0)
+  {
+    // a reconnect may have dropped the flight already
+    std::list<std::shared_ptr<Flight> >::iterator it = std::find(flights_.begin(), flights_.end(), flight);
+    if (it != flights_.end())
+    {
+      spare_flights_.splice(spare_flights_.end(), flights_, it);
+    }
+  }
+  flight_done_.notify_all();
+  return success;
 }
 
-bool ZalphaImpl::waitReply(Packet& packet)
+bool ZalphaImpl::executeOrdinary(Packet& packet, uint16_t command, RoundTrip& round_trip, int64_t deadline)
 {
-  zmq::message_t reply;
-  try
+  // only the read commands are retried, a repeated write may act on a newer state
+  int attempts = Packet::isIdempotent(command) ? retries_ + 1 : 1;
+  std::lock_guard<std::mutex> lock(lane_mutex_);
+  // a halt issued while the motion waited for the lane went ahead of it through the priority lane
+  if (packet.haltEpoch() != 0 && (uint16_t) packet.haltEpoch() != halt_count_)
+  {
+    setError(Packet::RESULT_ERROR_EXPIRED, "Command superseded by a halt command.");
+    return false;
+  }
+  if (deadline != 0)
   {
-    if (!socket_.recv(&reply))
+    // the command may have waited for the round trips of other threads
+    int64_t now = ClockSync::now();
+    if (now >= deadline)
+    {
+      setError(Packet::RESULT_ERROR_EXPIRED, "Command expired before it was executed.");
+      return false;
+    }
+    // the robot clock is only known once synchronized, otherwise only the client drops the command
+    if (clock_.synchronized())
     {
-      throw zmq::error_t();
+      uint32_t robot_deadline = (uint32_t) (deadline + (int64_t) clock_.offsetAt(now));
+      packet.setDeadline(robot_deadline ? robot_deadline : 1);
     }
   }
-  catch (const zmq::error_t& ex)
+  return exchange(*transport_, packet, command, attempts, &round_trip);
+}
+
+bool ZalphaImpl::executePriority(Packet& packet, uint16_t command)
+{
+  // the halt commands are serialized among themselves only, and may be repeated safely
+  std::lock_guard<std::mutex> lock(priority_mutex_);
+  if (!priority_transport_.get())
   {
-    errnum_ = ex.num();
-    errmsg_ = ex.what();
+    setError(Packet::DISCONNECTED, "Disconnected from API server.");
     return false;
   }
+  return exchange(*priority_transport_, packet, command, priority_attempts_, NULL);
+}
 
-  if (reply.size() != sizeof(Packet))
+void ZalphaImpl::updatePriorityTimeout()
+{
+  // a halt command does not block its caller longer than an ordinary command, for eg: in a control loop
+  int timeout = priority_timeout_;
+  priority_attempts_ = priority_retries_ + 1;
+  if (timeout_ > 0)
   {
-    errnum_ = Packet::INVALID_REPLY;
-    errmsg_ = "Invalid reply format.";
-    return false;
+    if (timeout < 0 || timeout > timeout_)
+    {
+      timeout = timeout_;
+    }
+    if (timeout > 0)
+    {
+      priority_attempts_ = std::max(1, std::min(priority_attempts_, timeout_ / timeout));
+    }
+  }
+  if (priority_transport_.get())
+  {
+    priority_transport_->setTimeout(timeout);
   }
+}
+
+bool ZalphaImpl::exchange(Transport& transport, Packet& packet, uint16_t command, int attempts, RoundTrip* round_trip)
+{
+  for (int attempt = 1; ; attempt++)
+  {
+    packet.command = command;
+    int64_t request_time = ClockSync::now();
+    if (!transport.sendRequest(packet))
+    {
+      setError(transport);
+      return false;
+    }
 
-  char* src = (char*) reply.data();
-  std::copy(src, src + sizeof(Packet), (char*) &packet);
+    packet.command = 0;
+    if (transport.waitReply(packet))
+    {
+      int64_t reply_time = ClockSync::now();
+      {
+        std::lock_guard<std::mutex> lock(link_mutex_);
+        link_.addRoundTrip(reply_time - request_time);
+      }
+      // the capture time estimates only use the round trips of the ordinary lane
+      if (round_trip)
+      {
+        round_trip->request_time = request_time;
+        round_trip->reply_time = reply_time;
+      }
+      break;
+    }
+    setError(transport);
+    if (transport.getError() == Packet::TIMEOUT)
+    {
+      std::lock_guard<std::mutex> lock(link_mutex_);
+      link_.addLoss();
+    }
+    if (transport.getError() != Packet::TIMEOUT || attempt >= attempts)
+    {
+      return false;
+    }
+  }
+  if (packet.command != command)
+  {
+    setError(Packet::INVALID_REPLY, "Invalid reply format.");
+    return false;
+  }
   return true;
 }
 
@@ -406,20 +908,94 @@ bool ZalphaImpl::isResultOk(const Packet& packet)
   }
   else if (packet.data.u16[0] == Packet::RESULT_ERROR_INVALID_COMMAND)
   {
-    errnum_ = Packet::RESULT_ERROR_INVALID_COMMAND;
-    errmsg_ = "Invalid parameters in API call.";
+    setError(Packet::RESULT_ERROR_INVALID_COMMAND, "Invalid parameters in API call.");
   }
   else if (packet.data.u16[0] == Packet::RESULT_ERROR_BUSY)
   {
-    errnum_ = Packet::RESULT_ERROR_BUSY;
-    errmsg_ = "Target is busy.";
+    setError(Packet::RESULT_ERROR_BUSY, "Target is busy.");
+  }
+  else if (packet.data.u16[0] == Packet::RESULT_ERROR_EXPIRED)
+  {
+    setError(Packet::RESULT_ERROR_EXPIRED, "Command expired before it was executed.");
   }
   else
   {
-    errnum_ = Packet::UNKNOWN_ERROR;
-    errmsg_ = "Unknown error.";
+    setError(Packet::UNKNOWN_ERROR, "Unknown error.");
   }
   return false;
 }
 
+void ZalphaImpl::setMotion(bool known, float left_speed, float right_speed)
+{
+  std::lock_guard<std::mutex> lock(encoder_mutex_);
+  if (known)
+  {
+    encoder_.setTarget(left_speed, right_speed, ClockSync::now());
+  }
+  else
+  {
+    encoder_.clearTarget();
+  }
+}
+
+void ZalphaImpl::loadAccelerationLimits()
+{
+  {
+    std::lock_guard<std::mutex> lock(encoder_mutex_);
+    if (limits_requested_ || encoder_.hasLimits()) return;
+    limits_requested_ = true;
+  }
+  // getAcceleration() hands them to the predictor, which ramps instantly without them
+  float acceleration, deceleration;
+  getAcceleration(acceleration, deceleration);
+}
+
+void ZalphaImpl::setError(int errnum, const std::string& errmsg)
+{
+  thread_error = errnum;
+  std::lock_guard<std::mutex> lock(error_mutex_);
+  errnum_ = errnum;
+  errmsg_ = errmsg;
+  errtext_ = errmsg_.c_str();
+}
+
+void ZalphaImpl::setError(int errnum, const char* errmsg)
+{
+  // a fixed message, a string literal, is kept without a copy
+  thread_error = errnum;
+  std::lock_guard<std::mutex> lock(error_mutex_);
+  errnum_ = errnum;
+  errtext_ = errmsg;
+}
+
+void ZalphaImpl::setError(Transport& transport)
+{
+  if (transport.hasFixedErrorText())
+  {
+    setError(transport.getError(), transport.getErrorText());
+    return;
+  }
+  // the other messages are only valid until the next error of the transport
+  thread_error = transport.getError();
+  std::lock_guard<std::mutex> lock(error_mutex_);
+  errnum_ = transport.getError();
+  errmsg_.assign(transport.getErrorText());
+  errtext_ = errmsg_.c_str();
+}
+
+int ZalphaImpl::threadError()
+{
+  return thread_error;
+}
+
+int64_t ZalphaImpl::captureTime(uint64_t robot_time, const RoundTrip& round_trip)
+{
+  if (robot_time == 0 || !clock_.synchronized())
+  {
+    // without a usable robot time, the midpoint of the round trip is the best estimate
+    return round_trip.request_time + (round_trip.reply_time - round_trip.request_time) / 2;
+  }
+  return clock_.toHost(robot_time);
+}
+
 }  // namespace zalpha_api
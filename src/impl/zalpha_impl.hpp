@@ -17,27 +17,59 @@
 #ifndef ZALPHA_API_IMPL_ZALPHA_IMPL_HPP
 #define ZALPHA_API_IMPL_ZALPHA_IMPL_HPP
 
-#include <zmq.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
 
 #include <zalpha_api/zalpha_api_export.h>
+#include "clock_sync.hpp"
+#include "encoder_predictor.hpp"
+#include "link_estimator.hpp"
+#include "packet.hpp"
+#include "telemetry.hpp"
 
 
 namespace zalpha_api
 {
 
-class ZALPHA_API_NO_EXPORT Packet;
+class ZALPHA_API_NO_EXPORT Transport;
 
 /**
  * \brief ZalphaImpl is an internal implementation class that provides access to %Zalpha API.
  */
 class ZALPHA_API_NO_EXPORT ZalphaImpl
 {
+public:
+  enum
+  {
+    DEFAULT_PRIORITY_TIMEOUT = 100,  ///< Timeout of the halt commands, in ms
+    DEFAULT_PRIORITY_RETRIES = 2,    ///< Number of retries of the halt commands
+  };
+
 public:
   ZalphaImpl();
   virtual ~ZalphaImpl();
 
-  bool connect(const std::string& server_ip);
+  bool connect(const std::string& server_address);
   void disconnect();
+  void setTimeout(int timeout, int retries);
+  void getTimeout(int& timeout, int& retries);
+  void setPriorityTimeout(int timeout, int retries);
+  void setReadCollapsing(int max_age);
+  void setMotionLifetime(int lifetime);
+  void getCollapsedReads(uint64_t& shared, uint64_t& reused);
+  bool setWireEncoding(uint8_t encoding);
+  void getTrafficCounters(uint64_t& bytes_sent, uint64_t& bytes_received);
+  void getLinkQuality(LinkQuality& quality);
+  void resetLinkQuality();
+  void getConnectionStatus(ConnectionStatus& status);
+  void setMonitored(bool enable);
+  void setFailFast(bool enable);
+  bool syncClock(int probes);
+  bool getClockOffset(int64_t& offset, double& drift);
 
   bool versionInfo(std::string& version);
   bool setAcceleration(float acceleration, float deceleration);
@@ -52,42 +84,121 @@ public:
   bool resumeAction();
   bool stopAction();
   bool resetEncoder();
-  bool getEncoder(double& left_distance, double& right_distance);
-  bool getRawEncoder(int64_t& left_count, int64_t& right_count);
-  bool getSafetyFlag(uint16_t& safety_flag);
-  bool getEncoderAndSafetyFlag(double& left_distance, double& right_distance, uint16_t& safety_flag);
-  bool getRawEncoderAndSafetyFlag(int64_t& left_count, int64_t& right_count, uint16_t& safety_flag);
+  bool getEncoder(double& left_distance, double& right_distance, int64_t& timestamp);
+  bool getRawEncoder(int64_t& left_count, int64_t& right_count, int64_t& timestamp);
+  bool getEncoder(double& left_distance, double& right_distance, int64_t& timestamp, int max_age, uint8_t& source,
+                  int max_prediction);
+  bool getRawEncoder(int64_t& left_count, int64_t& right_count, int64_t& timestamp, int max_age, uint8_t& source,
+                     int max_prediction);
+  bool getSafetyFlag(uint16_t& safety_flag, int64_t& timestamp);
+  bool getEncoderAndSafetyFlag(double& left_distance, double& right_distance, uint16_t& safety_flag,
+                               int64_t& timestamp);
+  bool getRawEncoderAndSafetyFlag(int64_t& left_count, int64_t& right_count, uint16_t& safety_flag,
+                                  int64_t& timestamp);
+  bool getTelemetry(int64_t& left_count, int64_t& right_count, double& left_distance, double& right_distance,
+                    uint16_t& safety_flag, int64_t& timestamp);
   bool getBattery(float& battery_percentage);
   bool setCharging(bool enable = true);
   bool getCharging(uint8_t& charging_state);
-  bool getInputs(uint32_t& inputs);
+  bool getInputs(uint32_t& inputs, int64_t& timestamp);
   bool setOutputs(uint32_t outputs, uint32_t mask);
   bool getOutputs(uint32_t& outputs);
 
   int getError()
   {
+    std::lock_guard<std::mutex> lock(error_mutex_);
     return errnum_;
   }
   std::string getErrorMessage()
   {
-    return errmsg_;
+    std::lock_guard<std::mutex> lock(error_mutex_);
+    return errtext_;
   }
+  /**
+   * \brief The error code of the last command that failed on the calling thread.
+   */
+  static int threadError();
 
 private:
-  bool executeCommand(Packet& packet, uint16_t command);
-  bool sendRequest(const Packet& packet);
-  bool waitReply(Packet& packet);
+  /**
+   * \brief The host times of a round trip of the ordinary lane, which date the readings.
+   */
+  struct RoundTrip
+  {
+    int64_t request_time;
+    int64_t reply_time;
+  };
+  /**
+   * \brief A read command in flight, or completed within the freshness window, shared by the identical reads.
+   */
+  struct Flight
+  {
+    Packet request;
+    Packet reply;
+    RoundTrip round_trip;
+    bool done;
+    bool success;
+    int error;  ///< the error of a failed read, for the threads that joined it
+  };
+
+  static bool isCollapsible(uint16_t command);
+
+  bool executeCommand(Packet& packet, uint16_t command, RoundTrip* round_trip = NULL);
+  bool executeShared(Packet& packet, uint16_t command, RoundTrip& round_trip);
+  bool executeOrdinary(Packet& packet, uint16_t command, RoundTrip& round_trip, int64_t deadline = 0);
+  bool executePriority(Packet& packet, uint16_t command);
+  void updatePriorityTimeout();
+  bool exchange(Transport& transport, Packet& packet, uint16_t command, int attempts, RoundTrip* round_trip);
   bool isResultOk(const Packet& packet);
+  void setError(int errnum, const std::string& errmsg);
+  void setError(int errnum, const char* errmsg);
+  void setError(Transport& transport);
+  int64_t captureTime(uint64_t robot_time, const RoundTrip& round_trip);
+  void setMotion(bool known, float left_speed = 0.0f, float right_speed = 0.0f);
+  void loadAccelerationLimits();
 
 private:
-  zmq::context_t context_;
-  zmq::socket_t socket_;
+  std::auto_ptr<Transport> transport_;
 
   bool connected_;
   std::string server_url_;
-
+  int timeout_;
+  int retries_;
+  int motion_lifetime_;  ///< in ms, after which a motion command is dropped, or negative
+  bool monitored_;
+  bool fail_fast_;
+  std::mutex lane_mutex_;  ///< serializes the round trips of the ordinary lane
+
+  std::mutex flight_mutex_;  ///< guards the flights and their counters
+  std::condition_variable flight_done_;
+  std::list<std::shared_ptr<Flight> > flights_;
+  std::list<std::shared_ptr<Flight> > spare_flights_;  ///< the completed flights, recycled without an allocation
+  int read_max_age_;
+  uint64_t shared_reads_;
+  uint64_t reused_reads_;
+
+  std::auto_ptr<Transport> priority_transport_;  ///< the lane of the halt commands, see Packet::isHalt()
+  std::mutex priority_mutex_;
+  int priority_timeout_;
+  int priority_retries_;
+  int priority_attempts_;  ///< the attempts of a halt command that fit in the timeout of the ordinary lane
+  uint32_t halt_client_;  ///< the client of the halt epochs, in their high 16 bits, see Packet::haltEpoch()
+  std::atomic<uint16_t> halt_count_;  ///< the number of halt commands issued, which orders them with the motions
+
+  TelemetryDecoder telemetry_;
+  ClockSync clock_;
+
+  std::mutex link_mutex_;  ///< both lanes measure the link
+  LinkEstimator link_;
+
+  std::mutex encoder_mutex_;  ///< guards the last encoder readings and the motion commanded
+  EncoderPredictor encoder_;
+  bool limits_requested_;    ///< whether the acceleration limits were read for the prediction
+
+  std::mutex error_mutex_;  ///< the commands may fail on several threads
   int errnum_;
   std::string errmsg_;
+  const char* errtext_;  ///< the fixed message, or errmsg_
 };
 
 }  // namespace zalpha_api
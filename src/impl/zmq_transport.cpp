@@ -0,0 +1,277 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cerrno>
+
+#include "zmq_transport.hpp"
+#include "clock_sync.hpp"
+#include "codec.hpp"
+#include "packet.hpp"
+
+
+namespace zalpha_api
+{
+
+ZmqTransport::ZmqTransport() :
+  monitored_(false), fail_fast_(false), watching_(false)
+{
+}
+
+ZmqTransport::~ZmqTransport()
+{
+  disconnect();
+}
+
+zmq::context_t& ZmqTransport::inprocContext()
+{
+  // never destroyed, so that sockets still open at exit do not block the context termination
+  static zmq::context_t* context = new zmq::context_t(1);
+  return *context;
+}
+
+bool ZmqTransport::connect(const std::string& url)
+{
+  url_ = url;
+  monitor_.reset();
+  return openSocket();
+}
+
+void ZmqTransport::disconnect()
+{
+  if (!socket_.get()) return;
+
+  try
+  {
+    socket_->disconnect(url_.c_str());
+  }
+  catch (const zmq::error_t& ex)
+  {
+    setError(ex.num(), std::string(ex.what()));
+  }
+  closeSocket();
+  monitor_.stop();
+}
+
+void ZmqTransport::setTimeout(int timeout)
+{
+  Transport::setTimeout(timeout);
+  if (!socket_.get()) return;
+
+  try
+  {
+    socket_->setsockopt(ZMQ_RCVTIMEO, &timeout_, sizeof(timeout_));
+    socket_->setsockopt(ZMQ_SNDTIMEO, &timeout_, sizeof(timeout_));
+  }
+  catch (const zmq::error_t& ex)
+  {
+    setError(ex.num(), std::string(ex.what()));
+  }
+}
+
+void ZmqTransport::setMonitored(bool monitored)
+{
+  monitored_ = monitored;
+}
+
+void ZmqTransport::setFailFast(bool fail_fast)
+{
+  fail_fast_ = fail_fast;
+}
+
+void ZmqTransport::getConnectionStatus(ConnectionStatus& status)
+{
+  if (!watching_)
+  {
+    Transport::getConnectionStatus(status);
+    return;
+  }
+  monitor_.getStatus(status);
+}
+
+bool ZmqTransport::openSocket()
+{
+  try
+  {
+    zmq::context_t* context;
+    if (url_.compare(0, 9, "inproc://") == 0)
+    {
+      context = &inprocContext();
+    }
+    else
+    {
+      if (!own_context_.get())
+      {
+        own_context_.reset(new zmq::context_t(1));
+      }
+      context = own_context_.get();
+    }
+
+    socket_.reset(new zmq::socket_t(*context, ZMQ_REQ));
+
+    int linger = 0;
+    socket_->setsockopt(ZMQ_LINGER, &linger, sizeof(linger));
+    socket_->setsockopt(ZMQ_RCVTIMEO, &timeout_, sizeof(timeout_));
+    socket_->setsockopt(ZMQ_SNDTIMEO, &timeout_, sizeof(timeout_));
+
+    // the inproc:// connections have no session to follow
+    watching_ = false;
+    if (monitored_ && (url_.compare(0, 6, "tcp://") == 0 || url_.compare(0, 6, "ipc://") == 0))
+    {
+      watching_ = monitor_.start(*context, *socket_);
+    }
+    if (watching_ && fail_fast_)
+    {
+      // queue the requests only on established sessions, a request sent while the link is down is never delivered
+      int immediate = 1;
+      socket_->setsockopt(ZMQ_IMMEDIATE, &immediate, sizeof(immediate));
+    }
+    socket_->connect(url_.c_str());
+  }
+  catch (const zmq::error_t& ex)
+  {
+    closeSocket();
+    setError(ex.num(), std::string(ex.what()));
+    return false;
+  }
+  return true;
+}
+
+void ZmqTransport::closeSocket()
+{
+  // the monitor lets go of the socket once it is closed, and waits for the next one
+  socket_.reset();
+}
+
+bool ZmqTransport::sendRequest(const Packet& packet)
+{
+  // the socket is closed when a previous reply timed out and it could not be reopened
+  if (!socket_.get() && !openSocket())
+  {
+    return false;
+  }
+  if (watching_ && fail_fast_ && monitor_.isDown())
+  {
+    setError(Packet::DISCONNECTED, "Disconnected from API server.");
+    return false;
+  }
+
+  uint8_t buffer[Codec::MAX_SIZE];
+  size_t size = Codec::encode(packet, encoding_, buffer);
+  zmq::message_t request(size);
+  std::copy(buffer, buffer + size, (uint8_t*) request.data());
+
+  try
+  {
+    if (!socket_->send(request))
+    {
+      setError(Packet::TIMEOUT, "Timed out sending request.");
+      return false;
+    }
+  }
+  catch (const zmq::error_t& ex)
+  {
+    setError(ex.num(), std::string(ex.what()));
+    return false;
+  }
+  bytes_sent_ += size;
+  return true;
+}
+
+bool ZmqTransport::waitReply(Packet& packet)
+{
+  if (watching_ && fail_fast_)
+  {
+    int ready = pollReply();
+    if (ready <= 0)
+    {
+      closeSocket();
+      openSocket();
+      if (ready < 0)
+      {
+        setError(Packet::DISCONNECTED, "Disconnected from API server.");
+      }
+      else
+      {
+        setError(Packet::TIMEOUT, "Timed out waiting for reply.");
+      }
+      return false;
+    }
+  }
+
+  zmq::message_t reply;
+  try
+  {
+    if (!socket_->recv(&reply))
+    {
+      // a ZMQ_REQ socket cannot send again until it receives the reply, so start over with a new one
+      closeSocket();
+      openSocket();
+      setError(Packet::TIMEOUT, "Timed out waiting for reply.");
+      return false;
+    }
+  }
+  catch (const zmq::error_t& ex)
+  {
+    setError(ex.num(), std::string(ex.what()));
+    return false;
+  }
+
+  bytes_received_ += reply.size();
+  if (!Codec::decode((const uint8_t*) reply.data(), reply.size(), packet))
+  {
+    setError(Packet::INVALID_REPLY, "Invalid reply format.");
+    return false;
+  }
+  return true;
+}
+
+int ZmqTransport::pollReply()
+{
+  zmq_pollitem_t item = { (void*) *socket_, 0, ZMQ_POLLIN, 0 };
+  int64_t deadline = (timeout_ >= 0) ? ClockSync::now() + (int64_t) timeout_ * 1000 : -1;
+  for (;;)
+  {
+    long wait = SESSION_CHECK_INTERVAL;
+    if (deadline >= 0)
+    {
+      wait = (long) std::min((int64_t) wait, std::max(deadline - ClockSync::now(), (int64_t) 0) / 1000);
+    }
+    try
+    {
+      if (zmq::poll(&item, 1, wait) > 0) return 1;
+    }
+    catch (const zmq::error_t& ex)
+    {
+      if (ex.num() != EINTR) return 0;
+    }
+    if (monitor_.isDown()) return -1;
+    if (deadline >= 0 && ClockSync::now() >= deadline) return 0;
+  }
+}
+
+bool ZmqTransport::getPollItem(zmq_pollitem_t& item)
+{
+  if (!socket_.get()) return false;
+
+  item.socket = (void*) *socket_;
+  item.fd = 0;
+  item.events = ZMQ_POLLIN;
+  item.revents = 0;
+  return true;
+}
+
+}  // namespace zalpha_api
@@ -0,0 +1,88 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ZALPHA_API_IMPL_ZMQ_TRANSPORT_HPP
+#define ZALPHA_API_IMPL_ZMQ_TRANSPORT_HPP
+
+#include <memory>
+#include <zmq.hpp>
+
+#include <zalpha_api/zalpha_api_export.h>
+#include "connection_monitor.hpp"
+#include "transport.hpp"
+
+
+namespace zalpha_api
+{
+
+/**
+ * \brief ZmqTransport talks to the API server through a ZMQ_REQ socket.
+ *
+ * It serves the tcp://, ipc:// and inproc:// endpoints. The inproc:// endpoints are only reachable
+ * through the process-wide context returned by inprocContext(), which the in-process server must share.
+ *
+ * When monitored, the sessions of the tcp:// and ipc:// endpoints are followed by a ConnectionMonitor.
+ */
+class ZALPHA_API_NO_EXPORT ZmqTransport : public Transport
+{
+public:
+  enum
+  {
+    SESSION_CHECK_INTERVAL = 20,  ///< Time between the checks of the session while waiting for a reply, in ms
+  };
+
+public:
+  ZmqTransport();
+  virtual ~ZmqTransport();
+
+  static zmq::context_t& inprocContext();
+
+  virtual bool connect(const std::string& url);
+  virtual void disconnect();
+
+  virtual void setTimeout(int timeout);
+  virtual void setMonitored(bool monitored);
+  virtual void setFailFast(bool fail_fast);
+  virtual void getConnectionStatus(ConnectionStatus& status);
+
+  virtual bool sendRequest(const Packet& packet);
+  virtual bool waitReply(Packet& packet);
+  virtual bool getPollItem(zmq_pollitem_t& item);
+
+private:
+  bool openSocket();
+  void closeSocket();
+  /**
+   * \brief Wait for the reply while checking the session.
+   * @return                 1 when the reply is ready, 0 on timeout, and -1 when the session was lost
+   */
+  int pollReply();
+
+private:
+  std::auto_ptr<zmq::context_t> own_context_;
+  std::auto_ptr<zmq::socket_t> socket_;
+
+  std::string url_;
+
+  bool monitored_;
+  bool fail_fast_;
+  bool watching_;  ///< whether the monitor follows the socket
+  ConnectionMonitor monitor_;
+};
+
+}  // namespace zalpha_api
+
+#endif  // ZALPHA_API_IMPL_ZMQ_TRANSPORT_HPP
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <zalpha_api/io_manager.hpp>
+#include "impl/io_manager_impl.hpp"
+
+
+namespace zalpha_api
+{
+
+IoManager::IoManager() :
+  pimpl_(new IoManagerImpl())
+{
+}
+
+IoManager::~IoManager()
+{
+}
+
+bool IoManager::connect(const std::string& server_address)
+{
+  return pimpl_->connect(server_address);
+}
+
+void IoManager::disconnect()
+{
+  pimpl_->disconnect();
+}
+
+void IoManager::setTimeout(int timeout)
+{
+  pimpl_->setTimeout(timeout);
+}
+
+void IoManager::setFlushWindow(int window)
+{
+  pimpl_->setFlushWindow(window);
+}
+
+void IoManager::setPollInterval(int interval)
+{
+  pimpl_->setPollInterval(interval);
+}
+
+void IoManager::writeOutputs(uint32_t outputs, uint32_t mask)
+{
+  pimpl_->writeOutputs(outputs, mask);
+}
+
+bool IoManager::flush(int timeout)
+{
+  return pimpl_->flush(timeout);
+}
+
+bool IoManager::getInputs(uint32_t& inputs, int64_t& timestamp)
+{
+  return pimpl_->getInputs(inputs, timestamp);
+}
+
+bool IoManager::waitInputEvent(uint32_t rising_mask, uint32_t falling_mask, InputEvent& event, int timeout)
+{
+  return pimpl_->waitInputEvent(rising_mask, falling_mask, event, timeout);
+}
+
+void IoManager::getStatistics(IoStatistics& statistics)
+{
+  pimpl_->getStatistics(statistics);
+}
+
+void IoManager::resetStatistics()
+{
+  pimpl_->resetStatistics();
+}
+
+int IoManager::getError()
+{
+  return pimpl_->getError();
+}
+
+std::string IoManager::getErrorMessage()
+{
+  return pimpl_->getErrorMessage();
+}
+
+}  // namespace zalpha_api
@@ -0,0 +1,108 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <zalpha_api/path_follower.hpp>
+#include "impl/path_follower_impl.hpp"
+
+
+namespace zalpha_api
+{
+
+PathFollower::PathFollower() :
+  pimpl_(new PathFollowerImpl())
+{
+}
+
+PathFollower::~PathFollower()
+{
+}
+
+bool PathFollower::connect(const std::string& server_address)
+{
+  return pimpl_->connect(server_address);
+}
+
+void PathFollower::disconnect()
+{
+  pimpl_->disconnect();
+}
+
+bool PathFollower::setPath(const std::vector<PathPoint>& points, bool spline)
+{
+  return pimpl_->setPath(points, spline);
+}
+
+void PathFollower::setAlgorithm(Algorithm algorithm)
+{
+  pimpl_->setAlgorithm(algorithm);
+}
+
+void PathFollower::setSpeed(float speed)
+{
+  pimpl_->setSpeed(speed);
+}
+
+void PathFollower::setLookahead(double distance)
+{
+  pimpl_->setLookahead(distance);
+}
+
+void PathFollower::setStanleyGain(double gain)
+{
+  pimpl_->setStanleyGain(gain);
+}
+
+void PathFollower::setWheelBase(double wheel_base)
+{
+  pimpl_->setWheelBase(wheel_base);
+}
+
+void PathFollower::setGoalTolerance(double tolerance)
+{
+  pimpl_->setGoalTolerance(tolerance);
+}
+
+bool PathFollower::start(int period)
+{
+  return pimpl_->start(period);
+}
+
+void PathFollower::stop()
+{
+  pimpl_->stop();
+}
+
+bool PathFollower::wait(int timeout)
+{
+  return pimpl_->wait(timeout);
+}
+
+void PathFollower::getStatus(FollowerStatus& status)
+{
+  pimpl_->getStatus(status);
+}
+
+int PathFollower::getError()
+{
+  return pimpl_->getError();
+}
+
+std::string PathFollower::getErrorMessage()
+{
+  return pimpl_->getErrorMessage();
+}
+
+}  // namespace zalpha_api
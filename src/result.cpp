@@ -0,0 +1,55 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <zalpha_api/result.hpp>
+
+
+namespace zalpha_api
+{
+
+const char* errorString(int error)
+{
+  switch (error)
+  {
+  case EC_OK:
+    return "Success.";
+  case EC_INVALID_COMMAND:
+    return "Invalid parameters in API call.";
+  case EC_BUSY:
+    return "Target is busy.";
+  case EC_EXPIRED:
+    return "Command expired before it was executed.";
+  case EC_INVALID_REPLY:
+    return "Invalid reply format.";
+  case EC_UNKNOWN_ERROR:
+    return "Unknown error.";
+  case EC_INVALID_ENDPOINT:
+    return "Unsupported endpoint.";
+  case EC_TIMEOUT:
+    return "Timed out waiting for reply.";
+  case EC_SYSTEM_ERROR:
+    return "System error.";
+  case EC_CONNECTED:
+    return "Already connected to API server.";
+  case EC_DISCONNECTED:
+    return "Disconnected from API server.";
+  default:
+    // the error numbers of the operating system and of ZeroMQ
+    return "System error.";
+  }
+}
+
+}  // namespace zalpha_api
@@ -0,0 +1,88 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <zalpha_api/setpoint_mailbox.hpp>
+#include "impl/setpoint_mailbox_impl.hpp"
+
+
+namespace zalpha_api
+{
+
+SetpointMailbox::SetpointMailbox() :
+  pimpl_(new SetpointMailboxImpl())
+{
+}
+
+SetpointMailbox::~SetpointMailbox()
+{
+}
+
+bool SetpointMailbox::connect(const std::string& server_address)
+{
+  return pimpl_->connect(server_address);
+}
+
+void SetpointMailbox::disconnect()
+{
+  pimpl_->disconnect();
+}
+
+void SetpointMailbox::setTimeout(int timeout)
+{
+  pimpl_->setTimeout(timeout);
+}
+
+void SetpointMailbox::setKeepAlive(int interval)
+{
+  pimpl_->setKeepAlive(interval);
+}
+
+void SetpointMailbox::postTargetSpeed(float left_speed, float right_speed)
+{
+  pimpl_->postTargetSpeed(left_speed, right_speed);
+}
+
+void SetpointMailbox::postOutputs(uint32_t outputs, uint32_t mask)
+{
+  pimpl_->postOutputs(outputs, mask);
+}
+
+bool SetpointMailbox::flush(int timeout)
+{
+  return pimpl_->flush(timeout);
+}
+
+void SetpointMailbox::getStatistics(MailboxStatistics& statistics)
+{
+  pimpl_->getStatistics(statistics);
+}
+
+void SetpointMailbox::resetStatistics()
+{
+  pimpl_->resetStatistics();
+}
+
+int SetpointMailbox::getError()
+{
+  return pimpl_->getError();
+}
+
+std::string SetpointMailbox::getErrorMessage()
+{
+  return pimpl_->getErrorMessage();
+}
+
+}  // namespace zalpha_api
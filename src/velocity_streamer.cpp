@@ -0,0 +1,88 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <zalpha_api/velocity_streamer.hpp>
+#include "impl/velocity_streamer_impl.hpp"
+
+
+namespace zalpha_api
+{
+
+VelocityStreamer::VelocityStreamer() :
+  pimpl_(new VelocityStreamerImpl())
+{
+}
+
+VelocityStreamer::~VelocityStreamer()
+{
+}
+
+bool VelocityStreamer::connect(const std::string& server_address)
+{
+  return pimpl_->connect(server_address);
+}
+
+void VelocityStreamer::disconnect()
+{
+  pimpl_->disconnect();
+}
+
+void VelocityStreamer::setRealtime(int priority, int cpu, bool lock_memory)
+{
+  pimpl_->setRealtime(priority, cpu, lock_memory);
+}
+
+void VelocityStreamer::setAdaptiveRate(int delay_target, int max_period)
+{
+  pimpl_->setAdaptiveRate(delay_target, max_period);
+}
+
+bool VelocityStreamer::start(int period)
+{
+  return pimpl_->start(period);
+}
+
+void VelocityStreamer::stop()
+{
+  pimpl_->stop();
+}
+
+void VelocityStreamer::setTarget(float left_speed, float right_speed)
+{
+  pimpl_->setTarget(left_speed, right_speed);
+}
+
+void VelocityStreamer::getStatistics(StreamerStatistics& statistics)
+{
+  pimpl_->getStatistics(statistics);
+}
+
+void VelocityStreamer::resetStatistics()
+{
+  pimpl_->resetStatistics();
+}
+
+int VelocityStreamer::getError()
+{
+  return pimpl_->getError();
+}
+
+std::string VelocityStreamer::getErrorMessage()
+{
+  return pimpl_->getErrorMessage();
+}
+
+}  // namespace zalpha_api
@@ -15,7 +15,9 @@
  */
 
 #include <zalpha_api/zalpha.hpp>
+#include "impl/clock_sync.hpp"
 #include "impl/zalpha_impl.hpp"
+#include "impl/zmq_transport.hpp"
 
 
 namespace zalpha_api
@@ -44,6 +46,16 @@ bool versionCompatible(std::string api_server_version)
   return lib_version == api_server_version;
 }
 
+void* inprocContext()
+{
+  return (void*) ZmqTransport::inprocContext();
+}
+
+int64_t monotonicTime()
+{
+  return ClockSync::now();
+}
+
 Zalpha::Zalpha() :
   pimpl_(new ZalphaImpl())
 {
@@ -53,9 +65,9 @@ Zalpha::~Zalpha()
 {
 }
 
-bool Zalpha::connect(const std::string& server_ip)
+bool Zalpha::connect(const std::string& server_address)
 {
-  return pimpl_->connect(server_ip);
+  return pimpl_->connect(server_address);
 }
 
 void Zalpha::disconnect()
@@ -63,6 +75,76 @@ void Zalpha::disconnect()
   return pimpl_->disconnect();
 }
 
+void Zalpha::setTimeout(int timeout, int retries)
+{
+  return pimpl_->setTimeout(timeout, retries);
+}
+
+void Zalpha::setPriorityTimeout(int timeout, int retries)
+{
+  pimpl_->setPriorityTimeout(timeout, retries);
+}
+
+void Zalpha::setMotionLifetime(int lifetime)
+{
+  pimpl_->setMotionLifetime(lifetime);
+}
+
+void Zalpha::setReadCollapsing(int max_age)
+{
+  pimpl_->setReadCollapsing(max_age);
+}
+
+void Zalpha::getCollapsedReads(uint64_t& shared, uint64_t& reused)
+{
+  pimpl_->getCollapsedReads(shared, reused);
+}
+
+bool Zalpha::setWireEncoding(uint8_t encoding)
+{
+  return pimpl_->setWireEncoding(encoding);
+}
+
+void Zalpha::getTrafficCounters(uint64_t& bytes_sent, uint64_t& bytes_received)
+{
+  return pimpl_->getTrafficCounters(bytes_sent, bytes_received);
+}
+
+void Zalpha::getLinkQuality(LinkQuality& quality)
+{
+  pimpl_->getLinkQuality(quality);
+}
+
+void Zalpha::resetLinkQuality()
+{
+  pimpl_->resetLinkQuality();
+}
+
+void Zalpha::getConnectionStatus(ConnectionStatus& status)
+{
+  pimpl_->getConnectionStatus(status);
+}
+
+void Zalpha::setMonitored(bool enable)
+{
+  pimpl_->setMonitored(enable);
+}
+
+void Zalpha::setFailFast(bool enable)
+{
+  pimpl_->setFailFast(enable);
+}
+
+bool Zalpha::syncClock(int probes)
+{
+  return pimpl_->syncClock(probes);
+}
+
+bool Zalpha::getClockOffset(int64_t& offset, double& drift)
+{
+  return pimpl_->getClockOffset(offset, drift);
+}
+
 bool Zalpha::versionInfo(std::string& version)
 {
   return pimpl_->versionInfo(version);
@@ -130,27 +212,84 @@ bool Zalpha::resetEncoder()
 
 bool Zalpha::getEncoder(double& left_distance, double& right_distance)
 {
-  return pimpl_->getEncoder(left_distance, right_distance);
+  int64_t timestamp;
+  return pimpl_->getEncoder(left_distance, right_distance, timestamp);
+}
+
+bool Zalpha::getEncoder(double& left_distance, double& right_distance, int64_t& timestamp)
+{
+  return pimpl_->getEncoder(left_distance, right_distance, timestamp);
+}
+
+bool Zalpha::getEncoder(double& left_distance, double& right_distance, int64_t& timestamp, int max_age,
+                        uint8_t& source, int max_prediction)
+{
+  return pimpl_->getEncoder(left_distance, right_distance, timestamp, max_age, source, max_prediction);
 }
 
 bool Zalpha::getRawEncoder(int64_t& left_count, int64_t& right_count)
 {
-  return pimpl_->getRawEncoder(left_count, right_count);
+  int64_t timestamp;
+  return pimpl_->getRawEncoder(left_count, right_count, timestamp);
+}
+
+bool Zalpha::getRawEncoder(int64_t& left_count, int64_t& right_count, int64_t& timestamp)
+{
+  return pimpl_->getRawEncoder(left_count, right_count, timestamp);
+}
+
+bool Zalpha::getRawEncoder(int64_t& left_count, int64_t& right_count, int64_t& timestamp, int max_age,
+                           uint8_t& source, int max_prediction)
+{
+  return pimpl_->getRawEncoder(left_count, right_count, timestamp, max_age, source, max_prediction);
 }
 
 bool Zalpha::getSafetyFlag(uint16_t& safety_flag)
 {
-  return pimpl_->getSafetyFlag(safety_flag);
+  int64_t timestamp;
+  return pimpl_->getSafetyFlag(safety_flag, timestamp);
+}
+
+bool Zalpha::getSafetyFlag(uint16_t& safety_flag, int64_t& timestamp)
+{
+  return pimpl_->getSafetyFlag(safety_flag, timestamp);
 }
 
 bool Zalpha::getEncoderAndSafetyFlag(double& left_distance, double& right_distance, uint16_t& safety_flag)
 {
-  return pimpl_->getEncoderAndSafetyFlag(left_distance, right_distance, safety_flag);
+  int64_t timestamp;
+  return pimpl_->getEncoderAndSafetyFlag(left_distance, right_distance, safety_flag, timestamp);
+}
+
+bool Zalpha::getEncoderAndSafetyFlag(double& left_distance, double& right_distance, uint16_t& safety_flag,
+                                     int64_t& timestamp)
+{
+  return pimpl_->getEncoderAndSafetyFlag(left_distance, right_distance, safety_flag, timestamp);
 }
 
 bool Zalpha::getRawEncoderAndSafetyFlag(int64_t& left_count, int64_t& right_count, uint16_t& safety_flag)
 {
-  return pimpl_->getRawEncoderAndSafetyFlag(left_count, right_count, safety_flag);
+  int64_t timestamp;
+  return pimpl_->getRawEncoderAndSafetyFlag(left_count, right_count, safety_flag, timestamp);
+}
+
+bool Zalpha::getRawEncoderAndSafetyFlag(int64_t& left_count, int64_t& right_count, uint16_t& safety_flag,
+                                        int64_t& timestamp)
+{
+  return pimpl_->getRawEncoderAndSafetyFlag(left_count, right_count, safety_flag, timestamp);
+}
+
+bool Zalpha::getTelemetry(int64_t& left_count, int64_t& right_count, double& left_distance, double& right_distance,
+                          uint16_t& safety_flag)
+{
+  int64_t timestamp;
+  return pimpl_->getTelemetry(left_count, right_count, left_distance, right_distance, safety_flag, timestamp);
+}
+
+bool Zalpha::getTelemetry(int64_t& left_count, int64_t& right_count, double& left_distance, double& right_distance,
+                          uint16_t& safety_flag, int64_t& timestamp)
+{
+  return pimpl_->getTelemetry(left_count, right_count, left_distance, right_distance, safety_flag, timestamp);
 }
 
 bool Zalpha::getBattery(float& battery_percentage)
@@ -170,7 +309,13 @@ bool Zalpha::getCharging(uint8_t& charging_state)
 
 bool Zalpha::getInputs(uint32_t& inputs)
 {
-  return pimpl_->getInputs(inputs);
+  int64_t timestamp;
+  return pimpl_->getInputs(inputs, timestamp);
+}
+
+bool Zalpha::getInputs(uint32_t& inputs, int64_t& timestamp)
+{
+  return pimpl_->getInputs(inputs, timestamp);
 }
 
 bool Zalpha::setOutputs(uint32_t outputs, uint32_t mask)
@@ -193,4 +338,106 @@ std::string Zalpha::getErrorMessage()
   return pimpl_->getErrorMessage();
 }
 
+int Zalpha::getThreadError()
+{
+  return ZalphaImpl::threadError();
+}
+
+/**
+ * \brief The failed result of a read, with the error it set on the calling thread.
+ */
+template <typename T>
+static Result<T> failure()
+{
+  int error = ZalphaImpl::threadError();
+  return Result<T>::failure(error ? error : EC_UNKNOWN_ERROR);
+}
+
+Result<AccelerationLimits> Zalpha::readAcceleration()
+{
+  AccelerationLimits limits;
+  if (!pimpl_->getAcceleration(limits.acceleration, limits.deceleration)) return failure<AccelerationLimits>();
+  return limits;
+}
+
+Result<WheelSpeeds> Zalpha::readTargetSpeed()
+{
+  WheelSpeeds speeds;
+  if (!pimpl_->getTargetSpeed(speeds.left_speed, speeds.right_speed)) return failure<WheelSpeeds>();
+  return speeds;
+}
+
+Result<uint8_t> Zalpha::readActionStatus()
+{
+  uint8_t status;
+  if (!pimpl_->getActionStatus(status)) return failure<uint8_t>();
+  return status;
+}
+
+Result<EncoderReading> Zalpha::readEncoder()
+{
+  EncoderReading reading;
+  if (!pimpl_->getEncoder(reading.left_distance, reading.right_distance, reading.timestamp))
+  {
+    return failure<EncoderReading>();
+  }
+  return reading;
+}
+
+Result<RawEncoderReading> Zalpha::readRawEncoder()
+{
+  RawEncoderReading reading;
+  if (!pimpl_->getRawEncoder(reading.left_count, reading.right_count, reading.timestamp))
+  {
+    return failure<RawEncoderReading>();
+  }
+  return reading;
+}
+
+Result<SafetyReading> Zalpha::readSafetyFlag()
+{
+  SafetyReading reading;
+  if (!pimpl_->getSafetyFlag(reading.safety_flag, reading.timestamp)) return failure<SafetyReading>();
+  return reading;
+}
+
+Result<TelemetryReading> Zalpha::readTelemetry()
+{
+  TelemetryReading reading;
+  if (!pimpl_->getTelemetry(reading.left_count, reading.right_count, reading.left_distance, reading.right_distance,
+                            reading.safety_flag, reading.timestamp))
+  {
+    return failure<TelemetryReading>();
+  }
+  return reading;
+}
+
+Result<float> Zalpha::readBattery()
+{
+  float battery_percentage;
+  if (!pimpl_->getBattery(battery_percentage)) return failure<float>();
+  return battery_percentage;
+}
+
+Result<uint8_t> Zalpha::readCharging()
+{
+  uint8_t charging_state;
+  if (!pimpl_->getCharging(charging_state)) return failure<uint8_t>();
+  return charging_state;
+}
+
+Result<InputsReading> Zalpha::readInputs()
+{
+  InputsReading reading;
+  if (!pimpl_->getInputs(reading.inputs, reading.timestamp)) return failure<InputsReading>();
+  return reading;
+}
+
+Result<uint32_t> Zalpha::readOutputs()
+{
+  uint32_t outputs;
+  if (!pimpl_->getOutputs(outputs)) return failure<uint32_t>();
+  return outputs;
+}
+
 }  // namespace zalpha_api
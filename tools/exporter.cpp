@@ -0,0 +1,531 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <zalpha_api/zalpha.hpp>
+
+
+using zalpha_api::LinkQuality;
+using zalpha_api::Zalpha;
+
+enum
+{
+  DEFAULT_PORT = 9767,
+  DEFAULT_INTERVAL = 1000,
+  DEFAULT_TIMEOUT = 500,
+  MAX_REQUEST_SIZE = 8192,
+};
+
+static volatile std::sig_atomic_t running = 1;
+
+static void stop(int)
+{
+  running = 0;
+}
+
+static double wallTime()
+{
+  return std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+static std::string timestamp()
+{
+  char buffer[32];
+  std::time_t now = std::time(NULL);
+  std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", std::localtime(&now));
+  return buffer;
+}
+
+/**
+ * \brief The readings of a robot from its last poll, and the counters of its polls.
+ */
+struct RobotState
+{
+  bool up;                 ///< whether the last poll succeeded, the readings are only exported then
+  uint64_t polls;
+  uint64_t failures;
+  double last_success;     ///< wall time of the last successful poll, in s
+  double poll_duration;    ///< duration of the last poll, in s
+  float battery;
+  uint8_t charging;
+  uint16_t safety_flag;
+  uint8_t action_status;
+  LinkQuality link;
+  std::string error_message;
+
+  RobotState() :
+    up(false), polls(0), failures(0), last_success(0.0), poll_duration(0.0),
+    battery(0.0f), charging(0), safety_flag(0), action_status(0)
+  {
+    std::memset(&link, 0, sizeof(link));
+  }
+};
+
+/**
+ * \brief A robot of the config, polled by a thread of its own into a cached state.
+ */
+class Robot
+{
+public:
+  Robot(const std::string& name, const std::string& address) :
+    name_(name), address_(address)
+  {
+  }
+
+  const std::string& name() const
+  {
+    return name_;
+  }
+
+  void start(int interval, int timeout, int64_t offset, bool verbose)
+  {
+    thread_ = std::thread(&Robot::run, this, interval, timeout, offset, verbose);
+  }
+  void join()
+  {
+    if (thread_.joinable()) thread_.join();
+  }
+
+  RobotState state()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return state_;
+  }
+
+private:
+  void run(int interval, int timeout, int64_t offset, bool verbose)
+  {
+    typedef std::chrono::steady_clock Clock;
+
+    Zalpha zalpha;
+    zalpha.setTimeout(timeout, 0);
+    bool connected = false;
+
+    // the robots start at different offsets into the interval, so that their polls do not come in bursts
+    Clock::time_point deadline = Clock::now() + std::chrono::microseconds(offset);
+    bool was_up = true;
+    while (running)
+    {
+      while (running && Clock::now() < deadline)
+      {
+        std::this_thread::sleep_for(std::min(std::chrono::duration_cast<Clock::duration>(deadline - Clock::now()),
+                                             std::chrono::duration_cast<Clock::duration>(std::chrono::milliseconds(100))));
+      }
+      if (!running) break;
+
+      RobotState reading;
+      Clock::time_point start = Clock::now();
+      // a robot that could not be connected to is tried again on the next poll, and counts as down until then
+      if (!connected)
+      {
+        connected = zalpha.connect(address_);
+      }
+      // the first failure ends the poll, an unreachable robot costs one timeout
+      bool success = connected && zalpha.getBattery(reading.battery) && zalpha.getCharging(reading.charging) &&
+                     zalpha.getSafetyFlag(reading.safety_flag) &&
+                     zalpha.getActionStatus(reading.action_status);
+      double duration = std::chrono::duration<double>(Clock::now() - start).count();
+
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        state_.polls++;
+        state_.poll_duration = duration;
+        state_.up = success;
+        zalpha.getLinkQuality(state_.link);
+        if (success)
+        {
+          state_.last_success = wallTime();
+          state_.battery = reading.battery;
+          state_.charging = reading.charging;
+          state_.safety_flag = reading.safety_flag;
+          state_.action_status = reading.action_status;
+          state_.error_message.clear();
+        }
+        else
+        {
+          state_.failures++;
+          state_.error_message = zalpha.getErrorMessage();
+        }
+      }
+
+      // the changes of state are always logged, every failure only when verbose
+      if (success != was_up || (!success && verbose))
+      {
+        std::cout << timestamp() << " " << name_ << ": "
+                  << (success ? std::string("up") : "down, " + zalpha.getErrorMessage()) << std::endl;
+      }
+      was_up = success;
+
+      // skip the deadlines missed by a slow poll instead of catching up
+      deadline += std::chrono::milliseconds(interval);
+      while (deadline < Clock::now())
+      {
+        deadline += std::chrono::milliseconds(interval);
+      }
+    }
+    zalpha.disconnect();
+  }
+
+private:
+  std::string name_;
+  std::string address_;
+  std::thread thread_;
+
+  std::mutex mutex_;
+  RobotState state_;
+};
+
+static std::string escapeLabel(const std::string& value)
+{
+  std::string escaped;
+  for (size_t i = 0; i < value.size(); i++)
+  {
+    if (value[i] == '\\' || value[i] == '"') escaped += '\\';
+    if (value[i] == '\n')
+    {
+      escaped += "\\n";
+      continue;
+    }
+    escaped += value[i];
+  }
+  return escaped;
+}
+
+/**
+ * \brief Write the metrics in the Prometheus text format, with the samples of each metric grouped together.
+ */
+static std::string renderMetrics(const std::vector<Robot*>& robots, uint64_t scrapes)
+{
+  std::vector<std::string> labels(robots.size());
+  std::vector<RobotState> states(robots.size());
+  for (size_t i = 0; i < robots.size(); i++)
+  {
+    labels[i] = "robot=\"" + escapeLabel(robots[i]->name()) + "\"";
+    states[i] = robots[i]->state();
+  }
+
+  std::ostringstream oss;
+  oss.precision(9);
+
+  oss << "# HELP zalpha_up Whether the last poll of the robot succeeded.\n"
+      << "# TYPE zalpha_up gauge\n";
+  for (size_t i = 0; i < robots.size(); i++)
+  {
+    oss << "zalpha_up{" << labels[i] << "} " << (states[i].up ? 1 : 0) << "\n";
+  }
+
+#define ZALPHA_EXPORT_READING(metric, help, field) \
+  oss << "# HELP " metric " " help "\n# TYPE " metric " gauge\n"; \
+  for (size_t i = 0; i < robots.size(); i++) \
+  { \
+    if (states[i].up) oss << metric "{" << labels[i] << "} " << (double) states[i].field << "\n"; \
+  }
+
+  // the readings of a robot that is down are left out rather than exported stale
+  ZALPHA_EXPORT_READING("zalpha_battery_percent", "Battery level.", battery)
+  ZALPHA_EXPORT_READING("zalpha_charging_state", "Charging state, see Zalpha::ChargingState.", charging)
+  ZALPHA_EXPORT_READING("zalpha_safety_flags", "Safety flags, as a bit mask of Zalpha::SafetyFlag.", safety_flag)
+  ZALPHA_EXPORT_READING("zalpha_action_status", "Action status, see Zalpha::ActionStatus.", action_status)
+#undef ZALPHA_EXPORT_READING
+
+  oss << "# HELP zalpha_link_rtt_seconds Smoothed round-trip time of the commands.\n"
+      << "# TYPE zalpha_link_rtt_seconds gauge\n";
+  for (size_t i = 0; i < robots.size(); i++)
+  {
+    if (states[i].link.round_trips == 0) continue;
+    oss << "zalpha_link_rtt_seconds{" << labels[i] << "} " << states[i].link.rtt * 1e-6 << "\n";
+  }
+  oss << "# HELP zalpha_link_rtt_quantile_seconds Round-trip time over the last 256 commands.\n"
+      << "# TYPE zalpha_link_rtt_quantile_seconds gauge\n";
+  for (size_t i = 0; i < robots.size(); i++)
+  {
+    const LinkQuality& link = states[i].link;
+    if (link.round_trips == 0) continue;
+    oss << "zalpha_link_rtt_quantile_seconds{" << labels[i] << ",quantile=\"0.5\"} " << link.p50 * 1e-6 << "\n"
+        << "zalpha_link_rtt_quantile_seconds{" << labels[i] << ",quantile=\"0.9\"} " << link.p90 * 1e-6 << "\n"
+        << "zalpha_link_rtt_quantile_seconds{" << labels[i] << ",quantile=\"0.99\"} " << link.p99 * 1e-6 << "\n";
+  }
+  oss << "# HELP zalpha_link_loss_ratio Smoothed fraction of the commands whose reply timed out.\n"
+      << "# TYPE zalpha_link_loss_ratio gauge\n";
+  for (size_t i = 0; i < robots.size(); i++)
+  {
+    oss << "zalpha_link_loss_ratio{" << labels[i] << "} " << states[i].link.loss_rate << "\n";
+  }
+
+  oss << "# HELP zalpha_polls_total Number of polls of the robot.\n"
+      << "# TYPE zalpha_polls_total counter\n";
+  for (size_t i = 0; i < robots.size(); i++)
+  {
+    oss << "zalpha_polls_total{" << labels[i] << "} " << states[i].polls << "\n";
+  }
+  oss << "# HELP zalpha_poll_failures_total Number of polls of the robot that failed.\n"
+      << "# TYPE zalpha_poll_failures_total counter\n";
+  for (size_t i = 0; i < robots.size(); i++)
+  {
+    oss << "zalpha_poll_failures_total{" << labels[i] << "} " << states[i].failures << "\n";
+  }
+  oss << "# HELP zalpha_poll_duration_seconds Duration of the last poll of the robot.\n"
+      << "# TYPE zalpha_poll_duration_seconds gauge\n";
+  for (size_t i = 0; i < robots.size(); i++)
+  {
+    oss << "zalpha_poll_duration_seconds{" << labels[i] << "} " << states[i].poll_duration << "\n";
+  }
+  oss << "# HELP zalpha_last_success_timestamp_seconds Time of the last successful poll of the robot.\n"
+      << "# TYPE zalpha_last_success_timestamp_seconds gauge\n";
+  oss.precision(15);
+  for (size_t i = 0; i < robots.size(); i++)
+  {
+    if (states[i].last_success == 0.0) continue;
+    oss << "zalpha_last_success_timestamp_seconds{" << labels[i] << "} " << states[i].last_success << "\n";
+  }
+
+  oss << "# HELP zalpha_exporter_scrapes_total Number of scrapes of the metrics.\n"
+      << "# TYPE zalpha_exporter_scrapes_total counter\n"
+      << "zalpha_exporter_scrapes_total " << scrapes << "\n";
+  return oss.str();
+}
+
+static int listenTcp(int port)
+{
+  int fd = socket(AF_INET6, SOCK_STREAM, 0);
+  if (fd < 0) return -1;
+
+  // accept IPv4 clients on the same socket
+  int off = 0, on = 1;
+  setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof(off));
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+  struct sockaddr_in6 addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sin6_family = AF_INET6;
+  addr.sin6_addr = in6addr_any;
+  addr.sin6_port = htons(port);
+  if (bind(fd, (struct sockaddr*) &addr, sizeof(addr)) != 0 || listen(fd, 16) != 0)
+  {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+static void sendResponse(int fd, const std::string& status, const std::string& content_type, const std::string& body)
+{
+  std::ostringstream oss;
+  oss << "HTTP/1.1 " << status << "\r\n"
+      << "Content-Type: " << content_type << "\r\n"
+      << "Content-Length: " << body.size() << "\r\n"
+      << "Connection: close\r\n\r\n"
+      << body;
+  std::string response = oss.str();
+  for (size_t sent = 0; sent < response.size(); )
+  {
+    ssize_t rc = send(fd, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+    if (rc <= 0) return;
+    sent += rc;
+  }
+}
+
+/**
+ * \brief Answer one HTTP request, only from the cache, so that a scrape never sends a command to a robot.
+ */
+static void serveClient(int fd, const std::vector<Robot*>& robots, uint64_t& scrapes)
+{
+  // a slow or idle client must not hold up the next scrape for long
+  struct timeval tv = { 1, 0 };
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+  std::string request;
+  char buffer[1024];
+  while (request.find("\r\n\r\n") == std::string::npos && request.size() < MAX_REQUEST_SIZE)
+  {
+    ssize_t rc = recv(fd, buffer, sizeof(buffer), 0);
+    if (rc <= 0) return;
+    request.append(buffer, rc);
+  }
+
+  std::istringstream iss(request);
+  std::string method, target;
+  iss >> method >> target;
+  if (method != "GET" && method != "HEAD")
+  {
+    sendResponse(fd, "405 Method Not Allowed", "text/plain", "Method not allowed.\n");
+  }
+  else if (target == "/metrics" || target.compare(0, 9, "/metrics?") == 0)
+  {
+    scrapes++;
+    std::string body = renderMetrics(robots, scrapes);
+    sendResponse(fd, "200 OK", "text/plain; version=0.0.4; charset=utf-8", method == "HEAD" ? "" : body);
+  }
+  else if (target == "/")
+  {
+    sendResponse(fd, "200 OK", "text/html",
+                 "<html><head><title>Zalpha Exporter</title></head>"
+                 "<body><h1>Zalpha Exporter</h1><p><a href=\"/metrics\">Metrics</a></p></body></html>\n");
+  }
+  else
+  {
+    sendResponse(fd, "404 Not Found", "text/plain", "Not found.\n");
+  }
+}
+
+/**
+ * \brief Read the robots of a config file, one "<name> <address>" or "<address>" per line, # starts a comment.
+ */
+static bool readConfig(const std::string& path, std::vector<Robot*>& robots)
+{
+  std::ifstream file(path.c_str());
+  if (!file)
+  {
+    std::cerr << "Failed to open " << path << std::endl;
+    return false;
+  }
+
+  std::string line;
+  for (int number = 1; std::getline(file, line); number++)
+  {
+    line = line.substr(0, line.find('#'));
+    std::istringstream iss(line);
+    std::string name, address, extra;
+    if (!(iss >> name)) continue;
+    if (!(iss >> address)) address = name;
+    if (iss >> extra)
+    {
+      std::cerr << path << ":" << number << ": Expected \"<name> <address>\" or \"<address>\"." << std::endl;
+      return false;
+    }
+    robots.push_back(new Robot(name, address));
+  }
+  if (robots.empty())
+  {
+    std::cerr << path << ": No robot to poll." << std::endl;
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char** argv)
+{
+  std::string config;
+  int port = DEFAULT_PORT;
+  int interval = DEFAULT_INTERVAL;
+  int timeout = DEFAULT_TIMEOUT;
+  bool verbose = false;
+
+  for (int i = 1; i < argc; i++)
+  {
+    std::string arg(argv[i]);
+    if (arg == "-c" && i + 1 < argc)
+    {
+      config = argv[++i];
+    }
+    else if (arg == "-p" && i + 1 < argc)
+    {
+      port = std::atoi(argv[++i]);
+    }
+    else if (arg == "-i" && i + 1 < argc)
+    {
+      interval = std::max(std::atoi(argv[++i]), 1);
+    }
+    else if (arg == "-t" && i + 1 < argc)
+    {
+      timeout = std::max(std::atoi(argv[++i]), 1);
+    }
+    else if (arg == "-v")
+    {
+      verbose = true;
+    }
+    else
+    {
+      config.clear();
+      break;
+    }
+  }
+  if (config.empty())
+  {
+    std::cout << "Usage: zalpha_exporter -c <config> [-p <port>] [-i <interval_ms>] [-t <timeout_ms>] [-v]" << std::endl;
+    std::cout << "  Polls the robots of the config and serves their readings on http://*:<port>/metrics" << std::endl;
+    std::cout << "  in the Prometheus text format. A scrape is answered from the last polls, without any command." << std::endl;
+    std::cout << "  The config lists one robot per line, as \"<name> <address>\" or \"<address>\", # starts a comment." << std::endl;
+    std::cout << "  -p  HTTP port, " << DEFAULT_PORT << " by default" << std::endl;
+    std::cout << "  -i  Time between the polls of each robot, " << DEFAULT_INTERVAL << " ms by default" << std::endl;
+    std::cout << "  -t  Timeout of each command, " << DEFAULT_TIMEOUT << " ms by default" << std::endl;
+    std::cout << "  -v  Log every failed poll, not only the robots going down and up" << std::endl;
+    return 0;
+  }
+
+  std::vector<Robot*> robots;
+  if (!readConfig(config, robots))
+  {
+    return 1;
+  }
+
+  int listen_fd = listenTcp(port);
+  if (listen_fd < 0)
+  {
+    std::cerr << "Failed to listen on port " << port << ": " << strerror(errno) << std::endl;
+    return 1;
+  }
+  std::cout << "Polling " << robots.size() << " robots every " << interval << " ms, serving http://*:" << port
+            << "/metrics" << std::endl;
+
+  std::signal(SIGINT, stop);
+  std::signal(SIGTERM, stop);
+
+  for (size_t i = 0; i < robots.size(); i++)
+  {
+    robots[i]->start(interval, timeout, (int64_t) interval * 1000 * i / robots.size(), verbose);
+  }
+
+  uint64_t scrapes = 0;
+  while (running)
+  {
+    struct pollfd pfd;
+    pfd.fd = listen_fd;
+    pfd.events = POLLIN;
+    if (poll(&pfd, 1, 100) <= 0) continue;
+
+    int fd = accept(listen_fd, NULL, NULL);
+    if (fd < 0) continue;
+    serveClient(fd, robots, scrapes);
+    close(fd);
+  }
+
+  close(listen_fd);
+  for (size_t i = 0; i < robots.size(); i++)
+  {
+    robots[i]->join();
+    delete robots[i];
+  }
+  return 0;
+}
@@ -0,0 +1,346 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <netinet/in.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <zmq.hpp>
+
+#include "sim_robot.hpp"
+#include "impl/codec.hpp"
+
+
+using zalpha_api::Codec;
+using zalpha_api::Packet;
+using zalpha_api::SimRobot;
+
+static volatile std::sig_atomic_t running = 1;
+
+static void stop(int)
+{
+  running = 0;
+}
+
+static double now()
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static int bindUdp(int port)
+{
+  int fd = socket(AF_INET6, SOCK_DGRAM, 0);
+  if (fd < 0) return -1;
+
+  // accept IPv4 clients on the same socket
+  int off = 0;
+  setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof(off));
+
+  struct sockaddr_in6 addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sin6_family = AF_INET6;
+  addr.sin6_addr = in6addr_any;
+  addr.sin6_port = htons(port);
+  if (bind(fd, (struct sockaddr*) &addr, sizeof(addr)) != 0)
+  {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+/**
+ * \brief One simulated robot and its endpoints.
+ */
+struct Robot
+{
+  SimRobot sim;
+  int port;
+  zmq::socket_t* socket;
+  int udp_fd;
+  unsigned long requests;           ///< requests since the start
+  unsigned long interval_requests;  ///< requests since the last report
+
+  Robot() :
+    port(0), socket(NULL), udp_fd(-1), requests(0), interval_requests(0)
+  {
+  }
+};
+
+static void report(std::vector<Robot>& robots, double elapsed, double busy, bool verbose)
+{
+  unsigned long total = 0, min_requests = (unsigned long) -1, max_requests = 0;
+  size_t active = 0, busiest = 0;
+  for (size_t i = 0; i < robots.size(); i++)
+  {
+    unsigned long requests = robots[i].interval_requests;
+    total += requests;
+    min_requests = std::min(min_requests, requests);
+    if (requests > max_requests)
+    {
+      max_requests = requests;
+      busiest = i;
+    }
+    if (requests > 0) active++;
+  }
+
+  std::printf("%.0f req/s, %zu/%zu robots active, per robot min %.1f mean %.1f max %.1f req/s (port %d), "
+              "reactor busy %.1f %%\n",
+              total / elapsed, active, robots.size(), min_requests / elapsed, total / elapsed / robots.size(),
+              max_requests / elapsed, robots[busiest].port, busy / elapsed * 100.0);
+  if (verbose)
+  {
+    for (size_t i = 0; i < robots.size(); i++)
+    {
+      std::printf("  port %d: %.1f req/s, %lu requests\n", robots[i].port, robots[i].interval_requests / elapsed,
+                  robots[i].requests);
+    }
+  }
+  std::fflush(stdout);
+
+  for (size_t i = 0; i < robots.size(); i++)
+  {
+    robots[i].interval_requests = 0;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  int count = 200;
+  int base_port = 20000;
+  bool use_zmq = true, use_udp = true;
+  double interval = 5.0;
+  bool verbose = false;
+  bool loopback = false;
+
+  for (int i = 1; i < argc; i++)
+  {
+    std::string arg(argv[i]);
+    if (arg == "-n" && i + 1 < argc)
+    {
+      count = std::max(1, std::atoi(argv[++i]));
+    }
+    else if (arg == "-p" && i + 1 < argc)
+    {
+      base_port = std::atoi(argv[++i]);
+    }
+    else if (arg == "-t" && i + 1 < argc)
+    {
+      std::string transports(argv[++i]);
+      use_zmq = (transports == "zmq" || transports == "both");
+      use_udp = (transports == "udp" || transports == "both");
+    }
+    else if (arg == "-r" && i + 1 < argc)
+    {
+      interval = std::max(0.1, std::atof(argv[++i]));
+    }
+    else if (arg == "-v")
+    {
+      verbose = true;
+    }
+    else if (arg == "-l")
+    {
+      loopback = true;
+    }
+    else
+    {
+      std::cout << "Usage: zalpha_fleet_server [-n <count>] [-p <base_port>] [-t zmq|udp|both] [-r <interval>] [-v] [-l]" << std::endl;
+      std::cout << "  Serves many simulated Zalpha AGVs from one thread. Robot i listens on tcp://*:<base_port + i>" << std::endl;
+      std::cout << "  and UDP port <base_port + i>. By default 200 robots are served from port 20000 on both transports." << std::endl;
+      std::cout << "  -r  Interval of the request rate reports, in s, 5 by default" << std::endl;
+      std::cout << "  -v  Report the request rate of every robot" << std::endl;
+      std::cout << "  -l  Loop the outputs 1 - 16 back to the inputs 1 - 16." << std::endl;
+      return 0;
+    }
+  }
+  if (!use_zmq && !use_udp)
+  {
+    std::cerr << "Unknown transport, expected zmq, udp or both" << std::endl;
+    return 1;
+  }
+
+  std::signal(SIGINT, stop);
+  std::signal(SIGTERM, stop);
+
+  // a socket per robot and transport, and a few more for the connections
+  struct rlimit limit;
+  if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max)
+  {
+    limit.rlim_cur = limit.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &limit);
+  }
+
+  zmq::context_t context(1);
+  zmq_ctx_set((void*) context, ZMQ_MAX_SOCKETS, count + 64);
+
+  std::vector<Robot> robots(count);
+  double start = now();
+  for (int i = 0; i < count; i++)
+  {
+    Robot& robot = robots[i];
+    robot.port = base_port + i;
+    robot.sim.setLoopback(loopback);
+    // spread the battery levels, so that the robots can be told apart
+    robot.sim.setBattery(100.0f - (float)(i % 50));
+    robot.sim.update(start);
+
+    if (use_zmq)
+    {
+      std::ostringstream endpoint;
+      endpoint << "tcp://*:" << robot.port;
+      robot.socket = new zmq::socket_t(context, ZMQ_REP);
+      int linger = 0;
+      robot.socket->setsockopt(ZMQ_LINGER, &linger, sizeof(linger));
+      try
+      {
+        robot.socket->bind(endpoint.str().c_str());
+      }
+      catch (const zmq::error_t& ex)
+      {
+        std::cerr << "Failed to bind " << endpoint.str() << ": " << ex.what() << std::endl;
+        return 1;
+      }
+    }
+    if (use_udp)
+    {
+      robot.udp_fd = bindUdp(robot.port);
+      if (robot.udp_fd < 0)
+      {
+        std::cerr << "Failed to bind UDP port " << robot.port << ": " << strerror(errno) << std::endl;
+        return 1;
+      }
+    }
+  }
+  std::cout << "Serving " << count << " robots on " << (use_zmq ? "tcp://*" : "") << (use_zmq && use_udp ? " and " : "")
+            << (use_udp ? "udp://*" : "") << " ports " << base_port << " - " << base_port + count - 1 << std::endl;
+
+  // the items of robot i are at 2 i (ZMQ) and 2 i + 1 (UDP), an unused transport is never ready
+  std::vector<zmq::pollitem_t> items(2 * count);
+  for (int i = 0; i < count; i++)
+  {
+    zmq::pollitem_t zmq_item = { robots[i].socket ? (void*) *robots[i].socket : NULL, -1, ZMQ_POLLIN, 0 };
+    zmq::pollitem_t udp_item = { NULL, robots[i].udp_fd, ZMQ_POLLIN, 0 };
+    items[2 * i] = zmq_item;
+    items[2 * i + 1] = udp_item;
+  }
+  if (!use_zmq || !use_udp)
+  {
+    // keep only the items of the transport in use
+    std::vector<zmq::pollitem_t> used;
+    for (size_t i = use_zmq ? 0 : 1; i < items.size(); i += 2)
+    {
+      used.push_back(items[i]);
+    }
+    items.swap(used);
+  }
+  size_t items_per_robot = (use_zmq && use_udp) ? 2 : 1;
+
+  double last_report = start, last_sweep = start, busy = 0.0;
+  while (running)
+  {
+    try
+    {
+      zmq::poll(&items[0], items.size(), 10);
+    }
+    catch (const zmq::error_t& ex)
+    {
+      if (ex.num() == EINTR) continue;
+      throw;
+    }
+    double time = now();
+    double busy_start = time;
+
+    // every robot moves on at least every 10 ms, and right before it answers a request
+    if (time - last_sweep >= 0.01)
+    {
+      for (size_t i = 0; i < robots.size(); i++)
+      {
+        robots[i].sim.update(time);
+      }
+      last_sweep = time;
+    }
+
+    // every reply uses the encoding of its request
+    Packet request, reply;
+    uint8_t buffer[Codec::MAX_SIZE + 1];
+    for (size_t i = 0; i < items.size(); i++)
+    {
+      if (!(items[i].revents & ZMQ_POLLIN)) continue;
+      Robot& robot = robots[i / items_per_robot];
+      robot.sim.update(time);
+
+      if (items[i].socket)
+      {
+        zmq::message_t message;
+        robot.socket->recv(&message);
+        int encoding = Codec::encodingOf(message.size());
+        if (Codec::decode((const uint8_t*) message.data(), message.size(), request))
+        {
+          robot.sim.handle(request, reply);
+        }
+        else
+        {
+          reply = Packet();
+          encoding = Codec::FIXED;
+        }
+        robot.socket->send(buffer, Codec::encode(reply, encoding, buffer));
+      }
+      else
+      {
+        struct sockaddr_storage from;
+        socklen_t from_len = sizeof(from);
+        ssize_t size = recvfrom(robot.udp_fd, buffer, sizeof(buffer), 0, (struct sockaddr*) &from, &from_len);
+        if (size < 0 || !Codec::decode(buffer, size, request)) continue;
+
+        robot.sim.handle(request, reply);
+        sendto(robot.udp_fd, buffer, Codec::encode(reply, Codec::encodingOf(size), buffer), 0,
+               (struct sockaddr*) &from, from_len);
+      }
+      robot.requests++;
+      robot.interval_requests++;
+    }
+
+    time = now();
+    busy += time - busy_start;
+    if (time - last_report >= interval)
+    {
+      report(robots, time - last_report, busy, verbose);
+      last_report = time;
+      busy = 0.0;
+    }
+  }
+
+  for (size_t i = 0; i < robots.size(); i++)
+  {
+    delete robots[i].socket;
+    if (robots[i].udp_fd >= 0)
+    {
+      close(robots[i].udp_fd);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,666 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <zmq.hpp>
+
+
+static volatile std::sig_atomic_t running = 1;
+
+static void stop(int)
+{
+  running = 0;
+}
+
+static double now()
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static int bindUdp(int port)
+{
+  int fd = socket(AF_INET6, SOCK_DGRAM, 0);
+  if (fd < 0) return -1;
+
+  // accept IPv4 clients on the same socket
+  int off = 0;
+  setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof(off));
+
+  struct sockaddr_in6 addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sin6_family = AF_INET6;
+  addr.sin6_addr = in6addr_any;
+  addr.sin6_port = htons(port);
+  if (bind(fd, (struct sockaddr*) &addr, sizeof(addr)) != 0)
+  {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+/**
+ * \brief Open a UDP socket connected to "host:port".
+ */
+static int connectUdp(const std::string& address)
+{
+  size_t colon = address.rfind(':');
+  if (colon == std::string::npos) return -1;
+  std::string host = address.substr(0, colon);
+  std::string port = address.substr(colon + 1);
+
+  struct addrinfo hints;
+  std::memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_DGRAM;
+  struct addrinfo* result;
+  if (getaddrinfo(host.c_str(), port.c_str(), &hints, &result) != 0) return -1;
+
+  int fd = -1;
+  for (struct addrinfo* ai = result; ai != NULL && fd < 0; ai = ai->ai_next)
+  {
+    fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+    if (fd >= 0 && connect(fd, ai->ai_addr, ai->ai_addrlen) != 0)
+    {
+      close(fd);
+      fd = -1;
+    }
+  }
+  freeaddrinfo(result);
+  return fd;
+}
+
+/**
+ * \brief The impairments applied to every message, in each direction independently.
+ */
+struct Impairment
+{
+  enum Distribution
+  {
+    UNIFORM,
+    NORMAL,
+    PARETO,
+  };
+
+  double delay;          ///< mean one-way delay, in s
+  double jitter;         ///< spread of the delay, in s
+  Distribution distribution;
+  double loss;           ///< probability of a drop
+  double duplication;    ///< probability of a second copy
+  double outage_period;  ///< time between the starts of the outages, in s, or 0 for none
+  double outage_length;  ///< length of the outages, in s
+
+  Impairment() :
+    delay(0.0), jitter(0.0), distribution(UNIFORM), loss(0.0), duplication(0.0), outage_period(0.0), outage_length(0.0)
+  {
+  }
+};
+
+/**
+ * \brief The counters of one direction.
+ */
+struct Counters
+{
+  unsigned long received;
+  unsigned long delivered;
+  unsigned long lost;
+  unsigned long blacked_out;
+  unsigned long duplicated;
+  double total_delay;
+  double max_delay;
+
+  Counters() :
+    received(0), delivered(0), lost(0), blacked_out(0), duplicated(0), total_delay(0.0), max_delay(0.0)
+  {
+  }
+};
+
+/**
+ * \brief A message waiting for its delivery time.
+ */
+struct Message
+{
+  enum Channel
+  {
+    ZMQ_TO_SERVER,
+    ZMQ_TO_CLIENT,
+    UDP_TO_SERVER,
+    UDP_TO_CLIENT,
+  };
+
+  Channel channel;
+  std::vector<std::string> frames;  ///< the ZMQ frames, or the datagram as a single frame
+  std::string client;               ///< the address of the UDP client
+  double sent;                      ///< the time it was received by the proxy
+  unsigned long id;
+};
+
+static const char* CHANNEL_NAMES[] = { "zmq >", "zmq <", "udp >", "udp <" };
+
+class NetemProxy
+{
+public:
+  NetemProxy(const Impairment& impairment, unsigned int seed, bool verbose) :
+    impairment_(impairment), random_(seed), verbose_(verbose), start_(now()), next_id_(1), in_outage_(false)
+  {
+  }
+
+  /**
+   * \brief Schedule the copies of a message that survive the impairments.
+   */
+  void submit(Message message, double time)
+  {
+    int direction = (message.channel == Message::ZMQ_TO_SERVER || message.channel == Message::UDP_TO_SERVER) ? 0 : 1;
+    Counters& counters = counters_[direction];
+    counters.received++;
+    message.sent = time;
+    message.id = next_id_++;
+
+    if (isOutage(time))
+    {
+      counters.blacked_out++;
+      log(time, message, "dropped, outage");
+      return;
+    }
+    if (chance(impairment_.loss))
+    {
+      counters.lost++;
+      log(time, message, "dropped, loss");
+      return;
+    }
+
+    int copies = 1;
+    if (chance(impairment_.duplication))
+    {
+      copies = 2;
+      counters.duplicated++;
+      log(time, message, "duplicated");
+    }
+    for (int i = 0; i < copies; i++)
+    {
+      double delay = sampleDelay();
+      if (verbose_)
+      {
+        char text[64];
+        std::snprintf(text, sizeof(text), "delayed %.3f ms", delay * 1e3);
+        log(time, message, text);
+      }
+      pending_.insert(std::make_pair(time + delay, message));
+    }
+  }
+
+  /**
+   * \brief The time of the next delivery, or a negative value when none is pending.
+   */
+  double nextDelivery() const
+  {
+    return pending_.empty() ? -1.0 : pending_.begin()->first;
+  }
+
+  /**
+   * \brief Take the next message that is due, if any.
+   */
+  bool takeDue(double time, Message& message)
+  {
+    if (pending_.empty() || pending_.begin()->first > time) return false;
+    message = pending_.begin()->second;
+    pending_.erase(pending_.begin());
+
+    int direction = (message.channel == Message::ZMQ_TO_SERVER || message.channel == Message::UDP_TO_SERVER) ? 0 : 1;
+    Counters& counters = counters_[direction];
+    double delay = time - message.sent;
+    counters.delivered++;
+    counters.total_delay += delay;
+    counters.max_delay = std::max(counters.max_delay, delay);
+    return true;
+  }
+
+  /**
+   * \brief Log the start and the end of the outages as they happen.
+   */
+  void updateOutage(double time)
+  {
+    bool outage = isOutage(time);
+    if (outage != in_outage_)
+    {
+      in_outage_ = outage;
+      std::printf("%10.3f        outage %s\n", time - start_, outage ? "begins" : "ends");
+      std::fflush(stdout);
+    }
+  }
+
+  void printSummary() const
+  {
+    static const char* DIRECTIONS[] = { "to server", "to client" };
+    for (int i = 0; i < 2; i++)
+    {
+      const Counters& c = counters_[i];
+      std::printf("%s: %lu received, %lu delivered, %lu lost, %lu in outages, %lu duplicated, "
+                  "mean delay %.3f ms, max delay %.3f ms\n",
+                  DIRECTIONS[i], c.received, c.delivered, c.lost, c.blacked_out, c.duplicated,
+                  c.delivered ? c.total_delay / c.delivered * 1e3 : 0.0, c.max_delay * 1e3);
+    }
+  }
+
+private:
+  bool chance(double probability)
+  {
+    return probability > 0.0 && std::uniform_real_distribution<double>(0.0, 1.0)(random_) < probability;
+  }
+
+  bool isOutage(double time) const
+  {
+    if (impairment_.outage_period <= 0.0) return false;
+    // the first outage starts one period after the start of the proxy
+    double elapsed = time - start_;
+    return elapsed >= impairment_.outage_period &&
+           std::fmod(elapsed, impairment_.outage_period) < impairment_.outage_length;
+  }
+
+  double sampleDelay()
+  {
+    double delay = impairment_.delay;
+    if (impairment_.jitter > 0.0)
+    {
+      switch (impairment_.distribution)
+      {
+      case Impairment::UNIFORM:
+        delay += std::uniform_real_distribution<double>(-impairment_.jitter, impairment_.jitter)(random_);
+        break;
+      case Impairment::NORMAL:
+        delay += std::normal_distribution<double>(0.0, impairment_.jitter)(random_);
+        break;
+      case Impairment::PARETO:
+      {
+        // heavy tail above the mean delay, with a mean excess of the jitter (shape 2)
+        double u = std::uniform_real_distribution<double>(0.0, 1.0)(random_);
+        delay += impairment_.jitter * (1.0 / std::sqrt(1.0 - u) - 1.0);
+        break;
+      }
+      }
+    }
+    return std::max(delay, 0.0);
+  }
+
+  void log(double time, const Message& message, const char* action)
+  {
+    std::printf("%10.3f %s #%lu %s\n", time - start_, CHANNEL_NAMES[message.channel], message.id, action);
+    std::fflush(stdout);
+  }
+
+private:
+  Impairment impairment_;
+  std::mt19937 random_;
+  bool verbose_;
+  double start_;
+  unsigned long next_id_;
+  bool in_outage_;
+
+  std::multimap<double, Message> pending_;
+  Counters counters_[2];
+};
+
+/**
+ * \brief The upstream socket of a UDP client.
+ */
+struct UdpClient
+{
+  int fd;
+  double last_active;
+};
+
+static std::vector<std::string> receiveFrames(zmq::socket_t& socket)
+{
+  std::vector<std::string> frames;
+  int more = 1;
+  while (more)
+  {
+    zmq::message_t frame;
+    socket.recv(&frame);
+    frames.push_back(std::string((const char*) frame.data(), frame.size()));
+    size_t more_size = sizeof(more);
+    socket.getsockopt(ZMQ_RCVMORE, &more, &more_size);
+  }
+  return frames;
+}
+
+static void sendFrames(zmq::socket_t& socket, const std::vector<std::string>& frames)
+{
+  for (size_t i = 0; i < frames.size(); i++)
+  {
+    socket.send(frames[i].data(), frames[i].size(), (i + 1 < frames.size()) ? ZMQ_SNDMORE : 0);
+  }
+}
+
+static void usage()
+{
+  std::cout << "Usage: zalpha_netem_proxy [-z <zmq_endpoint>] [-c <zmq_server>] [-u <udp_port>] [-U <udp_server>]" << std::endl;
+  std::cout << "                          [-d <ms>] [-j <ms>] [-D uniform|normal|pareto] [-l <%>] [-x <%>]" << std::endl;
+  std::cout << "                          [-o <period_ms>,<length_ms>] [-s <seed>] [-v]" << std::endl;
+  std::cout << "  Forwards the messages between the clients and an API server, with network impairments." << std::endl;
+  std::cout << "  Without any endpoint, it binds to tcp://*:17167 and UDP port 17167, and forwards to" << std::endl;
+  std::cout << "  tcp://localhost:17168 and localhost:17168, where zalpha_stand_in_server -z tcp://*:17168 -u 17168 listens." << std::endl;
+  std::cout << "  -z  ZMQ endpoint to listen on, -c  ZMQ endpoint of the server" << std::endl;
+  std::cout << "  -u  UDP port to listen on, -U  UDP address of the server, as host:port" << std::endl;
+  std::cout << "  -d  Mean one-way delay, -j  Jitter, the half-width, standard deviation or mean excess of the delay" << std::endl;
+  std::cout << "  -D  Distribution of the delay, uniform by default" << std::endl;
+  std::cout << "  -l  Loss rate, -x  Duplication rate, in percent of the messages" << std::endl;
+  std::cout << "  -o  Outages, during which every message is dropped, as the time between them and their length" << std::endl;
+  std::cout << "  -s  Seed of the random generator, -v  Log every message, not only the impairments" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+  std::string zmq_endpoint, zmq_server;
+  int udp_port = -1;
+  std::string udp_server;
+  Impairment impairment;
+  unsigned int seed = std::random_device()();
+  bool verbose = false;
+
+  for (int i = 1; i < argc; i++)
+  {
+    std::string arg(argv[i]);
+    if (arg == "-z" && i + 1 < argc)
+    {
+      zmq_endpoint = argv[++i];
+    }
+    else if (arg == "-c" && i + 1 < argc)
+    {
+      zmq_server = argv[++i];
+    }
+    else if (arg == "-u" && i + 1 < argc)
+    {
+      udp_port = std::atoi(argv[++i]);
+    }
+    else if (arg == "-U" && i + 1 < argc)
+    {
+      udp_server = argv[++i];
+    }
+    else if (arg == "-d" && i + 1 < argc)
+    {
+      impairment.delay = std::atof(argv[++i]) * 1e-3;
+    }
+    else if (arg == "-j" && i + 1 < argc)
+    {
+      impairment.jitter = std::atof(argv[++i]) * 1e-3;
+    }
+    else if (arg == "-D" && i + 1 < argc)
+    {
+      std::string name(argv[++i]);
+      if (name == "uniform") impairment.distribution = Impairment::UNIFORM;
+      else if (name == "normal") impairment.distribution = Impairment::NORMAL;
+      else if (name == "pareto") impairment.distribution = Impairment::PARETO;
+      else
+      {
+        usage();
+        return 1;
+      }
+    }
+    else if (arg == "-l" && i + 1 < argc)
+    {
+      impairment.loss = std::atof(argv[++i]) * 1e-2;
+    }
+    else if (arg == "-x" && i + 1 < argc)
+    {
+      impairment.duplication = std::atof(argv[++i]) * 1e-2;
+    }
+    else if (arg == "-o" && i + 1 < argc)
+    {
+      double period, length;
+      if (std::sscanf(argv[++i], "%lf,%lf", &period, &length) != 2 || period <= length)
+      {
+        usage();
+        return 1;
+      }
+      impairment.outage_period = period * 1e-3;
+      impairment.outage_length = length * 1e-3;
+    }
+    else if (arg == "-s" && i + 1 < argc)
+    {
+      seed = std::strtoul(argv[++i], NULL, 0);
+    }
+    else if (arg == "-v")
+    {
+      verbose = true;
+    }
+    else
+    {
+      usage();
+      return 0;
+    }
+  }
+  if (zmq_endpoint.empty() && udp_port < 0)
+  {
+    zmq_endpoint = "tcp://*:17167";
+    udp_port = 17167;
+  }
+  if (!zmq_endpoint.empty() && zmq_server.empty())
+  {
+    zmq_server = "tcp://localhost:17168";
+  }
+  if (udp_port >= 0 && udp_server.empty())
+  {
+    udp_server = "localhost:17168";
+  }
+
+  std::signal(SIGINT, stop);
+  std::signal(SIGTERM, stop);
+
+  // ROUTER and DEALER carry the REQ envelopes through, so that each reply returns to its client
+  zmq::context_t context(1);
+  zmq::socket_t frontend(context, ZMQ_ROUTER);
+  zmq::socket_t backend(context, ZMQ_DEALER);
+  int linger = 0;
+  frontend.setsockopt(ZMQ_LINGER, &linger, sizeof(linger));
+  backend.setsockopt(ZMQ_LINGER, &linger, sizeof(linger));
+  if (!zmq_endpoint.empty())
+  {
+    try
+    {
+      frontend.bind(zmq_endpoint.c_str());
+      backend.connect(zmq_server.c_str());
+    }
+    catch (const zmq::error_t& ex)
+    {
+      std::cerr << "Failed to set up " << zmq_endpoint << " -> " << zmq_server << ": " << ex.what() << std::endl;
+      return 1;
+    }
+    std::cout << "Forwarding " << zmq_endpoint << " -> " << zmq_server << std::endl;
+  }
+
+  int udp_fd = -1;
+  if (udp_port >= 0)
+  {
+    udp_fd = bindUdp(udp_port);
+    if (udp_fd < 0)
+    {
+      std::cerr << "Failed to bind UDP port " << udp_port << ": " << strerror(errno) << std::endl;
+      return 1;
+    }
+    std::cout << "Forwarding udp://*:" << udp_port << " -> " << udp_server << std::endl;
+  }
+
+  std::printf("Delay %.3f ms, jitter %.3f ms, loss %.2f %%, duplication %.2f %%, outages %.0f ms every %.0f ms, seed %u\n",
+              impairment.delay * 1e3, impairment.jitter * 1e3, impairment.loss * 1e2, impairment.duplication * 1e2,
+              impairment.outage_length * 1e3, impairment.outage_period * 1e3, seed);
+  std::fflush(stdout);
+
+  NetemProxy proxy(impairment, seed, verbose);
+  // one upstream socket per UDP client, so that the replies can be told apart
+  std::map<std::string, UdpClient> udp_clients;
+
+  while (running)
+  {
+    std::vector<zmq::pollitem_t> items;
+    std::vector<std::string> item_clients;
+    if (!zmq_endpoint.empty())
+    {
+      zmq::pollitem_t front_item = { (void*) frontend, 0, ZMQ_POLLIN, 0 };
+      zmq::pollitem_t back_item = { (void*) backend, 0, ZMQ_POLLIN, 0 };
+      items.push_back(front_item);
+      items.push_back(back_item);
+      item_clients.resize(2);
+    }
+    if (udp_fd >= 0)
+    {
+      zmq::pollitem_t udp_item = { NULL, udp_fd, ZMQ_POLLIN, 0 };
+      items.push_back(udp_item);
+      item_clients.push_back(std::string());
+      for (std::map<std::string, UdpClient>::iterator it = udp_clients.begin(); it != udp_clients.end(); ++it)
+      {
+        zmq::pollitem_t client_item = { NULL, it->second.fd, ZMQ_POLLIN, 0 };
+        items.push_back(client_item);
+        item_clients.push_back(it->first);
+      }
+    }
+
+    double time = now();
+    long timeout = 10;
+    if (proxy.nextDelivery() >= 0.0)
+    {
+      timeout = std::min(timeout, (long) std::ceil(std::max(proxy.nextDelivery() - time, 0.0) * 1e3));
+    }
+    try
+    {
+      zmq::poll(&items[0], items.size(), timeout);
+    }
+    catch (const zmq::error_t& ex)
+    {
+      if (ex.num() == EINTR) continue;
+      throw;
+    }
+    time = now();
+    proxy.updateOutage(time);
+
+    for (size_t i = 0; i < items.size(); i++)
+    {
+      if (!(items[i].revents & ZMQ_POLLIN)) continue;
+
+      Message message;
+      if (items[i].socket == (void*) frontend)
+      {
+        message.channel = Message::ZMQ_TO_SERVER;
+        message.frames = receiveFrames(frontend);
+      }
+      else if (items[i].socket == (void*) backend)
+      {
+        message.channel = Message::ZMQ_TO_CLIENT;
+        message.frames = receiveFrames(backend);
+      }
+      else
+      {
+        char buffer[65536];
+        struct sockaddr_storage from;
+        socklen_t from_len = sizeof(from);
+        ssize_t size = recvfrom(items[i].fd, buffer, sizeof(buffer), 0, (struct sockaddr*) &from, &from_len);
+        if (size < 0) continue;
+
+        message.frames.push_back(std::string(buffer, size));
+        if (items[i].fd == udp_fd)
+        {
+          message.channel = Message::UDP_TO_SERVER;
+          message.client = std::string((const char*) &from, from_len);
+          if (udp_clients.find(message.client) == udp_clients.end())
+          {
+            UdpClient client = { connectUdp(udp_server), time };
+            if (client.fd < 0)
+            {
+              std::cerr << "Failed to connect to " << udp_server << std::endl;
+              continue;
+            }
+            udp_clients[message.client] = client;
+          }
+          udp_clients[message.client].last_active = time;
+        }
+        else
+        {
+          message.channel = Message::UDP_TO_CLIENT;
+          message.client = item_clients[i];
+        }
+      }
+      proxy.submit(message, time);
+    }
+
+    Message message;
+    while (proxy.takeDue(now(), message))
+    {
+      switch (message.channel)
+      {
+      case Message::ZMQ_TO_SERVER:
+        sendFrames(backend, message.frames);
+        break;
+      case Message::ZMQ_TO_CLIENT:
+        sendFrames(frontend, message.frames);
+        break;
+      case Message::UDP_TO_SERVER:
+      {
+        std::map<std::string, UdpClient>::iterator it = udp_clients.find(message.client);
+        if (it != udp_clients.end())
+        {
+          send(it->second.fd, message.frames[0].data(), message.frames[0].size(), 0);
+        }
+        break;
+      }
+      case Message::UDP_TO_CLIENT:
+        sendto(udp_fd, message.frames[0].data(), message.frames[0].size(), 0,
+               (const struct sockaddr*) message.client.data(), message.client.size());
+        break;
+      }
+    }
+
+    // forget the UDP clients that have been quiet for a minute
+    for (std::map<std::string, UdpClient>::iterator it = udp_clients.begin(); it != udp_clients.end();)
+    {
+      if (time - it->second.last_active > 60.0)
+      {
+        close(it->second.fd);
+        udp_clients.erase(it++);
+      }
+      else
+      {
+        ++it;
+      }
+    }
+  }
+
+  proxy.printSummary();
+  for (std::map<std::string, UdpClient>::iterator it = udp_clients.begin(); it != udp_clients.end(); ++it)
+  {
+    close(it->second.fd);
+  }
+  if (udp_fd >= 0)
+  {
+    close(udp_fd);
+  }
+  return 0;
+}
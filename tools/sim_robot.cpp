@@ -0,0 +1,355 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "sim_robot.hpp"
+#include "impl/codec.hpp"
+
+
+namespace zalpha_api
+{
+
+const double SimRobot::WHEEL_BASE = 0.5;
+
+SimRobot::SimRobot() :
+  start_time_(0.0), time_(-1.0),
+  acceleration_(0.5f), deceleration_(0.5f),
+  target_left_(0.0f), target_right_(0.0f),
+  speed_left_(0.0f), speed_right_(0.0f),
+  distance_left_(0.0), distance_right_(0.0),
+  distance_offset_left_(0.0), distance_offset_right_(0.0),
+  action_status_(0), action_remaining_(0.0),
+  action_left_(0.0f), action_right_(0.0f),
+  safety_flag_(0), battery_(100.0f), charging_(false),
+  inputs_(0), outputs_(0), loopback_(false)
+{
+}
+
+void SimRobot::update(double time)
+{
+  if (time_ < 0.0)
+  {
+    start_time_ = time;
+  }
+  double dt = (time_ < 0.0) ? 0.0 : time - time_;
+  time_ = time;
+  if (dt <= 0.0) return;
+
+  // bit 7-0 are the critical safety flags, which stop the agv
+  bool safety_stop = (safety_flag_ & 0x00FF) != 0;
+
+  float left = target_left_;
+  float right = target_right_;
+  if (action_status_ == 1 /* AC_IN_PROGRESS */)
+  {
+    if (safety_stop)
+    {
+      action_status_ = 3 /* AC_SAFETY_TRIGGERED */;
+    }
+    else
+    {
+      action_remaining_ -= dt;
+      if (action_remaining_ <= 0.0)
+      {
+        action_status_ = 0 /* AC_COMPLETED */;
+      }
+    }
+  }
+  else if (action_status_ == 3 && !safety_stop)
+  {
+    action_status_ = 1;
+  }
+
+  if (action_status_ == 1)
+  {
+    left = action_left_;
+    right = action_right_;
+  }
+  else if (action_status_ != 0 || safety_stop)
+  {
+    left = right = 0.0f;
+  }
+
+  speed_left_ = approach(speed_left_, left, acceleration_, deceleration_, dt);
+  speed_right_ = approach(speed_right_, right, acceleration_, deceleration_, dt);
+  distance_left_ += speed_left_ * dt;
+  distance_right_ += speed_right_ * dt;
+
+  if (charging_)
+  {
+    battery_ = std::min(100.0f, battery_ + (float)(0.05 * dt));
+  }
+  else if (speed_left_ != 0.0f || speed_right_ != 0.0f)
+  {
+    battery_ = std::max(0.0f, battery_ - (float)(0.01 * dt));
+  }
+}
+
+void SimRobot::handle(const Packet& request, Packet& reply)
+{
+  reply = Packet();
+  reply.command = request.command;
+  reply.reserved[0] = request.reserved[0];
+
+  uint16_t result = Packet::RESULT_OK;
+  bool busy = (action_status_ != 0);
+
+  // a request delayed beyond its deadline, for eg: queued while the link stalled, is not executed
+  if (request.expired(clock()))
+  {
+    reply.data.u16[0] = Packet::RESULT_ERROR_EXPIRED;
+    return;
+  }
+  // a motion overtaken by a halt of the same client, sent through its priority lane, is not executed after it
+  uint32_t epoch = request.haltEpoch();
+  if (epoch != 0)
+  {
+    std::map<uint16_t, uint32_t>::iterator last = halt_epochs_.find((uint16_t) (epoch >> 16));
+    if (Packet::isHalt(request.command, request))
+    {
+      if (last == halt_epochs_.end() || Packet::supersedes(epoch, last->second))
+      {
+        halt_epochs_[(uint16_t) (epoch >> 16)] = epoch;
+      }
+    }
+    else if (Packet::isMotion(request.command, request) && last != halt_epochs_.end() &&
+             Packet::supersedes(last->second, epoch))
+    {
+      reply.data.u16[0] = Packet::RESULT_ERROR_EXPIRED;
+      return;
+    }
+  }
+
+  switch (request.command)
+  {
+  case Packet::VERSION_INFO:
+    std::strncpy((char*) reply.data.s8, zalpha_api_VERSION, Packet::MAX_PAYLOAD - 1);
+    return;
+  case Packet::TIME_SYNC:
+    // the requests are handled as soon as they are received
+    reply.data.u64[0] = clock();
+    reply.data.u64[1] = clock();
+    return;
+  case Packet::SET_ENCODING:
+    // the frames are decoded by their size, so any known encoding is accepted right away
+    if (request.data.u8[0] > Codec::COMPACT)
+    {
+      result = Packet::RESULT_ERROR_INVALID_COMMAND;
+    }
+    break;
+  case Packet::SET_ACCELERATION:
+    if (request.data.f[0] <= 0.0f || request.data.f[1] <= 0.0f)
+    {
+      result = Packet::RESULT_ERROR_INVALID_COMMAND;
+      break;
+    }
+    acceleration_ = request.data.f[0];
+    deceleration_ = request.data.f[1];
+    break;
+  case Packet::GET_ACCELERATION:
+    reply.data.f[0] = acceleration_;
+    reply.data.f[1] = deceleration_;
+    return;
+  case Packet::SET_TARGET_SPEED:
+    if (busy)
+    {
+      result = Packet::RESULT_ERROR_BUSY;
+      break;
+    }
+    target_left_ = request.data.f[0];
+    target_right_ = request.data.f[1];
+    break;
+  case Packet::GET_TARGET_SPEED:
+    reply.data.f[0] = target_left_;
+    reply.data.f[1] = target_right_;
+    return;
+  case Packet::MOVE_STRAIGHT:
+  {
+    float speed = request.data.f[0];
+    float distance = request.data.f[1];
+    if (speed <= 0.0f)
+    {
+      result = Packet::RESULT_ERROR_INVALID_COMMAND;
+      break;
+    }
+    if (busy)
+    {
+      result = Packet::RESULT_ERROR_BUSY;
+      break;
+    }
+    float wheel = (distance < 0.0f) ? -speed : speed;
+    startAction(wheel, wheel, std::fabs(distance) / speed);
+    break;
+  }
+  case Packet::MOVE_BEZIER:
+  {
+    float f[7];
+    std::memcpy(f, request.data.f, sizeof(f));
+    if (f[0] <= 0.0f)
+    {
+      result = Packet::RESULT_ERROR_INVALID_COMMAND;
+      break;
+    }
+    if (busy)
+    {
+      result = Packet::RESULT_ERROR_BUSY;
+      break;
+    }
+    // the arc length lies between the chord and the length of the control polygon
+    double chord = std::hypot(f[1], f[2]);
+    double polygon = std::hypot(f[3], f[4]) + std::hypot(f[5] - f[3], f[6] - f[4]) + std::hypot(f[1] - f[5], f[2] - f[6]);
+    float wheel = (f[1] < 0.0f) ? -f[0] : f[0];
+    startAction(wheel, wheel, (chord + polygon) / 2.0 / f[0]);
+    break;
+  }
+  case Packet::ROTATE:
+  {
+    float speed = request.data.f[0];
+    float angle = request.data.f[1];
+    if (speed <= 0.0f)
+    {
+      result = Packet::RESULT_ERROR_INVALID_COMMAND;
+      break;
+    }
+    if (busy)
+    {
+      result = Packet::RESULT_ERROR_BUSY;
+      break;
+    }
+    float wheel = (float)(speed * WHEEL_BASE / 2.0);
+    if (angle < 0.0f)
+    {
+      wheel = -wheel;
+    }
+    startAction(-wheel, wheel, std::fabs(angle) / speed);
+    break;
+  }
+  case Packet::GET_ACTION_STATUS:
+    reply.data.u8[0] = action_status_;
+    return;
+  case Packet::PAUSE_ACTION:
+    if (action_status_ == 1 || action_status_ == 3)
+    {
+      action_status_ = 2;
+    }
+    break;
+  case Packet::RESUME_ACTION:
+    if (action_status_ == 2)
+    {
+      action_status_ = 1;
+    }
+    break;
+  case Packet::STOP_ACTION:
+    action_status_ = 0;
+    target_left_ = target_right_ = 0.0f;
+    break;
+  case Packet::RESET_ENCODER:
+    distance_offset_left_ = distance_left_;
+    distance_offset_right_ = distance_right_;
+    break;
+  case Packet::GET_ENCODER:
+    reply.data.d[0] = distance_left_ - distance_offset_left_;
+    reply.data.d[1] = distance_right_ - distance_offset_right_;
+    reply.data.u64[Packet::TIMESTAMP_INDEX] = clock();
+    return;
+  case Packet::GET_RAW_ENCODER:
+    reply.data.s64[0] = llround((distance_left_ - distance_offset_left_) * COUNTS_PER_METER);
+    reply.data.s64[1] = llround((distance_right_ - distance_offset_right_) * COUNTS_PER_METER);
+    reply.data.u64[Packet::TIMESTAMP_INDEX] = clock();
+    return;
+  case Packet::GET_SAFETY_FLAG:
+    reply.data.u16[0] = safety_flag_;
+    reply.data.u64[Packet::TIMESTAMP_INDEX] = clock();
+    return;
+  case Packet::GET_ENCODER_AND_SAFETY_FLAG:
+    reply.data.d[0] = distance_left_ - distance_offset_left_;
+    reply.data.d[1] = distance_right_ - distance_offset_right_;
+    reply.data.u16[8] = safety_flag_;
+    reply.data.u64[Packet::TIMESTAMP_INDEX] = clock();
+    return;
+  case Packet::GET_RAW_ENCODER_AND_SAFETY_FLAG:
+    reply.data.s64[0] = llround((distance_left_ - distance_offset_left_) * COUNTS_PER_METER);
+    reply.data.s64[1] = llround((distance_right_ - distance_offset_right_) * COUNTS_PER_METER);
+    reply.data.u16[8] = safety_flag_;
+    reply.data.u64[Packet::TIMESTAMP_INDEX] = clock();
+    return;
+  case Packet::GET_TELEMETRY:
+  {
+    TelemetrySample sample;
+    sample.field[0] = llround((distance_left_ - distance_offset_left_) * COUNTS_PER_METER);
+    sample.field[1] = llround((distance_right_ - distance_offset_right_) * COUNTS_PER_METER);
+    sample.field[2] = llround((distance_left_ - distance_offset_left_) * 1e6);
+    sample.field[3] = llround((distance_right_ - distance_offset_right_) * 1e6);
+    sample.field[4] = safety_flag_;
+    sample.field[5] = clock();
+    telemetry_.encode(request, sample, reply);
+    return;
+  }
+  case Packet::GET_BATTERY:
+    reply.data.f[0] = battery_;
+    return;
+  case Packet::SET_CHARGING:
+    charging_ = (request.data.u8[0] != 0);
+    break;
+  case Packet::GET_CHARGING:
+    reply.data.u8[0] = (charging_ ? 0x02 : 0) | (battery_ >= 100.0f ? 0x04 : 0);
+    return;
+  case Packet::GET_INPUTS:
+    reply.data.u32[0] = inputs_;
+    reply.data.u64[Packet::TIMESTAMP_INDEX] = clock();
+    return;
+  case Packet::SET_OUTPUTS:
+    outputs_ = (outputs_ & ~request.data.u32[1]) | (request.data.u32[0] & request.data.u32[1]);
+    if (loopback_)
+    {
+      inputs_ = (inputs_ & ~0xFFFFu) | (outputs_ & 0xFFFFu);
+    }
+    break;
+  case Packet::GET_OUTPUTS:
+    reply.data.u32[0] = outputs_;
+    return;
+  default:
+    result = Packet::RESULT_ERROR_INVALID_COMMAND;
+    break;
+  }
+  reply.data.u16[0] = result;
+}
+
+void SimRobot::startAction(float left_speed, float right_speed, double duration)
+{
+  action_status_ = 1;
+  action_left_ = left_speed;
+  action_right_ = right_speed;
+  action_remaining_ = duration;
+  target_left_ = target_right_ = 0.0f;
+}
+
+float SimRobot::approach(float current, float target, float acceleration, float deceleration, double dt)
+{
+  // speeding up uses the acceleration, slowing down or reversing uses the deceleration
+  bool speeding_up = (current * target >= 0.0f) && (std::fabs(target) > std::fabs(current));
+  float step = (float)((speeding_up ? acceleration : deceleration) * dt);
+  if (std::fabs(target - current) <= step)
+  {
+    return target;
+  }
+  return (target > current) ? current + step : current - step;
+}
+
+}  // namespace zalpha_api
@@ -0,0 +1,128 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ZALPHA_API_TOOLS_SIM_ROBOT_HPP
+#define ZALPHA_API_TOOLS_SIM_ROBOT_HPP
+
+#include <stdint.h>
+#include <cmath>
+#include <map>
+
+#include "impl/packet.hpp"
+#include "impl/telemetry.hpp"
+
+
+namespace zalpha_api
+{
+
+/**
+ * \brief SimRobot is a simplified %Zalpha AGV that answers the API commands.
+ *
+ * It keeps a differential-drive kinematic state, encoders, safety flag, battery and I/O,
+ * and is advanced in time with update(). It stands in for the API server in tests.
+ */
+class SimRobot
+{
+public:
+  enum
+  {
+    COUNTS_PER_METER = 10000,  ///< Raw encoder resolution
+  };
+  static const double WHEEL_BASE;  ///< Distance between the wheels, in m
+
+public:
+  SimRobot();
+
+  /**
+   * \brief Advance the simulation to the given time.
+   * @param time             The monotonic time, specified in s
+   */
+  void update(double time);
+  /**
+   * \brief Handle a request and fill in its reply.
+   *
+   * The command and the sequence number of the request are copied into the reply.
+   */
+  void handle(const Packet& request, Packet& reply);
+  /**
+   * \brief The robot clock, in microseconds since the first update.
+   *
+   * It stamps the readings, and has an offset from the host clock like the clock of a real robot.
+   */
+  uint64_t clock() const
+  {
+    return (time_ < 0.0) ? 0 : (uint64_t) llround((time_ - start_time_) * 1e6) + 1;
+  }
+
+  void setSafetyFlag(uint16_t safety_flag)
+  {
+    safety_flag_ = safety_flag;
+  }
+  void setBattery(float battery_percentage)
+  {
+    battery_ = battery_percentage;
+  }
+  void setInputs(uint32_t inputs)
+  {
+    inputs_ = inputs;
+  }
+  /**
+   * \brief Wire the outputs 1 - 16 to the inputs 1 - 16, to exercise the input handling of the clients.
+   */
+  void setLoopback(bool loopback)
+  {
+    loopback_ = loopback;
+  }
+
+private:
+  void startAction(float left_speed, float right_speed, double duration);
+  static float approach(float current, float target, float acceleration, float deceleration, double dt);
+
+private:
+  double start_time_;
+  double time_;
+
+  float acceleration_;
+  float deceleration_;
+  float target_left_;
+  float target_right_;
+  float speed_left_;
+  float speed_right_;
+  double distance_left_;
+  double distance_right_;
+  double distance_offset_left_;
+  double distance_offset_right_;
+
+  uint8_t action_status_;
+  double action_remaining_;
+  float action_left_;
+  float action_right_;
+
+  uint16_t safety_flag_;
+  float battery_;
+  bool charging_;
+  uint32_t inputs_;
+  uint32_t outputs_;
+  bool loopback_;
+
+  std::map<uint16_t, uint32_t> halt_epochs_;  ///< the epoch of the last halt executed, by client
+
+  TelemetryEncoder telemetry_;
+};
+
+}  // namespace zalpha_api
+
+#endif  // ZALPHA_API_TOOLS_SIM_ROBOT_HPP
@@ -0,0 +1,315 @@
+/*
+ * Copyright 2017 DF Automation & Robotics Sdn. Bhd.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <zmq.hpp>
+
+#include "sim_robot.hpp"
+#include "impl/codec.hpp"
+#ifdef __linux__
+#include "impl/shm_segment.hpp"
+#endif
+
+
+using zalpha_api::Codec;
+using zalpha_api::Packet;
+using zalpha_api::SimRobot;
+#ifdef __linux__
+using zalpha_api::ShmChannel;
+using zalpha_api::ShmLayout;
+using zalpha_api::ShmSegment;
+#endif
+
+static volatile std::sig_atomic_t running = 1;
+
+static void stop(int)
+{
+  running = 0;
+}
+
+static double now()
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static int bindUdp(int port)
+{
+  int fd = socket(AF_INET6, SOCK_DGRAM, 0);
+  if (fd < 0) return -1;
+
+  // accept IPv4 clients on the same socket
+  int off = 0;
+  setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof(off));
+
+  struct sockaddr_in6 addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sin6_family = AF_INET6;
+  addr.sin6_addr = in6addr_any;
+  addr.sin6_port = htons(port);
+  if (bind(fd, (struct sockaddr*) &addr, sizeof(addr)) != 0)
+  {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+/**
+ * \brief Whether a sequence number comes after another one, allowing for wrap-around.
+ */
+static bool isNewer(uint16_t sequence, uint16_t last)
+{
+  return (int16_t)(sequence - last) > 0;
+}
+
+#ifdef __linux__
+/**
+ * \brief Serve the channels of a shared memory segment until the server stops, sleeping on its doorbell when idle.
+ */
+static void serveShm(ShmSegment* segment, SimRobot* robot, std::mutex* robot_mutex)
+{
+  ShmLayout* layout = segment->layout();
+  while (running)
+  {
+    uint32_t doorbell = layout->doorbell.load();
+    bool served = false;
+    for (int i = 0; i < ShmLayout::NUM_CHANNELS; i++)
+    {
+      ShmChannel& channel = layout->channel[i];
+      Packet request, reply;
+      while (channel.request.pop(request))
+      {
+        {
+          std::lock_guard<std::mutex> lock(*robot_mutex);
+          robot->update(now());
+          robot->handle(request, reply);
+        }
+        // a full ring means that the client stopped reading, and the reply is dropped
+        channel.reply.push(reply);
+        served = true;
+      }
+    }
+    if (!served)
+    {
+      ShmSegment::wait(layout->doorbell, layout->server_waiting, doorbell, 100000);
+    }
+  }
+}
+#endif
+
+int main(int argc, char** argv)
+{
+  std::vector<std::string> zmq_endpoints;
+  int udp_port = -1;
+  std::string shm_name;
+  bool loopback = false;
+
+  for (int i = 1; i < argc; i++)
+  {
+    std::string arg(argv[i]);
+    if (arg == "-z" && i + 1 < argc)
+    {
+      zmq_endpoints.push_back(argv[++i]);
+    }
+    else if (arg == "-u" && i + 1 < argc)
+    {
+      udp_port = std::atoi(argv[++i]);
+    }
+    else if (arg == "-s" && i + 1 < argc)
+    {
+      shm_name = argv[++i];
+    }
+    else if (arg == "-l")
+    {
+      loopback = true;
+    }
+    else
+    {
+      std::cout << "Usage: zalpha_stand_in_server [-z <zmq_endpoint>]... [-u <udp_port>] [-s <shm_name>] [-l]" << std::endl;
+      std::cout << "  Serves a simulated Zalpha AGV. Without any endpoint, it binds to tcp://*:17167 and UDP port 17167." << std::endl;
+      std::cout << "  -s  Serve the shm://<shm_name> endpoint, a shared memory segment in /dev/shm (Linux only)." << std::endl;
+      std::cout << "  -l  Loop the outputs 1 - 16 back to the inputs 1 - 16." << std::endl;
+      return 0;
+    }
+  }
+  if (zmq_endpoints.empty() && udp_port < 0 && shm_name.empty())
+  {
+    zmq_endpoints.push_back("tcp://*:17167");
+    udp_port = 17167;
+  }
+
+  std::signal(SIGINT, stop);
+  std::signal(SIGTERM, stop);
+
+  zmq::context_t context(1);
+  std::vector<zmq::socket_t*> sockets;
+  for (size_t i = 0; i < zmq_endpoints.size(); i++)
+  {
+    zmq::socket_t* socket = new zmq::socket_t(context, ZMQ_REP);
+    int linger = 0;
+    socket->setsockopt(ZMQ_LINGER, &linger, sizeof(linger));
+    try
+    {
+      socket->bind(zmq_endpoints[i].c_str());
+    }
+    catch (const zmq::error_t& ex)
+    {
+      std::cerr << "Failed to bind " << zmq_endpoints[i] << ": " << ex.what() << std::endl;
+      return 1;
+    }
+    std::cout << "Listening on " << zmq_endpoints[i] << std::endl;
+    sockets.push_back(socket);
+  }
+
+  int udp_fd = -1;
+  if (udp_port >= 0)
+  {
+    udp_fd = bindUdp(udp_port);
+    if (udp_fd < 0)
+    {
+      std::cerr << "Failed to bind UDP port " << udp_port << ": " << strerror(errno) << std::endl;
+      return 1;
+    }
+    std::cout << "Listening on udp://*:" << udp_port << std::endl;
+  }
+
+  SimRobot robot;
+  robot.setLoopback(loopback);
+  std::mutex robot_mutex;  ///< the shared memory channels are served by a thread of their own
+
+#ifdef __linux__
+  ShmSegment segment;
+  std::thread shm_thread;
+  if (!shm_name.empty())
+  {
+    if (!segment.create(shm_name))
+    {
+      std::cerr << "Failed to create " << segment.getErrorMessage() << std::endl;
+      return 1;
+    }
+    std::cout << "Listening on shm://" << shm_name << std::endl;
+    shm_thread = std::thread(serveShm, &segment, &robot, &robot_mutex);
+  }
+#else
+  if (!shm_name.empty())
+  {
+    std::cerr << "The shm:// endpoint is only available on Linux." << std::endl;
+    return 1;
+  }
+#endif
+  // sequence number and time of the last speed setpoint applied, for each UDP client
+  std::map<std::string, std::pair<uint16_t, double> > last_setpoint;
+
+  std::vector<zmq::pollitem_t> items(sockets.size() + 1);
+  for (size_t i = 0; i < sockets.size(); i++)
+  {
+    zmq::pollitem_t item = { (void*) *sockets[i], 0, ZMQ_POLLIN, 0 };
+    items[i] = item;
+  }
+  zmq::pollitem_t udp_item = { NULL, udp_fd, ZMQ_POLLIN, 0 };
+  items[sockets.size()] = udp_item;
+  size_t num_items = (udp_fd >= 0) ? items.size() : sockets.size();
+
+  while (running)
+  {
+    try
+    {
+      zmq::poll(&items[0], num_items, 10);
+    }
+    catch (const zmq::error_t& ex)
+    {
+      if (ex.num() == EINTR) continue;
+      throw;
+    }
+    std::lock_guard<std::mutex> lock(robot_mutex);
+    robot.update(now());
+
+    // every reply uses the encoding of its request
+    Packet request, reply;
+    uint8_t buffer[Codec::MAX_SIZE + 1];
+    for (size_t i = 0; i < sockets.size(); i++)
+    {
+      if (!(items[i].revents & ZMQ_POLLIN)) continue;
+
+      zmq::message_t message;
+      sockets[i]->recv(&message);
+      int encoding = Codec::encodingOf(message.size());
+      if (Codec::decode((const uint8_t*) message.data(), message.size(), request))
+      {
+        robot.handle(request, reply);
+      }
+      else
+      {
+        reply = Packet();
+        encoding = Codec::FIXED;
+      }
+      sockets[i]->send(buffer, Codec::encode(reply, encoding, buffer));
+    }
+
+    if (udp_fd >= 0 && (items[sockets.size()].revents & ZMQ_POLLIN))
+    {
+      struct sockaddr_storage from;
+      socklen_t from_len = sizeof(from);
+      ssize_t size = recvfrom(udp_fd, buffer, sizeof(buffer), 0, (struct sockaddr*) &from, &from_len);
+      if (size < 0 || !Codec::decode(buffer, size, request)) continue;
+
+      // latest wins: a setpoint overtaken by a newer one is dropped instead of being applied late,
+      // the history is forgotten after a second so that a restarted client is not mistaken for a stale one
+      if (request.command == Packet::SET_TARGET_SPEED)
+      {
+        std::string client((const char*) &from, from_len);
+        std::map<std::string, std::pair<uint16_t, double> >::iterator it = last_setpoint.find(client);
+        double time = now();
+        if (it != last_setpoint.end() && time - it->second.second < 1.0 &&
+            !isNewer(request.reserved[0], it->second.first)) continue;
+        last_setpoint[client] = std::make_pair((uint16_t) request.reserved[0], time);
+      }
+
+      robot.handle(request, reply);
+      sendto(udp_fd, buffer, Codec::encode(reply, Codec::encodingOf(size), buffer), 0,
+             (struct sockaddr*) &from, from_len);
+    }
+  }
+
+#ifdef __linux__
+  if (shm_thread.joinable())
+  {
+    shm_thread.join();
+  }
+#endif
+  for (size_t i = 0; i < sockets.size(); i++)
+  {
+    delete sockets[i];
+  }
+  if (udp_fd >= 0)
+  {
+    close(udp_fd);
+  }
+  return 0;
+}